@@ -1,13 +1,74 @@
 #include "AI.h"
+#include "Evaluation.h"
+#include "AllocationCounter.h"
 #include <cstdlib>
 #include <ctime>
 #include <algorithm>
+#include <cstring>
+#include <limits>
+
+static const int HISTORY_LIMIT = 1 << 20;   // history gets halved before it can grow past this
+
+// picks one of the symmetries in a mask, so a mirrored move gets played as often as the one searched
+static int pickSymmetry(std::uint8_t t_symmetries)
+{
+    int symmetries[NUM_SYMMETRIES];
+    int count = 0;
+    for (int symmetry = 0; symmetry < NUM_SYMMETRIES; ++symmetry)
+    {
+        if (t_symmetries & (1 << symmetry))
+        {
+            symmetries[count++] = symmetry;
+        }
+    }
+    return symmetries[rand() % count];
+}
+
+// wins and losses (fours and tablebase results) are scored by their distance from the root,
+// but a table entry can be reached from anywhere, so it keeps the distance from its own node instead
+// (pass the node's distance from the root to store, minus it to probe)
+static int shiftMateScore(int t_score, int t_plies)
+{
+    if (t_score >= TABLEBASE_WIN_SCORE - MAX_PLY)
+        return t_score + t_plies;
+    if (t_score <= -(TABLEBASE_WIN_SCORE - MAX_PLY))
+        return t_score - t_plies;
+    return t_score;
+}
 
 AI::AI() :
     m_difficulty(Difficulty::MEDIUM),
-    m_maxDepth(MAX_DEPTH_MEDIUM)
+    m_maxDepth(MAX_DEPTH_MEDIUM),
+    m_timeBudget(TIME_BUDGET_MEDIUM),
+    m_nodeBudget(0),
+    m_nodes(0),
+    m_lastDepth(0),
+    m_stopSearch(false),
+    m_useReductions(true),
+    m_useNullMove(true),
+    m_useFutility(true),
+    m_useIncrementalEval(true),
+    m_inNullSearch(false),
+    m_probeTablebase(false),
+    m_table(DEFAULT_HASH_MB),
+    m_evalCache(DEFAULT_EVAL_CACHE_KB),
+    m_threatSolver(THREAT_SOLVER_NODES, THREAT_SOLVER_THREATS),
+    m_proofSearch(PROOF_SEARCH_HASH_MB),
+    m_monteCarlo(MONTE_CARLO_TREE_MB),
+    m_engines{ ENGINE_EASY, ENGINE_MEDIUM, ENGINE_HARD },
+    m_threads(MONTE_CARLO_THREADS),
+    m_perspectiveKey(0),
+    m_rootPly(0)
 {
     srand(static_cast<unsigned>(time(nullptr)));
+
+    // big enough for any search, so filling it in never allocates
+    m_lastCheckedMoves.reserve(MAX_VISUALS);
+
+    // mapping only reads the pages a lookup touches, so this costs nothing if the book is big
+    m_book.open(DEFAULT_BOOK_FILE);
+    m_tablebase.open(DEFAULT_TABLEBASE_FILE);
+    newGame();
 }
 
 AI::~AI()
@@ -18,19 +79,36 @@ void AI::setDifficulty(Difficulty t_difficulty)
 {
     m_difficulty = t_difficulty;
     
-    // Set search depth based on difficulty
+    // Set search depth and time based on difficulty
     switch (t_difficulty)
     {
     case Difficulty::EASY:
         m_maxDepth = MAX_DEPTH_EASY;
+        m_timeBudget = TIME_BUDGET_EASY;
         break;
     case Difficulty::MEDIUM:
         m_maxDepth = MAX_DEPTH_MEDIUM;
+        m_timeBudget = TIME_BUDGET_MEDIUM;
         break;
     case Difficulty::HARD:
         m_maxDepth = MAX_DEPTH_HARD;
+        m_timeBudget = TIME_BUDGET_HARD;
         break;
     }
+    m_nodeBudget = 0;
+}
+
+void AI::newGame()
+{
+    std::memset(m_killers, 0, sizeof(m_killers));
+    std::memset(m_history, 0, sizeof(m_history));
+    m_monteCarlo.clear();
+}
+
+void AI::setSearchBudget(int t_milliseconds, std::uint64_t t_nodes)
+{
+    m_timeBudget = std::max(0, t_milliseconds);
+    m_nodeBudget = t_nodes;
 }
 
 Difficulty AI::getDifficulty() const
@@ -38,6 +116,11 @@ Difficulty AI::getDifficulty() const
     return m_difficulty;
 }
 
+void AI::setHashSize(int t_megabytes)
+{
+    m_table.resize(t_megabytes);
+}
+
 
 void AI::makeMove(Grid& t_grid)
 {
@@ -54,532 +137,832 @@ void AI::makeMove(Grid& t_grid)
 
 void AI::placePiece(Grid& t_grid)
 {
+    auto moveStart = std::chrono::steady_clock::now();
     Player currentPlayer = t_grid.getCurrentPlayer();
+    Position position = Position::fromGrid(t_grid);
 
-    // pick a piece type thats left
-    PieceType pieceType = choosePieceType(t_grid, currentPlayer);
-    t_grid.setSelectedPiece(pieceType);
+    // the book was searched far deeper than easy is meant to play
+    Move bookMove;
+    if (m_difficulty != Difficulty::EASY && m_book.probe(position, bookMove))
+    {
+        // any mirror image of the book move is just as good
+        bookMove = Symmetry::transformMove(bookMove, pickSymmetry(position.getSymmetries()));
 
-    // find an empty spot
-    std::pair<int, int> position = choosePlacementPos(t_grid);
+        m_lastCheckedMoves.clear();
+        AIVisualisation vis;
+        vis.fromRow = -1;
+        vis.fromCol = -1;
+        vis.toRow = bookMove.toRow;
+        vis.toCol = bookMove.toCol;
+        vis.score = bookMove.score;
+        vis.isSource = false;
+        m_lastCheckedMoves.push_back(vis);
+        m_nodes = 0;
+        m_lastDepth = 0;
+
+        t_grid.setSelectedPiece(bookMove.pieceType);
+        t_grid.placePiece(bookMove.toRow, bookMove.toCol);
+        return;
+    }
+
+    // a proven win takes priority over searching, easy doesnt look for one (like the book)
+    // and it only gets part of the move's time so the search still has most of it
+    Move winningMove;
+    int proofTime = (m_timeBudget > 0) ? std::max(1, m_timeBudget / PROOF_SEARCH_TIME_SHARE) : 0;
+    if (m_difficulty != Difficulty::EASY && m_proofSearch.solve(position, PROOF_SEARCH_NODES, winningMove, proofTime) == ProofResult::WIN)
+    {
+        m_lastCheckedMoves.clear();
+        AIVisualisation vis;
+        vis.fromRow = -1;
+        vis.fromCol = -1;
+        vis.toRow = winningMove.toRow;
+        vis.toCol = winningMove.toCol;
+        vis.score = WIN_SCORE;
+        vis.isSource = false;
+        m_lastCheckedMoves.push_back(vis);
+
+        t_grid.setSelectedPiece(winningMove.pieceType);
+        t_grid.placePiece(winningMove.toRow, winningMove.toCol);
+        return;
+    }
+
+    // placements are searched like any other move, on into the movement phase
+    // whatever the proof search used comes out of the search's budget
+    int budget = m_timeBudget;
+    if (budget > 0)
+    {
+        long long used = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - moveStart).count();
+        m_timeBudget = static_cast<int>(std::max<long long>(1, budget - used));
+    }
+    Move bestMove = findBestMove(position, currentPlayer);
+    m_timeBudget = budget;
 
-    // place the piece
-    t_grid.placePiece(position.first, position.second);
+    if (bestMove.toRow != -1)
+    {
+        t_grid.setSelectedPiece(bestMove.pieceType);
+        t_grid.placePiece(bestMove.toRow, bestMove.toCol);
+    }
 }
 
-PieceType AI::choosePieceType(Grid& t_grid, Player t_player)
+void AI::movePiece(Grid& t_grid)
 {
-    // Count how many of each piece type we have
-    int frogsLeft = t_grid.getRemainingPieces(t_player, PieceType::FROG);
-    int snakesLeft = t_grid.getRemainingPieces(t_player, PieceType::SNAKE);
-    int donkeysLeft = t_grid.getRemainingPieces(t_player, PieceType::DONKEY);
+    Player currentPlayer = t_grid.getCurrentPlayer();
+
+    // search a copy of the game so the grid's sprites are left alone
+    Position position = Position::fromGrid(t_grid);
+	Move bestMove = findBestMove(position, currentPlayer);//use minimax to find the best move
 
-    // save frogs/snakes for later
-    int totalPieces = frogsLeft + snakesLeft + donkeysLeft;
-    if (totalPieces >= 3 && donkeysLeft > 0)
+    if (bestMove.fromRow != -1)//if a valid move, do it
     {
-        return PieceType::DONKEY; // Use donkeys first
+        t_grid.handleClick(bestMove.fromRow, bestMove.fromCol);
+        t_grid.handleClick(bestMove.toRow, bestMove.toCol);
     }
+}
+
+CellList AI::getValidMoves(const Position& t_position, int t_fromRow, int t_fromCol)
+{
+    CellList validMoves;
 
-    // Prefer snakes for their diagonal movement
-    if (snakesLeft > 0 && totalPieces <= 2)
+    // works for either side, empty if theres no piece here
+    Bitboard targets = t_position.getMoveTargets(t_fromRow * GRID_SIZE + t_fromCol);
+    while (targets)
     {
-        return PieceType::SNAKE;
+        int square = popLowest(targets);
+        validMoves.push_back(std::make_pair(square / GRID_SIZE, square % GRID_SIZE));
     }
 
-    // Use whatever's available
-    if (frogsLeft > 0)
-        return PieceType::FROG;
-    else if (snakesLeft > 0)
-        return PieceType::SNAKE;
-    else if (donkeysLeft > 0)
-        return PieceType::DONKEY;
-
-    return PieceType::FROG; // fallback
+    return validMoves;
 }
 
-std::pair<int, int> AI::choosePlacementPos(Grid& t_grid)
+TablebaseResult AI::getRootMoves(Position& t_position, Player t_player, MoveList& t_moves)
 {
-    // Clear previous visuals
-    m_lastCheckedMoves.clear();
-    
-    // find all empty cells
-    std::vector<std::pair<int, int>> emptyCells;
+    getAllPossibleMoves(t_position, t_player, t_moves);//gets all possible moves
 
-    for (int row = 0; row < GRID_SIZE; ++row)
+    // a move and its mirror image score the same on a symmetric board, only search one of them
+    std::uint8_t symmetries = t_position.getSymmetries();
+    if (symmetries != 1)
     {
-        for (int col = 0; col < GRID_SIZE; ++col)
+        int kept = 0;
+        for (const Move& move : t_moves)
         {
-            if (t_grid.isCellEmpty(row, col)) 
-            {
-                emptyCells.push_back({ row, col });
-            }
+            if (Symmetry::isFirstOfItsKind(move, symmetries))
+                t_moves[kept++] = move;
         }
+        t_moves.shrink(kept);
     }
-    
-    Player opponent = (t_grid.getCurrentPlayer() == Player::PLAYER_ONE)
-        ? Player::PLAYER_TWO
-        : Player::PLAYER_ONE;
 
-    // BLOCK opponent winning placement
-    for (auto cell : emptyCells)
+    if (m_difficulty != Difficulty::HARD)
     {
-        if (doesMoveCauseWin(t_grid, cell.first, cell.second, opponent))
-        {
-            // Add blocking move to visuals
-            AIVisualisation vis;
-            vis.fromRow = -1; // Placement has no source
-            vis.fromCol = -1;
-            vis.toRow = cell.first;
-            vis.toCol = cell.second;
-            vis.score = 9000; // High score for blocking
-            vis.isSource = false;
-            m_lastCheckedMoves.push_back(vis);
-            
-            return cell; // place here to block
-        }
+        return TablebaseResult::MISSING;
     }
+    return keepTablebaseMoves(t_position, t_moves);
+}
 
-    // Try to form our own winning line
-    for (auto cell : emptyCells)
+bool AI::findThreatWin(Position& t_position, Move& t_move)
+{
+    if (!m_threatSolver.findWin(t_position, t_move))
     {
-        if (doesMoveCauseWin(t_grid, cell.first, cell.second, t_grid.getCurrentPlayer()))
-        {
-            // Add winning move to visuals
-            AIVisualisation vis;
-            vis.fromRow = -1;
-            vis.fromCol = -1;
-            vis.toRow = cell.first;
-            vis.toCol = cell.second;
-            vis.score = 10000; // Highest score for winning
-            vis.isSource = false;
-            m_lastCheckedMoves.push_back(vis);
-            
-            return cell; // place aggressively
-        }
+        return false;
     }
 
-    // Evaluate all empty positions and pick the best one
-    int bestScore = -10000;
-    std::vector<std::pair<int, int>> bestScores; // Store moves with similar scores
-    std::vector<std::pair<std::pair<int, int>, int>> scoredCells; // Store all checked cells with scores
+    AIVisualisation vis;
+    vis.fromRow = t_move.fromRow;
+    vis.fromCol = t_move.fromCol;
+    vis.toRow = t_move.toRow;
+    vis.toCol = t_move.toCol;
+    vis.score = WIN_SCORE;
+    vis.isSource = true;
+    m_lastCheckedMoves.push_back(vis);
+    m_nodes = m_threatSolver.getNodes();
+    return true;
+}
 
-    for (auto cell : emptyCells)
+Move AI::findBestMove(Position& t_position, Player t_player)
+{
+    // the tree search starts threads and grows its tree, so it cant go under the scope below
+    if (m_engines[static_cast<int>(m_difficulty)] == SearchEngine::MONTE_CARLO)
     {
-        int score = 0;
-        
-        // Prioritise center positions
-        int centerDist = abs(cell.first - 2) + abs(cell.second - 2);
-        score += (8 - centerDist) * 10;
-        
-        // Bonus point for positions near existing pieces
-        int adjacentFriendly = 0;
-        int adjacentEmpty = 0;
-        
-        for (int dr = -1; dr <= 1; ++dr)
-        {
-            for (int dc = -1; dc <= 1; ++dc)
-            {
-                if (dr == 0 && dc == 0) continue;
-                
-                int newRow = cell.first + dr;
-                int newCol = cell.second + dc;
-                
-                if (newRow >= 0 && newRow < GRID_SIZE && newCol >= 0 && newCol < GRID_SIZE)
-                {
-                    if (t_grid.getCellOwner(newRow, newCol) == t_grid.getCurrentPlayer())
-                        adjacentFriendly++;
-                    else if (t_grid.isCellEmpty(newRow, newCol))
-                        adjacentEmpty++;
-                }
-            }
-        }
-        
-        score += adjacentFriendly * 15; // Connect with our other pieces
-        score += adjacentEmpty * 5;
-        
-        // Add small random change to avoid the same start every time
-        score += (rand() % 21) - 10;
-        
-        // Store cell with score
-        scoredCells.push_back({cell, score});
-        
-        if (score > bestScore)
-        {
-            bestScore = score;
-            bestScores.clear();
-            bestScores.push_back(cell);
-        }
-        else if (score >= bestScore - 15) // Accept moves within 15 points of best
-        {
-            bestScores.push_back(cell);
-        }
+        return findBestMoveMonteCarlo(t_position, t_player);
     }
+
+    // nothing in here or the search under it should touch the heap
+    NoAllocationScope noAllocations;
+
+    // a solved table knows the result, the search only has to pick a move that keeps it
+    // (looking up the positions below would then give every move the same score and
+    // the search would never get any closer to the four, so that is only for positions
+    // the table doesnt cover, like placements that lead into the movement phase)
+    MoveList allMoves;
+    std::uint8_t symmetries = t_position.getSymmetries();
+    m_probeTablebase = getRootMoves(t_position, t_player, allMoves) == TablebaseResult::MISSING && m_difficulty == Difficulty::HARD && m_tablebase.isOpen();
     
-    // Add top scored cells to visuals
-    std::sort(scoredCells.begin(), scoredCells.end(), 
-        [](const auto& a, const auto& b) { return a.second > b.second; });
-    
-    int visualizeCount = std::min(static_cast<int>(scoredCells.size()), 15);
-    for (int i = 0; i < visualizeCount; ++i)
+    // Clear previous visuals
+    m_lastCheckedMoves.clear();
+    m_nodes = 0;
+    m_lastDepth = 0;
+
+    if (allMoves.empty())
     {
-        AIVisualisation vis;
-        vis.fromRow = -1; // Placement has no source piece
-        vis.fromCol = -1;
-        vis.toRow = scoredCells[i].first.first;
-        vis.toCol = scoredCells[i].first.second;
-        vis.score = scoredCells[i].second;
-        vis.isSource = false;
-        m_lastCheckedMoves.push_back(vis);
+		return { -1, -1, -1, -1, 0 };//none available
     }
 
-    // Randomly pick from the best moves to add variety
-    if (!bestScores.empty())
+    // a forced win made of threats is cheap to find and needs no searching
+    Move winningMove;
+    if (findThreatWin(t_position, winningMove))
     {
-        int randomIndex = rand() % bestScores.size();
-        return bestScores[randomIndex];
+        return winningMove;
     }
 
-    return emptyCells[0]; // Fallback
-}
+    // scores are from our side, so keep them apart from searches as the other player
+    // (and apart from searches that scored positions by the tablebase, those would stop this one finding the four)
+    m_perspectiveKey = (t_player == Player::PLAYER_TWO) ? Zobrist::PERSPECTIVE_KEY : 0;
+    if (m_probeTablebase)
+        m_perspectiveKey ^= Zobrist::TABLEBASE_KEY;
+    m_table.newSearch();
+    m_table.resetStats();
+    m_evalCache.resetStats();
+    m_stopSearch = false;
+    m_inNullSearch = false;
+    m_rootPly = t_position.getPly();
+    m_searchStart = std::chrono::steady_clock::now();
+    ageOrdering();
+
+    // try whatever was best here last time first
+    // mirror images share one entry, its move is stored turned to the canonical board
+    int rootSymmetry;
+    std::uint64_t rootKey = t_position.getCanonicalKey(rootSymmetry) ^ m_perspectiveKey;
+    TTEntry rootEntry;
+    std::uint16_t rootMove = m_table.probe(rootKey, rootEntry) ? Symmetry::transformPackedMove(rootEntry.move, INVERSE_SYMMETRY[rootSymmetry]) : 0;
+
+    orderMoves(allMoves, t_position, t_player, rootMove, 0); // Order moves before evaluation
+
+    Move bestMove = allMoves[0];
+    MoveList topMoves; // Store moves with similar scores
+    
+    for (int depth = 1; depth <= m_maxDepth; ++depth)//deepen one move at a time
+    {
+        Move iterationBest = allMoves[0];
+        MoveList iterationTop;
+        FixedList<AIVisualisation, MAX_VISUALS> iterationVisuals;
+
+        // expect about the same score as last time, widen if that guess was wrong
+        int alpha = std::numeric_limits<int>::min();
+        int beta = std::numeric_limits<int>::max();
+        if (depth > 1 && bestMove.score < WIN_SCORE && bestMove.score > LOSE_SCORE)
+        {
+            alpha = bestMove.score - ASPIRATION_WINDOW;
+            beta = bestMove.score + ASPIRATION_WINDOW;
+        }
 
+        while (true)
+        {
+            iterationBest.score = std::numeric_limits<int>::min();
+            iterationTop.clear();
+            iterationVisuals.clear();
 
+            for (int i = 0; i < allMoves.size(); ++i)
+            {
+                Move& move = allMoves[i];
 
-void AI::movePiece(Grid& t_grid)
-{
-    Player currentPlayer = t_grid.getCurrentPlayer();
+                // chance the move
+                t_position.make(move);
 
-	Move bestMove = findBestMove(t_grid, currentPlayer);//use minimax to find the best move
+                // Check if this move wins the game
+                if (t_position.getGameState() == GameState::GAME_OVER && t_position.getWinner() == t_player)
+                {
+                    t_position.unmake();
+
+                    // Add winning move to visuals
+                    AIVisualisation vis;
+                    vis.fromRow = move.fromRow;
+                    vis.fromCol = move.fromCol;
+                    vis.toRow = move.toRow;
+                    vis.toCol = move.toCol;
+                    vis.score = WIN_SCORE;
+                    vis.isSource = true;
+                    m_lastCheckedMoves.clear();
+                    m_lastCheckedMoves.push_back(vis);
+                    m_lastDepth = depth;
+
+                    return move;
+                }
 
-    if (bestMove.fromRow != -1)//if a valid move, do it
-    {
-        t_grid.handleClick(bestMove.fromRow, bestMove.fromCol);
-        t_grid.handleClick(bestMove.toRow, bestMove.toCol);
-    }
-}
+                // use minimax to check how good the move is
+                int score;
+                if (i == 0)
+                {
+                    score = minimax(t_position, depth - 1, false, t_player, alpha, beta);
+                }
+                else
+                {
+                    // only need to know if it can match the best so far (matching counts, for the random pick)
+                    int floor = std::max(alpha, iterationBest.score - 1);
+                    score = minimax(t_position, depth - 1, false, t_player, floor, floor + 1);
+                    if (score > floor && score < beta && !m_stopSearch)
+                    {
+                        score = minimax(t_position, depth - 1, false, t_player, floor, beta);
+                    }
+                }
 
-std::pair<int, int> AI::chooseRandomPiece(Grid& t_grid, Player t_player)//not used at the minute
-{
-    // find all our pieces
-    std::vector<std::pair<int, int>> ourPieces;
+                // undo the move to check the next
+                t_position.unmake();
 
-    for (int row = 0; row < GRID_SIZE; ++row)
-    {
-        for (int col = 0; col < GRID_SIZE; ++col)
+                if (m_stopSearch)//out of time, this iteration is thrown away
+                    break;
+
+                move.score = score;
+
+                // moves that cant match the best only get an upper bound here
+                // placements of different pieces share a cell, so only the first one searched is shown
+                bool shown = iterationVisuals.size() == MAX_VISUALS;
+                for (int v = 0; v < iterationVisuals.size() && move.fromRow == -1 && !shown; ++v)
+                {
+                    shown = iterationVisuals[v].toRow == move.toRow && iterationVisuals[v].toCol == move.toCol;
+                }
+
+                if (!shown)
+                {
+                    AIVisualisation vis;
+                    vis.fromRow = move.fromRow;
+                    vis.fromCol = move.fromCol;
+                    vis.toRow = move.toRow;
+                    vis.toCol = move.toCol;
+                    vis.score = score;
+                    vis.isSource = (i == 0); // Mark first as source
+                    iterationVisuals.push_back(vis);
+                }
+
+                if (score > iterationBest.score)
+                {
+                    iterationBest = move;
+                    iterationTop.clear();
+                    iterationTop.push_back(move);
+                }
+                else if (score == iterationBest.score)
+                {
+                    // If scores are equal, add to candidates for random selection
+                    iterationTop.push_back(move);
+                }
+
+                if (score >= beta)//better than the window allows, have to widen it anyway
+                    break;
+            }
+
+            if (m_stopSearch)
+                break;
+
+            // outside the aspiration window means the score is only a bound, search again with that side open
+            if (iterationBest.score <= alpha && alpha != std::numeric_limits<int>::min())
+                alpha = std::numeric_limits<int>::min();
+            else if (iterationBest.score >= beta && beta != std::numeric_limits<int>::max())
+                beta = std::numeric_limits<int>::max();
+            else
+                break;
+        }
+
+        if (m_stopSearch)
+            break;
+
+        // iteration finished, so its answer replaces the last one
+        bestMove = iterationBest;
+        topMoves = iterationTop;
+        m_lastCheckedMoves.assign(iterationVisuals.begin(), iterationVisuals.end());
+        m_lastDepth = depth;
+
+        // root was searched with the full window so its score is exact
+        m_table.store(rootKey, bestMove.score, depth, Bound::EXACT, Symmetry::transformPackedMove(packMove(bestMove), rootSymmetry));
+
+        // a forced result wont change by looking deeper
+        if (bestMove.score >= WIN_SCORE || bestMove.score <= LOSE_SCORE)
+            break;
+
+        // the next iteration takes longer than all of the ones so far, so dont start what cant finish
+        if (m_timeBudget > 0 && getElapsedMs() * 2 > m_timeBudget)
+            break;
+
+        // search the best move first next time round
+        for (int i = 0; i < allMoves.size(); ++i)
         {
-            // check if this cell has our piece
-            std::vector<std::pair<int, int>> moves = getValidMoves(t_grid, row, col);
-            if (!moves.empty())
+            if (packMove(allMoves[i]) == packMove(bestMove))
             {
-                ourPieces.push_back(std::make_pair(row, col));
+                std::rotate(allMoves.begin(), allMoves.begin() + i, allMoves.begin() + i + 1);
+                break;
             }
         }
     }
 
-    if (!ourPieces.empty())
+    // Randomly select from top moves to add variety
+    if (!topMoves.empty())
     {
-        int randomIndex = rand() % ourPieces.size();
-        return ourPieces[randomIndex];
+        int randomIndex = rand() % topMoves.size();
+        return Symmetry::transformMove(topMoves[randomIndex], pickSymmetry(symmetries));
     }
 
-    return std::make_pair(-1, -1); // no pieces found
+    return bestMove;
 }
 
-std::pair<int, int> AI::chooseRandomMove(Grid& t_grid, int t_fromRow, int t_fromCol)//also not used anymore
+Move AI::findBestMoveMonteCarlo(Position& t_position, Player t_player)
 {
-    std::vector<std::pair<int, int>> validMoves = getValidMoves(t_grid, t_fromRow, t_fromCol);
+    MoveList allMoves;
+    getRootMoves(t_position, t_player, allMoves);
+
+    m_lastCheckedMoves.clear();
+    m_nodes = 0;
+    m_lastDepth = 0;
+
+    if (allMoves.empty())
+    {
+        return { -1, -1, -1, -1, 0 };
+    }
+
+    Move winningMove;
+    if (findThreatWin(t_position, winningMove))
+    {
+        return winningMove;
+    }
 
-    if (!validMoves.empty())
+    // a single move left (say the table only keeps one) isnt worth any playouts
+    if (allMoves.size() == 1)
     {
-        int randomIndex = rand() % validMoves.size();
-        return validMoves[randomIndex];
+        return allMoves[0];
     }
 
-    return std::make_pair(-1, -1);
+    Move bestMove = m_monteCarlo.search(t_position, allMoves, m_timeBudget, m_nodeBudget, m_threads);
+    m_monteCarlo.getVisuals(m_lastCheckedMoves, MAX_VISUALS);
+    m_nodes = m_monteCarlo.getPlayouts();
+    m_lastDepth = m_monteCarlo.getMaxDepth();
+
+    // no mirroring here, the next search only finds this tree again if the board played is the one it grew from
+    return bestMove;
 }
 
-bool AI::isCellEmpty(Grid& t_grid, int t_row, int t_col) const//checks if the cell is empty
+long long AI::getElapsedMs() const
 {
-    return t_grid.isCellEmpty(t_row, t_col);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_searchStart).count();
 }
 
-std::vector<std::pair<int, int>> AI::getValidMoves(Grid& t_grid, int t_fromRow, int t_fromCol)
+void AI::countNode()
 {
-    std::vector<std::pair<int, int>> validMoves;
+    m_nodes++;
 
-    // check if the cell belongs to current player 
-    Player currentPlayer = t_grid.getCurrentPlayer();
-    Player cellOwner = t_grid.getCellOwner(t_fromRow, t_fromCol);
+    // first iteration has to finish or there is nothing to play
+    if (m_lastDepth == 0)
+        return;
 
-    if (cellOwner != currentPlayer)
+    if (m_nodeBudget > 0 && m_nodes >= m_nodeBudget)
     {
-        return validMoves; // not our piece
+        m_stopSearch = true;
     }
-
-    // try every cell on the board to check for possible moves
-    for (int row = 0; row < GRID_SIZE; ++row)
+    // reading the clock every node is slow, every 1024 is plenty
+    else if (m_timeBudget > 0 && (m_nodes & 1023) == 0 && getElapsedMs() >= m_timeBudget)
     {
-        for (int col = 0; col < GRID_SIZE; ++col)
-        {
-            if (t_grid.canPieceMoveTo(t_fromRow, t_fromCol, row, col))
-            {
-                validMoves.push_back(std::make_pair(row, col));
-            }
-        }
+        m_stopSearch = true;
     }
-
-    return validMoves;
 }
 
-AI::Move AI::findBestMove(Grid& t_grid, Player t_player)
+int AI::minimax(Position& t_position, int t_depth, bool t_isMaximizing, Player t_aiPlayer, int t_alpha, int t_beta)
 {
-    std::vector<Move> allMoves = getAllPossibleMoves(t_grid, t_player);//gets all possible moves
-    
-    // Clear previous visuals
-    m_lastCheckedMoves.clear();
+    countNode();
+    if (m_stopSearch)
+        return 0;
 
-    if (allMoves.empty())
+    if (t_position.getGameState() == GameState::GAME_OVER)
     {
-		return { -1, -1, -1, -1, 0 };//none available
+        Player winner = t_position.getWinner();
+        int distance = t_position.getPly() - m_rootPly;
+        if (winner == t_aiPlayer)
+            return WIN_SCORE + MAX_PLY - distance;  // closer = faster win
+        else if (winner != Player::NONE)
+            return LOSE_SCORE - MAX_PLY + distance;  // lower loss score by taking longer to lose
+        else
+            return 0;  // Tie
     }
 
-    Move bestMove = allMoves[0];//sets the best move as the first
-    bestMove.score = std::numeric_limits<int>::min();
+    // a solved position needs no searching, scored under any four the search finds itself so those still come first
+    if (m_probeTablebase && t_position.getGameState() == GameState::MOVEMENT)
+    {
+        TablebaseResult result = m_tablebase.probe(t_position);
+        if (result == TablebaseResult::DRAW)
+            return 0;
+        if (result != TablebaseResult::MISSING)
+        {
+            int score = TABLEBASE_WIN_SCORE - (t_position.getPly() - m_rootPly);  // sooner is better, like a real four
+            bool ours = t_position.getSideToMove() == t_aiPlayer;
+            return (ours == (result == TablebaseResult::WIN)) ? score : -score;
+        }
+    }
 
-    orderMoves(allMoves, t_grid, t_player); // Order moves before evaluation
+	if (t_depth == 0)//if its gone to the depth, settle any threats then evaluate the board
+    {
+        return quiescence(t_position, t_isMaximizing, t_aiPlayer, t_alpha, t_beta, 0);
+    }
 
-    std::vector<Move> topMoves; // Store moves with similar scores
-    
-    // keep visuals at top moves
-    int movesToVisualize = std::min(static_cast<int>(allMoves.size()), 15);
-    
-    for (int i = 0; i < movesToVisualize; ++i)//try top moves
+    // seen this position before? use the stored result if it was searched deep enough
+    int symmetry;
+    std::uint64_t key = t_position.getCanonicalKey(symmetry) ^ m_perspectiveKey;
+    int distance = t_position.getPly() - m_rootPly;
+    TTEntry entry;
+    std::uint16_t tableMove = 0;
+    if (m_table.probe(key, entry))
     {
-        Move& move = allMoves[i];
-        
-		// keep what was in the target cell
-        PieceType capturedType = t_grid.getPieceType(move.toRow, move.toCol);
-        Player capturedOwner = t_grid.getCellOwner(move.toRow, move.toCol);
+        tableMove = Symmetry::transformPackedMove(entry.move, INVERSE_SYMMETRY[symmetry]);
+        if (entry.depth >= t_depth)
+        {
+            int tableScore = shiftMateScore(entry.score, -distance);
+            if (entry.getBound() == Bound::EXACT)
+            {
+                m_table.recordCutoff();
+                return tableScore;
+            }
+            if (entry.getBound() == Bound::LOWER)
+                t_alpha = std::max(t_alpha, tableScore);
+            else if (entry.getBound() == Bound::UPPER)
+                t_beta = std::min(t_beta, tableScore);
 
-        // chance the move
-        testMove(t_grid, move);
+            if (t_beta <= t_alpha)
+            {
+                m_table.recordCutoff();
+                return tableScore;
+            }
+        }
+    }
+
+    Player currentPlayer = t_position.getSideToMove();//moves for whichever player
+    Player opponent = (currentPlayer == Player::PLAYER_ONE) ? Player::PLAYER_TWO : Player::PLAYER_ONE;
+    int ply = t_position.getPly();
 
-        // Check if this move wins the game
-        if (t_grid.getGameState() == GameState::GAME_OVER && t_grid.getWinner() == t_player)
+    // facing a three means the next move is forced, so nothing gets pruned or cut short
+    ThreatMap threats = t_position.getThreatMap();
+    Bitboard ownThreats = threats.getFours(currentPlayer);
+    Bitboard opponentThreats = threats.getFours(opponent);
+    bool threatened = opponentThreats != 0;
+
+    // null move: if passing still leaves us past the window, a real move will too
+    // (not while placing, a pass there leaves one side a piece ahead when placement should be over)
+    if (m_useNullMove && !m_inNullSearch && t_position.getGameState() == GameState::MOVEMENT && !threatened && !holdsBlock(t_position, currentPlayer) && ply > 0 && t_depth > NULL_MOVE_REDUCTION)
+    {
+        int staticEval = evaluateBoard(t_position, t_aiPlayer);
+        if (t_isMaximizing ? staticEval >= t_beta : staticEval <= t_alpha)
         {
-            undoMove(t_grid, move, capturedType, capturedOwner);
-            
-            // Add winning move to visuals
-            AIVisualisation vis;
-            vis.fromRow = move.fromRow;
-            vis.fromCol = move.fromCol;
-            vis.toRow = move.toRow;
-            vis.toCol = move.toCol;
-            vis.score = WIN_SCORE;
-            vis.isSource = true;
-            m_lastCheckedMoves.push_back(vis);
-            
-            return move;
+            m_inNullSearch = true;
+            t_position.makeNull();
+            int eval = t_isMaximizing
+                ? minimax(t_position, t_depth - 1 - NULL_MOVE_REDUCTION, false, t_aiPlayer, t_beta - 1, t_beta)
+                : minimax(t_position, t_depth - 1 - NULL_MOVE_REDUCTION, true, t_aiPlayer, t_alpha, t_alpha + 1);
+            t_position.unmakeNull();
+            m_inNullSearch = false;
+            if (m_stopSearch)
+                return 0;
+
+            // dont trust a win or loss found after a pass, just the bound
+            if (t_isMaximizing && eval >= t_beta)
+                return (eval >= WIN_SCORE) ? t_beta : eval;
+            if (!t_isMaximizing && eval <= t_alpha)
+                return (eval <= LOSE_SCORE) ? t_alpha : eval;
         }
+    }
 
-        // use minimax to check how good the move is
-        int score = minimax(t_grid, m_maxDepth - 1, false, t_player, std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
-        move.score = score;
+    // futility: one move from the horizon, a quiet move cant make up more than the margin
+    bool futile = false;
+    int futilityEval = 0;
+    if (m_useFutility && t_depth == 1 && !threatened)
+    {
+        futilityEval = evaluateBoard(t_position, t_aiPlayer);
+        futile = t_isMaximizing ? futilityEval + FUTILITY_MARGIN <= t_alpha : futilityEval - FUTILITY_MARGIN >= t_beta;
+    }
 
-        // undo the move to check the next
-        undoMove(t_grid, move, capturedType, capturedOwner);
-        
-        // Add to visuals
-        AIVisualisation vis;
-        vis.fromRow = move.fromRow;
-        vis.fromCol = move.fromCol;
-        vis.toRow = move.toRow;
-        vis.toCol = move.toCol;
-        vis.score = score;
-        vis.isSource = (i == 0); // Mark first as source
-        m_lastCheckedMoves.push_back(vis);
+    // moves come out best guess first and only get generated when needed
+    MovePicker picker(t_position, tableMove, m_killers[ply], m_history[(currentPlayer == Player::PLAYER_ONE) ? 0 : 1]);
+
+    int alphaStart = t_alpha;
+    int betaStart = t_beta;
+    int bestEval = t_isMaximizing ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+    Move bestMove = { -1, -1, -1, -1, 0 };
+    bool first = true;
+    int moveCount = 0;
+    Move move;
 
-        if (score > bestMove.score)
+    while (picker.next(move))
+    {
+        t_position.make(move);//chance the move
+        moveCount++;
+
+        // quiet means it doesnt make or break a three for either side
+        bool quiet = false;
+        if (!first && picker.isLastMoveQuiet() && (futile || m_useReductions))
         {
-            bestMove = move;
-            topMoves.clear();
-            topMoves.push_back(move);
+            ThreatMap after = t_position.getThreatMap();
+            quiet = after.getFours(currentPlayer) == ownThreats && after.getFours(opponent) == opponentThreats;
         }
-        else if (score == bestMove.score)
+
+        if (futile && quiet)
         {
-            // If scores are equal, add to candidates for random selection
-            topMoves.push_back(move);
+            // skipped moves could still be worth up to the margin, so the bound has to cover them
+            t_position.unmake();
+            if (t_isMaximizing)
+                bestEval = std::max(bestEval, futilityEval + FUTILITY_MARGIN);
+            else
+                bestEval = std::min(bestEval, futilityEval - FUTILITY_MARGIN);
+            continue;
         }
-    }
-    
-    // check remaining moves without visuals
-    for (int i = movesToVisualize; i < allMoves.size(); ++i)
-    {
-        Move& move = allMoves[i];
-        PieceType capturedType = t_grid.getPieceType(move.toRow, move.toCol);
-        Player capturedOwner = t_grid.getCellOwner(move.toRow, move.toCol);
 
-        testMove(t_grid, move);
-        
-        if (t_grid.getGameState() == GameState::GAME_OVER && t_grid.getWinner() == t_player)
+        int eval;
+        if (first)
         {
-            undoMove(t_grid, move, capturedType, capturedOwner);
-            return move;
+            eval = minimax(t_position, t_depth - 1, !t_isMaximizing, t_aiPlayer, t_alpha, t_beta);
         }
+        else
+        {
+            // late quiet moves are unlikely to be best, so look at them shallower first
+            int reduction = 0;
+            if (m_useReductions && quiet && !threatened && t_depth >= 3 && moveCount > LATE_MOVE_INDEX)
+            {
+                reduction = (t_depth >= 5 && moveCount > 2 * LATE_MOVE_INDEX) ? 2 : 1;
+            }
 
-        int score = minimax(t_grid, m_maxDepth - 1, false, t_player, std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
-        move.score = score;
-        undoMove(t_grid, move, capturedType, capturedOwner);
+            if (t_isMaximizing)
+            {
+                // first move is probably best, so just check the rest cant beat it
+                eval = minimax(t_position, t_depth - 1 - reduction, false, t_aiPlayer, t_alpha, t_alpha + 1);
+                if (reduction > 0 && eval > t_alpha && !m_stopSearch)
+                {
+                    eval = minimax(t_position, t_depth - 1, false, t_aiPlayer, t_alpha, t_alpha + 1);
+                }
+                if (eval > t_alpha && eval < t_beta && !m_stopSearch)
+                {
+                    eval = minimax(t_position, t_depth - 1, false, t_aiPlayer, t_alpha, t_beta);
+                }
+            }
+            else
+            {
+                // same again, just check the rest cant go under it
+                eval = minimax(t_position, t_depth - 1 - reduction, true, t_aiPlayer, t_beta - 1, t_beta);
+                if (reduction > 0 && eval < t_beta && !m_stopSearch)
+                {
+                    eval = minimax(t_position, t_depth - 1, true, t_aiPlayer, t_beta - 1, t_beta);
+                }
+                if (eval < t_beta && eval > t_alpha && !m_stopSearch)
+                {
+                    eval = minimax(t_position, t_depth - 1, true, t_aiPlayer, t_alpha, t_beta);
+                }
+            }
+        }
+        t_position.unmake();
+        if (m_stopSearch)
+            return 0;
 
-        if (score > bestMove.score)
+        if (first || (t_isMaximizing ? eval > bestEval : eval < bestEval))
         {
+            bestEval = eval;
             bestMove = move;
-            topMoves.clear();
-            topMoves.push_back(move);
         }
-        else if (score == bestMove.score)
+        first = false;
+
+        if (t_isMaximizing)//go for the highest score for ai
+            t_alpha = std::max(t_alpha, eval);
+        else//minimizing, checks for lowest score for opponent
+            t_beta = std::min(t_beta, eval);
+
+        if (t_beta <= t_alpha)//skips checking rest of the moves after cutoff
         {
-            topMoves.push_back(move);
+            recordCutoff(move, currentPlayer, ply, t_depth);
+            break;
         }
     }
 
-    // Randomly select from top moves to add variety
-    if (!topMoves.empty())
+    if (first)//no moves at all
     {
-        int randomIndex = rand() % topMoves.size();
-        return topMoves[randomIndex];
+        return evaluateBoard(t_position, t_aiPlayer);
     }
 
-    return bestMove;
+    // remember the result for next time
+    Bound bound = Bound::EXACT;
+    if (bestEval <= alphaStart)
+        bound = Bound::UPPER;
+    else if (bestEval >= betaStart)
+        bound = Bound::LOWER;
+    m_table.store(key, shiftMateScore(bestEval, distance), t_depth, bound, Symmetry::transformPackedMove(packMove(bestMove), symmetry));
+
+    return bestEval;
 }
 
-int AI::minimax(Grid& t_grid, int t_depth, bool t_isMaximizing, Player t_aiPlayer, int t_alpha, int t_beta)
+int AI::quiescence(Position& t_position, bool t_isMaximizing, Player t_aiPlayer, int t_alpha, int t_beta, int t_ply)
 {
-    if (t_grid.getGameState() == GameState::GAME_OVER)
+    countNode();
+    if (m_stopSearch)
+        return 0;
+
+    if (t_position.getGameState() == GameState::GAME_OVER)
     {
-        Player winner = t_grid.getWinner();
+        // scored like minimax does, so a four found past the horizon still ranks by how soon it comes
+        Player winner = t_position.getWinner();
+        int distance = t_position.getPly() - m_rootPly;
         if (winner == t_aiPlayer)
-            return WIN_SCORE + t_depth;  // high depth = faster win
+            return WIN_SCORE + MAX_PLY - distance;
         else if (winner != Player::NONE)
-            return LOSE_SCORE - t_depth;  // lower loss score by taking longer to lose
+            return LOSE_SCORE - MAX_PLY + distance;
         else
-            return 0;  // Tie
+            return 0;
     }
 
-	if (t_depth == 0)//if its gone to the depth, evaluate the board
+    int standPat = evaluateBoard(t_position, t_aiPlayer);
+    if (t_ply >= MAX_QUIESCENCE_PLY)
     {
-        return evaluateBoard(t_grid, t_aiPlayer);
+        return standPat;
     }
 
-    Player currentPlayer = t_grid.getCurrentPlayer();//get all moves for whichever player
-    std::vector<Move> moves = getAllPossibleMoves(t_grid, currentPlayer);
+    Player currentPlayer = t_position.getSideToMove();
+    Player opponent = (currentPlayer == Player::PLAYER_ONE) ? Player::PLAYER_TWO : Player::PLAYER_ONE;
 
-    if (moves.empty())
+    // if they can finish a four next move we have to win first or block, so no standing pat
+    bool threatened = t_position.canCompleteFour(opponent);
+    int bestEval;
+    if (threatened)
     {
-        return evaluateBoard(t_grid, t_aiPlayer);
+        bestEval = t_isMaximizing ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
     }
-
-    // Order moves for better pruning
-    orderMoves(moves, t_grid, currentPlayer);
-
-    if (t_isMaximizing)//go for the highest score for ai
+    else
     {
-        int maxEval = std::numeric_limits<int>::min();
-
-        for (const Move& move : moves)
+        bestEval = standPat;
+        if (t_isMaximizing)
         {
-            PieceType capturedType = t_grid.getPieceType(move.toRow, move.toCol);//saves target cell info
-            Player capturedOwner = t_grid.getCellOwner(move.toRow, move.toCol);
+            if (standPat >= t_beta)
+                return standPat;
+            t_alpha = std::max(t_alpha, standPat);
+        }
+        else
+        {
+            if (standPat <= t_alpha)
+                return standPat;
+            t_beta = std::min(t_beta, standPat);
+        }
+    }
 
-            testMove(t_grid, move);//chance the move
-            int eval = minimax(t_grid, t_depth - 1, false, t_aiPlayer, t_alpha, t_beta);
-            undoMove(t_grid, move, capturedType, capturedOwner);
+    // only moves that finish a four or block one, unless we are threatened
+    // (a jump four can also be stopped by moving into or out of the run, so every move gets a look)
+    static const std::uint16_t noKillers[2] = { 0, 0 };
+    MovePicker picker(t_position, 0, noKillers, m_history[(currentPlayer == Player::PLAYER_ONE) ? 0 : 1]);
+    if (!threatened)
+        picker.skipQuietMoves();
 
-            maxEval = std::max(maxEval, eval);
+    bool searched = false;
+    Move move;
+    while (picker.next(move))
+    {
+        t_position.make(move);
+        int eval = quiescence(t_position, !t_isMaximizing, t_aiPlayer, t_alpha, t_beta, t_ply + 1);
+        t_position.unmake();
+        if (m_stopSearch)
+            return 0;
+        searched = true;
+
+        if (t_isMaximizing)
+        {
+            bestEval = std::max(bestEval, eval);
             t_alpha = std::max(t_alpha, eval);
-            if (t_beta <= t_alpha)//skips checking rest of the moves after cutoff
-                break;
         }
-        return maxEval;
+        else
+        {
+            bestEval = std::min(bestEval, eval);
+            t_beta = std::min(t_beta, eval);
+        }
+        if (t_beta <= t_alpha)
+            break;
     }
-    else//minimizing, checks for lowest score for opponent
+
+    if (!searched)//no moves at all
     {
-        int minEval = std::numeric_limits<int>::max();
-        for (const Move& move : moves)
-        {
-            PieceType capturedType = t_grid.getPieceType(move.toRow, move.toCol);
-            Player capturedOwner = t_grid.getCellOwner(move.toRow, move.toCol);
+        return standPat;
+    }
 
-            testMove(t_grid, move);
-            int eval = minimax(t_grid, t_depth - 1, true, t_aiPlayer, t_alpha, t_beta);
-            undoMove(t_grid, move, capturedType, capturedOwner);
+    return bestEval;
+}
 
-            minEval = std::min(minEval, eval);
-            t_beta = std::min(t_beta, eval);
-            if (t_beta <= t_alpha)
-                break;
+bool AI::holdsBlock(const Position& t_position, Player t_player)
+{
+    Bitboard own = t_position.getPlayerMask(t_player);
+    Bitboard opponent = t_position.getOccupiedMask() & ~own;
+    for (Bitboard line : WIN_LINES)
+    {
+        if (popCount(opponent & line) == LINE_LENGTH - 1 && (own & line))
+        {
+            return true;
         }
-        return minEval;
     }
+    return false;
 }
 
-bool AI::doesMoveCauseWin(Grid& t_grid, int row, int col, Player player)
+int AI::evaluateBoard(const Position& t_position, Player t_aiPlayer)
 {
-    // Temporarily place a piece
-    PieceType temp = PieceType::DONKEY; // type doesn't matter for win check
-    Player oldOwner = t_grid.getCellOwner(row, col);
-    PieceType oldType = t_grid.getPieceType(row, col);
+    // the score doesnt depend on whose turn it is or which way round the board is, only on whose side its from
+    std::uint64_t key = t_position.getCanonicalKey();
+    if (t_position.getSideToMove() == Player::PLAYER_TWO)
+        key ^= Zobrist::SIDE_KEY;
+    if (t_aiPlayer == Player::PLAYER_TWO)
+        key ^= Zobrist::PERSPECTIVE_KEY;
+
+    int score;
+    if (m_evalCache.probe(key, score))
+        return score;
+
+    score = m_useIncrementalEval ? evaluateBoardIncremental(t_position, t_aiPlayer) : evaluateBoardFull(t_position, t_aiPlayer);
+    m_evalCache.store(key, score);
+    return score;
+}
 
-    t_grid.setPiece(row, col, temp, player);
+int AI::evaluateBoardIncremental(const Position& t_position, Player t_aiPlayer)
+{
+    Player opponent = (t_aiPlayer == Player::PLAYER_ONE) ? Player::PLAYER_TWO : Player::PLAYER_ONE;
 
-    bool win = false;
+    if (t_position.getFullLines(t_aiPlayer) > 0)
+        return WIN_SCORE;
+    if (t_position.getFullLines(opponent) > 0)
+        return LOSE_SCORE;
 
-    // Check if this creates 4 in a row
-    if (count4InARow(t_grid, player) > 0)
-        win = true;
+    // windows, centre and neighbours are kept up to date by make/unmake
+    int score = t_position.getLineScore(t_aiPlayer);
+    score += t_position.getPieceScore(t_aiPlayer) - t_position.getPieceScore(opponent);
 
-    // Undo change
-    if (oldType == PieceType::NONE)
-        t_grid.clearCell(row, col);
-    else
-        t_grid.setPiece(row, col, oldType, oldOwner);
+    // frogs can jump the whole board so mobility still gets counted here
+    int aiMoves = t_position.countMoves(t_aiPlayer);
+    int oppMoves = t_position.countMoves(opponent);
+    score += (aiMoves - oppMoves) * MOBILITY_WEIGHT;
 
-    return win;
+    return score;
 }
 
-int AI::evaluateBoard(Grid& t_grid, Player t_aiPlayer)
+int AI::evaluateBoardFull(const Position& t_position, Player t_aiPlayer)
 {
     Player opponent = (t_aiPlayer == Player::PLAYER_ONE) ? Player::PLAYER_TWO : Player::PLAYER_ONE;
 
     int score = 0;
+    int ai = (t_aiPlayer == Player::PLAYER_ONE) ? 0 : 1;
+    int aiWins = 0;
+    int oppWins = 0;
+
+    // one lookup per window covers fours, threes (ours and theirs) and 2+ potential lines
+    Bitboard playerOne = t_position.getPlayerMask(Player::PLAYER_ONE);
+    Bitboard playerTwo = t_position.getPlayerMask(Player::PLAYER_TWO);
+    for (int line = 0; line < NUM_WIN_LINES; ++line)
+    {
+        const WindowPattern& pattern = WINDOW_PATTERNS[getWindowPattern(playerOne, playerTwo, line)];
+        aiWins += pattern.fours[ai];
+        oppWins += pattern.fours[1 - ai];
+        score += pattern.scores[ai];
+    }
 
     // Check for immediate wins/losses first
-    int aiWins = count4InARow(t_grid, t_aiPlayer);
-    int oppWins = count4InARow(t_grid, opponent);
-    
     if (aiWins > 0)
         return WIN_SCORE; // We won!
     if (oppWins > 0)
         return LOSE_SCORE; // We lost
     
-    // 3 in a row means = possible win
-    int aiThreats = count3InARow(t_grid, t_aiPlayer);
-    int oppThreats = count3InARow(t_grid, opponent);
-    score += aiThreats * 800;  // creating threats
-    score -= oppThreats * 900; // blocking threats
-    
-    // Count potential 2 in a row wins
-    int aiPotential = countPotentialWins(t_grid, t_aiPlayer);
-    int oppPotential = countPotentialWins(t_grid, opponent);
-    score += aiPotential * 50;
-    score -= oppPotential * 40;
-    
     // evaluate each piece's position
     for (int row = 0; row < GRID_SIZE; ++row)
     {
         for (int col = 0; col < GRID_SIZE; ++col)
         {
-            Player owner = t_grid.getCellOwner(row, col);
+            Player owner = t_position.getCellOwner(row, col);
             if (owner == Player::NONE)
                 continue;
             
@@ -587,11 +970,11 @@ int AI::evaluateBoard(Grid& t_grid, Player t_aiPlayer)
             
 			// Center control is more valuable
             int centerDist = abs(row - 2) + abs(col - 2);
-            pieceValue += (8 - centerDist) * 8;
+            pieceValue += (8 - centerDist) * CENTER_WEIGHT;
             
             // Extra bonus for actual center
             if (row == 2 && col == 2)
-                pieceValue += 15;
+                pieceValue += CENTER_BONUS;
             
             // Count adjacent owned pieces
             int adjacentFriendly = 0;
@@ -604,12 +987,12 @@ int AI::evaluateBoard(Grid& t_grid, Player t_aiPlayer)
                     int newCol = col + dc;
                     if (newRow >= 0 && newRow < GRID_SIZE && newCol >= 0 && newCol < GRID_SIZE)
                     {
-                        if (t_grid.getCellOwner(newRow, newCol) == owner)
+                        if (t_position.getCellOwner(newRow, newCol) == owner)
                             adjacentFriendly++;
                     }
                 }
             }
-            pieceValue += adjacentFriendly * 12; //connected pieces = higher score
+            pieceValue += adjacentFriendly * ADJACENT_WEIGHT; //connected pieces = higher score
             
             if (owner == t_aiPlayer)
                 score += pieceValue;
@@ -619,73 +1002,79 @@ int AI::evaluateBoard(Grid& t_grid, Player t_aiPlayer)
     }
     
     // check if more moves available
-    int aiMoves = getAllPossibleMoves(t_grid, t_aiPlayer).size();
-    int oppMoves = getAllPossibleMoves(t_grid, opponent).size();
-    score += (aiMoves - oppMoves) * 8; // Increased weight
+    int aiMoves = t_position.countMoves(t_aiPlayer);
+    int oppMoves = t_position.countMoves(opponent);
+    score += (aiMoves - oppMoves) * MOBILITY_WEIGHT; // Increased weight
     
     return score;
 }
 
-std::vector<AI::Move> AI::getAllPossibleMoves(Grid& t_grid, Player t_player)
+void AI::getAllPossibleMoves(const Position& t_position, Player t_player, MoveList& t_moves)
 {
-    std::vector<Move> allMoves;
+    t_moves.clear();
 
-    for (int fromRow = 0; fromRow < GRID_SIZE; ++fromRow)
+    // any piece type thats left on any empty cell
+    if (t_position.getGameState() == GameState::PLACEMENT)
     {
-        for (int fromCol = 0; fromCol < GRID_SIZE; ++fromCol)
+        const PieceType types[] = { PieceType::FROG, PieceType::SNAKE, PieceType::DONKEY };
+        for (PieceType type : types)
         {
-            if (t_grid.getCellOwner(fromRow, fromCol) == t_player)//check for our pieces
-            {
-                std::vector<std::pair<int, int>> validMoves = getValidMoves(t_grid, fromRow, fromCol);//checks all valid moves
+            if (t_position.getRemainingPieces(t_player, type) == 0)
+                continue;
 
-                for (const auto& movePair : validMoves)//and adds them to a list
-                {
-                    allMoves.push_back({ fromRow, fromCol, movePair.first, movePair.second, 0 });
-                }
+            Bitboard empty = t_position.getEmptyMask();
+            while (empty)
+            {
+                int to = popLowest(empty);
+                Move move = { -1, -1, to / GRID_SIZE, to % GRID_SIZE, 0 };
+                move.pieceType = type;
+                t_moves.push_back(move);
             }
         }
+        return;
     }
 
-    return allMoves;
+    Bitboard pieces = t_position.getPlayerMask(t_player);//check for our pieces
+    while (pieces)
+    {
+        int from = popLowest(pieces);
+        Bitboard targets = t_position.getMoveTargets(from);//all valid moves for this piece
+
+        while (targets)//and adds them to a list
+        {
+            int to = popLowest(targets);
+            t_moves.push_back({ from / GRID_SIZE, from % GRID_SIZE, to / GRID_SIZE, to % GRID_SIZE, 0 });
+        }
+    }
 }
 
-void AI::orderMoves(std::vector<Move>& t_moves, Grid& t_grid, Player t_player)
+void AI::orderMoves(MoveList& t_moves, const Position& t_position, Player t_player, std::uint16_t t_tableMove, int t_ply)
 {
+    const HistoryTable& history = m_history[(t_player == Player::PLAYER_ONE) ? 0 : 1];
+
     // Give each move a rough score for ordering
     for (Move& move : t_moves)
     {
-        int moveScore = 0;
-        
-        // Prioritize moves toward center
-        int centerDist = abs(move.toRow - 2) + abs(move.toCol - 2);
-        moveScore += (8 - centerDist) * 5;
-        
-        // Check if move stops opponent piece
-        if (t_grid.getCellOwner(move.toRow, move.toCol) != Player::NONE)
+        int moveScore = MovePicker::getTieBreakScore(t_position, move, t_player);
+
+        // what actually caused cutoffs counts most, the score above just breaks ties (its always under 1024)
+        int to = move.toRow * GRID_SIZE + move.toCol;
+        moveScore += history[getMoveSource(move)][to] * 1024;
+
+        // best move from the transposition table goes first, then the killers
+        std::uint16_t packed = packMove(move);
+        if (t_tableMove != 0 && packed == t_tableMove)
         {
-            moveScore += 100; // higher score 
+            moveScore = std::numeric_limits<int>::max();
         }
-        
-        // Bonus for creating threats
-        Player opponent = (t_player == Player::PLAYER_ONE) ? Player::PLAYER_TWO : Player::PLAYER_ONE;
-        
-        // Count adjacent friendly pieces
-        int howManyBesideMe = 0;
-        for (int drow = -1; drow <= 1; drow++)
+        else if (packed == m_killers[t_ply][0])
         {
-            for (int dcol = -1; dcol <= 1; dcol++)
-            {
-                if (drow == 0 && dcol == 0) continue;
-                int newRow = move.toRow + drow;
-                int newCol = move.toCol + dcol;
-                if (newRow >= 0 && newRow < GRID_SIZE && newCol >= 0 && newCol < GRID_SIZE)
-                {
-                    if (t_grid.getCellOwner(newRow, newCol) == t_player)
-                        howManyBesideMe++;
-                }
-            }
+            moveScore = std::numeric_limits<int>::max() - 1;
+        }
+        else if (packed == m_killers[t_ply][1])
+        {
+            moveScore = std::numeric_limits<int>::max() - 2;
         }
-        moveScore += howManyBesideMe * 10;
         
         move.score = moveScore;
     }
@@ -694,170 +1083,73 @@ void AI::orderMoves(std::vector<Move>& t_moves, Grid& t_grid, Player t_player)
     std::sort(t_moves.begin(), t_moves.end(), [](const Move& a, const Move& b) { return a.score > b.score; });
 }
 
-void AI::testMove(Grid& t_grid, const Move& t_move)//this just tests moves, doesnt actually do them
+void AI::recordCutoff(const Move& t_move, Player t_player, int t_ply, int t_depth)
 {
-    PieceType type = t_grid.getPieceType(t_move.fromRow, t_move.fromCol);
-    Player owner = t_grid.getCellOwner(t_move.fromRow, t_move.fromCol);
-
-    t_grid.clearCell(t_move.fromRow, t_move.fromCol);
-    t_grid.setPiece(t_move.toRow, t_move.toCol, type, owner);
-}
-
-void AI::undoMove(Grid& t_grid, const Move& t_move, PieceType t_capturedType, Player t_capturedOwner)
-{
-    PieceType type = t_grid.getPieceType(t_move.toRow, t_move.toCol);//finds the moved piece
-    Player owner = t_grid.getCellOwner(t_move.toRow, t_move.toCol);
-
-    t_grid.setPiece(t_move.fromRow, t_move.fromCol, type, owner);//sets it back to old position
-
-    if (t_capturedType != PieceType::NONE)//changes back the new cell too
-    {
-        t_grid.setPiece(t_move.toRow, t_move.toCol, t_capturedType, t_capturedOwner);
-    }
-    else
+    // killers are kept per ply, newest first
+    std::uint16_t packed = packMove(t_move);
+    if (m_killers[t_ply][0] != packed)
     {
-        t_grid.clearCell(t_move.toRow, t_move.toCol);
+        m_killers[t_ply][1] = m_killers[t_ply][0];
+        m_killers[t_ply][0] = packed;
     }
-}
 
-int AI::count3InARow(Grid& t_grid, Player t_player)
-{
-    int threats = 0;
-
-    // Check all directions for 3-in-a-row with an empty space
-    int directions[4][4] = {
-        {0, 1, GRID_SIZE, GRID_SIZE - 3},     // Horizontal
-        {1, 0, GRID_SIZE - 3, GRID_SIZE},     // Vertical
-        {1, 1, GRID_SIZE - 3, GRID_SIZE - 3}, // Diagonal left
-        {1, -1, GRID_SIZE - 3, 3}             // Diagonal right
-    };
+    HistoryTable& history = m_history[(t_player == Player::PLAYER_ONE) ? 0 : 1];
+    int& entry = history[getMoveSource(t_move)][t_move.toRow * GRID_SIZE + t_move.toCol];
+    entry += t_depth * t_depth;
 
-    for (auto& dir : directions)//checks the 4 cells in a row for possible wins
+    // keep it all in range without losing which moves are better
+    if (entry > HISTORY_LIMIT)
     {
-        int rowDir = dir[0];
-        int colDir = dir[1];
-        int maxRow = dir[2];
-        int maxCol = dir[3];
-
-        for (int row = 0; row < maxRow; ++row)
-        {
-            for (int col = (colDir == -1 ? 3 : 0); col < maxCol; ++col)
-            {
-                int count = 0;
-                int empty = 0;
-
-                for (int i = 0; i < 4; ++i)
-                {
-                    int checkRow = row + i * rowDir;
-                    int checkCol = col + i * colDir;
-
-                    if (t_grid.getCellOwner(checkRow, checkCol) == t_player)//makes sure its the enemy pieces
-                        count++;
-                    else if (t_grid.isCellEmpty(checkRow, checkCol))
-                        empty++;
-                }
-
-                if (count == 3 && empty == 1)//if 3 in a row and an empty space, mark it
-                    threats++;
-            }
-        }
+        for (int side = 0; side < 2; ++side)
+            for (int from = 0; from < NUM_MOVE_SOURCES; ++from)
+                for (int to = 0; to < NUM_SQUARES; ++to)
+                    m_history[side][from][to] /= 2;
     }
-
-    return threats;
 }
 
-//counts every full 4 in a row line for the given player
-int AI::count4InARow(Grid& t_grid, Player t_player)
+void AI::ageOrdering()
 {
-    int wins = 0;
-
-    // horizontal
-    for (int row = 0; row < GRID_SIZE; row++)
-        for (int col = 0; col <= GRID_SIZE - 4; col++)
-            if (t_grid.getCellOwner(row, col) == t_player &&
-                t_grid.getCellOwner(row, col + 1) == t_player &&
-                t_grid.getCellOwner(row, col + 2) == t_player &&
-                t_grid.getCellOwner(row, col + 3) == t_player)
-                wins++;    //found a full horizontal line
-
-    // vertical
-    for (int row = 0; row <= GRID_SIZE - 4; row++)
-        for (int col = 0; col < GRID_SIZE; col++)
-            if (t_grid.getCellOwner(row, col) == t_player &&
-                t_grid.getCellOwner(row + 1, col) == t_player &&
-                t_grid.getCellOwner(row + 2, col) == t_player &&
-                t_grid.getCellOwner(row + 3, col) == t_player)
-                wins++; //found a vertical line
-
-    // diagonal
-    for (int row = 0; row <= GRID_SIZE - 4; row++)
-        for (int col = 0; col <= GRID_SIZE - 4; col++)
-            if (t_grid.getCellOwner(row, col) == t_player &&
-                t_grid.getCellOwner(row + 1, col + 1) == t_player &&
-                t_grid.getCellOwner(row + 2, col + 2) == t_player &&
-                t_grid.getCellOwner(row + 3, col + 3) == t_player)
-                wins++; //found a diagonal top left line
-
-    // anti-diagonal
-    for (int row = 0; row <= GRID_SIZE - 4; row++)
-        for (int col = 3; col < GRID_SIZE; col++)
-            if (t_grid.getCellOwner(row, col) == t_player &&
-                t_grid.getCellOwner(row + 1, col - 1) == t_player &&
-                t_grid.getCellOwner(row + 2, col - 2) == t_player &&
-                t_grid.getCellOwner(row + 3, col - 3) == t_player)
-                wins++;  //found a diagonal top right line
-   
-    return wins;
+    for (int side = 0; side < 2; ++side)
+        for (int from = 0; from < NUM_MOVE_SOURCES; ++from)
+            for (int to = 0; to < NUM_SQUARES; ++to)
+                m_history[side][from][to] /= 2;
+
+    // two plies have gone by (our move and the reply) so last time's ply 2 is this time's root
+    std::memmove(m_killers[0], m_killers[2], sizeof(m_killers) - 2 * sizeof(m_killers[0]));
+    std::memset(m_killers[MAX_PLY - 2], 0, 2 * sizeof(m_killers[0]));
 }
 
-int AI::countPotentialWins(Grid& t_grid, Player t_player)//same as threats but checks 2+ in a row
+TablebaseResult AI::keepTablebaseMoves(Position& t_position, MoveList& t_moves)
 {
-    int potential = 0;
-    Player opponent = (t_player == Player::PLAYER_ONE) ? Player::PLAYER_TWO : Player::PLAYER_ONE;
-
-    // Check all directions for 2+ in a row
-    int directions[4][4] = {
-        {0, 1, GRID_SIZE, GRID_SIZE - 3}, // Horizontal
-        {1, 0, GRID_SIZE - 3, GRID_SIZE}, // Vertical
-        {1, 1, GRID_SIZE - 3, GRID_SIZE - 3}, // Diagonal left
-        {1, -1, GRID_SIZE - 3, 3} // Diagonal right
-    };
-
-    for (auto& dir : directions)
+    TablebaseResult result = m_tablebase.probe(t_position);
+    if (result == TablebaseResult::MISSING)
     {
-        int rowDir = dir[0];
-        int colDir = dir[1];
-        int maxRow = dir[2];
-        int maxCol = dir[3];
-
-        for (int row = 0; row < maxRow; ++row)
-        {
-            for (int col = (colDir == -1 ? 3 : 0); col < maxCol; ++col)
-            {
-                int count = 0;
-                int empty = 0;
-                bool hasOpponent = false;
-
-                for (int i = 0; i < 4; ++i)
-                {
-                    int checkRow = row + i * rowDir;
-                    int checkCol = col + i * colDir;
-
-                    Player cellOwner = t_grid.getCellOwner(checkRow, checkCol);
-
-                    if (cellOwner == t_player)
-                        count++;
-                    else if (t_grid.isCellEmpty(checkRow, checkCol))
-                        empty++;
-                    else if (cellOwner == opponent)
-                        hasOpponent = true;
-                }
+        return result;
+    }
 
-                if (count >= 2 && !hasOpponent && empty >= 1)
-                    potential++;
-            }
-        }
+    int kept = 0;
+    for (const Move& move : t_moves)
+    {
+        t_position.make(move);
+        TablebaseResult reply = m_tablebase.probe(t_position);
+        bool won = t_position.getGameState() == GameState::GAME_OVER;
+        t_position.unmake();
+
+        // the table is from their side after the move, so their loss is our win
+        TablebaseResult ours = TablebaseResult::DRAW;
+        if (won || reply == TablebaseResult::LOSS)
+            ours = TablebaseResult::WIN;
+        else if (reply == TablebaseResult::WIN)
+            ours = TablebaseResult::LOSS;
+
+        if (ours == result)
+            t_moves[kept++] = move;
     }
 
-    return potential;
-}
\ No newline at end of file
+    // every move is as good as any other when the position is lost
+    if (kept > 0)
+    {
+        t_moves.shrink(kept);
+    }
+    return result;
+}
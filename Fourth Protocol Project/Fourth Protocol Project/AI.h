@@ -8,23 +8,54 @@
 #define AI_HPP
 
 #include "Grid.h"
+#include "Position.h"
+#include "TranspositionTable.h"
+#include "MovePicker.h"
+#include "ThreatSolver.h"
+#include "ProofNumberSearch.h"
+#include "EvaluationCache.h"
+#include "OpeningBook.h"
+#include "Tablebase.h"
+#include "MonteCarloSearch.h"
 #include <vector>
 #include <utility>
+#include <chrono>
 #include <functional>
+#include <algorithm>
 #include "Constants.h"
 
 /**
  * @class AI
  * @brief AI player that uses minimax algorithm with alpha-beta pruning
  * 
- * This class implements a basic AI that can play at different difficulty levels.
- * It uses the minimax algorithm with alpha-beta pruning for move evaluation during
- * the movement phase, and heuristic-based placement during the placement phase.
+ * This class implements an AI that can play at different difficulty levels.
+ * Both phases are searched with the minimax algorithm with alpha-beta pruning.
+ * A placement is a move like any other, made of a piece type and a cell, and
+ * goes through findBestMove once the opening book and the proof search have
+ * nothing to say about the position.
+ * Positions it has already searched are kept in a transposition table so
+ * they don't get searched again when reached through a different move order.
+ * Before searching it checks for a forced win made only of threats, which
+ * is much cheaper to find that way, and plays it straight away.
  * 
- * Difficulty levels affect the search depth:
- * - Easy: 1 move (shallow search)
- * - Medium: 3 moves (balanced)
- * - Hard: 5 moves (deep search)
+ * The search deepens one move at a time until the time budget runs out,
+ * and plays the best move from the last search that finished. Each
+ * iteration starts with a narrow window around the last score, and after
+ * the first move of a node the rest are only checked to see if they can
+ * beat it (principal variation search), which prunes far more. Late
+ * quiet moves are searched shallower first, a pass is tried to prove a
+ * node is already good enough (null move), and hopeless quiet moves next
+ * to the horizon are skipped (futility); each can be switched off. At the
+ * horizon, wins and blocks are played out until nobody has a three that
+ * can be finished, so a one move loss is never just a guess. Difficulty
+ * sets the budget and how deep it is allowed to go:
+ * - Easy: 1 move, 100ms
+ * - Medium: up to 3 moves, 300ms
+ * - Hard: as deep as it gets in 1s
+ *
+ * Any difficulty can use Monte Carlo tree search instead (see
+ * MonteCarloSearch), which spends the same time budget on random playouts
+ * across every core rather than searching on one.
  */
 class AI
 {
@@ -52,7 +83,7 @@ public:
      * @brief Sets the AI difficulty level
      * @param t_difficulty The difficulty level to set
      * 
-     * Changes the search depth used by the minimax algorithm
+     * Changes the depth cap and time budget used by the search
      */
     void setDifficulty(Difficulty t_difficulty);
     
@@ -61,6 +92,192 @@ public:
      * @return The current Difficulty setting
      */
     Difficulty getDifficulty() const;
+
+    /**
+     * @brief Sets the size of the transposition table
+     * @param t_megabytes Table size in MB
+     *
+     * Clears anything stored in the table
+     */
+    void setHashSize(int t_megabytes);
+
+    /**
+     * @brief Sets the size of the evaluation cache
+     * @param t_kilobytes Cache size in KB, 0 to turn it off
+     *
+     * Clears anything stored in the cache
+     */
+    void setEvalCacheSize(int t_kilobytes) { m_evalCache.resize(t_kilobytes); }
+
+    /**
+     * @brief Maps an opening book for the first placements
+     * @param t_path Path of a book written by --build-book
+     * @return False if it couldnt be opened, the AI just searches those placements then
+     *
+     * The default book is opened when the AI is created
+     */
+    bool loadOpeningBook(const std::string& t_path) { return m_book.open(t_path); }
+
+    /**
+     * @brief Unmaps the opening book, the AI searches every placement then
+     */
+    void closeOpeningBook() { m_book.close(); }
+
+    /**
+     * @brief Gets how many positions the opening book holds
+     * @return Entry count, 0 when there is no book
+     */
+    std::size_t getOpeningBookSize() const { return m_book.getSize(); }
+
+    /**
+     * @brief Maps a solved movement tablebase
+     * @param t_path Path of a table written by --solve, plain or compressed
+     * @return False if it couldnt be opened, hard just searches the movement phase then
+     *
+     * The default table is opened when the AI is created. Hard looks up
+     * every position the search reaches in the movement phase, so placement
+     * searches see exactly how each way of finishing placement turns out
+     */
+    bool loadTablebase(const std::string& t_path) { return m_tablebase.open(t_path); }
+
+    /**
+     * @brief Sets how much memory a compressed tablebase keeps decompressed
+     * @param t_megabytes Cache size in MB
+     */
+    void setTablebaseCacheSize(int t_megabytes) { m_tablebase.setCacheSize(t_megabytes); }
+
+    /**
+     * @brief Gets the block cache hit counters of the tablebase
+     * @return Counters since the table was opened or the cache resized
+     */
+    const Tablebase::CacheStats& getTablebaseStats() const { return m_tablebase.getCacheStats(); }
+
+    /**
+     * @brief Gets how many indexes the tablebase has
+     * @return Index count, 0 when there is no table
+     */
+    std::uint64_t getTablebaseSize() const { return m_tablebase.getSize(); }
+
+    /**
+     * @brief Searches a position without a grid, for offline tools
+     * @param t_position Position to search, the side to move is the one playing
+     * @return Best move found with its score (fromRow and toRow -1 if there are none)
+     *
+     * Uses the current budget and never looks in the opening book
+     */
+    Move searchPosition(Position& t_position) { return findBestMove(t_position, t_position.getSideToMove()); }
+
+    /**
+     * @brief Gets all possible moves for a player
+     * @param t_position Reference to the position
+     * @param t_player The player to get moves for
+     * @param t_moves Filled in with every possible move
+     */
+    void getAllPossibleMoves(const Position& t_position, Player t_player, MoveList& t_moves);
+
+    /**
+     * @brief Forgets the move ordering learnt during the last game
+     *
+     * Call when a new game starts; the transposition table is kept
+     */
+    void newGame();
+
+    /**
+     * @brief Overrides the search budget set by the difficulty
+     * @param t_milliseconds Time allowed per move (0 for no limit)
+     * @param t_nodes Positions allowed per move (0 for no limit)
+     *
+     * The first iteration always finishes so there is always a move to play
+     */
+    void setSearchBudget(int t_milliseconds, std::uint64_t t_nodes);
+
+    /**
+     * @brief Picks the search a difficulty uses
+     * @param t_difficulty Difficulty to change
+     * @param t_engine Minimax or Monte Carlo tree search
+     *
+     * Monte Carlo takes the node budget as its playout budget
+     */
+    void setSearchEngine(Difficulty t_difficulty, SearchEngine t_engine) { m_engines[static_cast<int>(t_difficulty)] = t_engine; }
+
+    /**
+     * @brief Gets the search a difficulty uses
+     * @param t_difficulty Difficulty to check
+     * @return Its search engine
+     */
+    SearchEngine getSearchEngine(Difficulty t_difficulty) const { return m_engines[static_cast<int>(t_difficulty)]; }
+
+    /**
+     * @brief Sets how many threads the Monte Carlo search uses
+     * @param t_threads Thread count, 0 for one per core
+     */
+    void setSearchThreads(int t_threads) { m_threads = std::max(0, t_threads); }
+
+    /**
+     * @brief Gets the Monte Carlo search, for its counters
+     * @return The search, its tree as the last move left it
+     */
+    const MonteCarloSearch& getMonteCarloSearch() const { return m_monteCarlo; }
+
+    /**
+     * @brief Turns late move reductions on or off
+     * @param t_enabled True to search late quiet moves shallower first
+     */
+    void setLateMoveReductions(bool t_enabled) { m_useReductions = t_enabled; }
+
+    /**
+     * @brief Turns null-move pruning on or off
+     * @param t_enabled True to try passing to prove a node is already good enough
+     */
+    void setNullMovePruning(bool t_enabled) { m_useNullMove = t_enabled; }
+
+    /**
+     * @brief Turns futility pruning on or off
+     * @param t_enabled True to skip quiet moves one move from the horizon that cant catch up
+     */
+    void setFutilityPruning(bool t_enabled) { m_useFutility = t_enabled; }
+
+    /**
+     * @brief Switches between the running evaluation totals and a full rescan
+     * @param t_enabled True to use the totals Position keeps (same scores, less work)
+     */
+    void setIncrementalEvaluation(bool t_enabled) { m_useIncrementalEval = t_enabled; }
+
+    /**
+     * @brief Gets the depth reached by the last search
+     * @return Depth of the last iteration that finished (deepest walk down the tree for Monte Carlo)
+     */
+    int getLastDepth() const { return m_lastDepth; }
+
+    /**
+     * @brief Gets the number of positions visited by the last search
+     * @return Node count from the last move (playouts for Monte Carlo)
+     */
+    std::uint64_t getLastNodes() const { return m_nodes; }
+
+    /**
+     * @brief Gets the transposition table counters from the last search
+     * @return Probes, hits and cutoffs from the last move
+     */
+    const TranspositionTable::Stats& getTableStats() const { return m_table.getStats(); }
+
+    /**
+     * @brief Gets the size of the transposition table
+     * @return Table size in MB
+     */
+    int getHashSize() const { return m_table.getSizeMB(); }
+
+    /**
+     * @brief Gets the evaluation cache counters for the last search
+     * @return Probe and hit counts
+     */
+    const EvaluationCache::Stats& getEvalCacheStats() const { return m_evalCache.getStats(); }
+
+    /**
+     * @brief Gets the size of the evaluation cache
+     * @return Cache size in KB (0 when off)
+     */
+    int getEvalCacheSize() const { return m_evalCache.getSizeKB(); }
     
     /**
      * @brief Gets the last evaluated moves for visualisation
@@ -71,22 +288,34 @@ public:
     std::vector<AIVisualisation> getLastCheckedMoves() const { return m_lastCheckedMoves; }
 
 private:
-    /**
-     * @struct Move
-     * @brief Represents a potential move with its score
-     */
-    struct Move
-    {
-        int fromRow;    ///< Source row
-        int fromCol;    ///< Source column
-        int toRow;      ///< Destination row
-        int toCol;      ///< Destination column
-        int score;      ///< Evaluated score of this move
-    };
-    
     std::vector<AIVisualisation> m_lastCheckedMoves;    ///< Last evaluated moves for visualisation
     Difficulty m_difficulty;                            ///< Current difficulty level
     int m_maxDepth;                                     ///< Maximum search depth for minimax
+    int m_timeBudget;                                   ///< Time allowed per move in ms, 0 for no limit
+    std::uint64_t m_nodeBudget;                         ///< Positions allowed per move, 0 for no limit
+    std::uint64_t m_nodes;                              ///< Positions visited this search
+    int m_lastDepth;                                    ///< Deepest iteration finished this search
+    bool m_stopSearch;                                  ///< Set when the budget runs out mid iteration
+    bool m_useReductions;                               ///< Late move reductions on
+    bool m_useNullMove;                                 ///< Null-move pruning on
+    bool m_useFutility;                                 ///< Futility pruning on
+    bool m_useIncrementalEval;                          ///< Evaluate from Position's running totals
+    bool m_inNullSearch;                                ///< Searching below a pass, so no second pass
+    bool m_probeTablebase;                              ///< Look up positions in the tablebase during this search
+    std::chrono::steady_clock::time_point m_searchStart;///< When the current search started
+    std::uint16_t m_killers[MAX_PLY][2];                ///< Two packed moves per ply that last caused a cutoff
+    HistoryTable m_history[2];                          ///< Cutoff score per side, by move source and to cell
+    TranspositionTable m_table;                         ///< Results of positions already searched
+    EvaluationCache m_evalCache;                        ///< Static evaluations of positions already scored
+    ThreatSolver m_threatSolver;                        ///< Checks for a forced win before searching
+    ProofNumberSearch m_proofSearch;                    ///< Checks for a forced win during placement
+    OpeningBook m_book;                                 ///< Precomputed first placements, mapped read-only
+    Tablebase m_tablebase;                              ///< Solved movement phase, mapped read-only
+    MonteCarloSearch m_monteCarlo;                      ///< Tree search the difficulties can use instead of minimax
+    SearchEngine m_engines[3];                          ///< Search used by each difficulty
+    int m_threads;                                      ///< Threads for the Monte Carlo search, 0 for one per core
+    std::uint64_t m_perspectiveKey;                     ///< Hash salt for the side the AI is searching as, and for tablebase probing
+    int m_rootPly;                                      ///< Position's ply when the search started, win scores count from here
     
     // Placement phase methods
     
@@ -96,159 +325,183 @@ private:
      */
     void placePiece(Grid& t_grid);
     
+    // Movement phase methods
+    
     /**
-     * @brief Chooses which piece type to place
+     * @brief Handles piece movement during movement phase
      * @param t_grid Reference to the grid
-     * @param t_player The player to choose for
-     * @return The selected PieceType
      */
-    PieceType choosePieceType(Grid& t_grid, Player t_player);
+    void movePiece(Grid& t_grid);
+
+    // Minimax algorithm methods
     
     /**
-     * @brief Chooses where to place a piece
-     * @param t_grid Reference to the grid
-     * @return Pair of (row, col) coordinates
+     * @brief Orders moves by likelihood of being good
+     * @param t_moves Moves to sort
+     * @param t_position Reference to the position
+     * @param t_player The player making the moves
+     * @param t_tableMove Packed best move from the transposition table (0 if none), tried first
+     * @param t_ply Distance from the root, for the killer moves
+     *
+     * Table move first, then the killers, then by history. The old
+     * centre/neighbour score only breaks ties.
      */
-    std::pair<int, int> choosePlacementPos(Grid& t_grid);
+    void orderMoves(MoveList& t_moves, const Position& t_position, Player t_player, std::uint16_t t_tableMove, int t_ply);
 
-    // Movement phase methods
-    
     /**
-     * @brief Handles piece movement during movement phase
-     * @param t_grid Reference to the grid
+     * @brief Remembers a move that caused a cutoff
+     * @param t_move The move
+     * @param t_player Player who made it
+     * @param t_ply Distance from the root
+     * @param t_depth Remaining depth, deeper cutoffs count for more
      */
-    void movePiece(Grid& t_grid);
-    
+    void recordCutoff(const Move& t_move, Player t_player, int t_ply, int t_depth);
+
     /**
-     * @brief Randomly selects one of the AI's pieces
-     * @param t_grid Reference to the grid
-     * @param t_player The player to select for
-     * @return Pair of (row, col) coordinates
+     * @brief Fades the history and killers left from the last move
+     *
+     * Called at the start of each search, so what was learnt still helps
+     * but newer cutoffs soon outweigh it
      */
-    std::pair<int, int> chooseRandomPiece(Grid& t_grid, Player t_player);
-    
+    void ageOrdering();
+
     /**
-     * @brief Randomly selects a valid move
-     * @param t_grid Reference to the grid
-     * @param t_fromRow Source row
-     * @param t_fromCol Source column
-     * @return Pair of (row, col) destination coordinates
+     * @brief Drops the root moves that give away part of the tablebase result
+     * @param t_position Position being searched
+     * @param t_moves Root moves, cut down to the ones that keep the win (or the draw)
+     * @return The table's result for the position, MISSING if it doesnt cover it
+     *
+     * The table only says win, loss or draw, not how far away the four is,
+     * so the search still picks between the moves that are left and finds
+     * the four once it is close enough to see. Does nothing without a table
      */
-    std::pair<int, int> chooseRandomMove(Grid& t_grid, int t_fromRow, int t_fromCol);
+    TablebaseResult keepTablebaseMoves(Position& t_position, MoveList& t_moves);
 
-    // Minimax algorithm methods
-    
     /**
-     * @brief Gets all possible moves for a player
-     * @param t_grid Reference to the grid
-     * @param t_player The player to get moves for
-     * @return Vector of all possible Move structs
+     * @brief Lists the moves worth searching at the root
+     * @param t_position Position being searched
+     * @param t_player Player to move
+     * @param t_moves Filled in with one move of each mirror image, cut down by the tablebase on hard
+     * @return The table's result for the position, MISSING if it doesnt cover it or isnt used
      */
-    std::vector<Move> getAllPossibleMoves(Grid& t_grid, Player t_player);
-    
+    TablebaseResult getRootMoves(Position& t_position, Player t_player, MoveList& t_moves);
+
     /**
-     * @brief Orders moves by likelihood of being good
-     * @param t_moves Vector of moves to sort
-     * @param t_grid Reference to the grid
-     * @param t_player The player making the moves
+     * @brief Looks for a forced win made only of threats
+     * @param t_position Position being searched
+     * @param t_move Set to the first move of the win
+     * @return True if there is one, the visuals and node count are then filled in
      */
-    void orderMoves(std::vector<Move>& t_moves, Grid& t_grid, Player t_player);
+    bool findThreatWin(Position& t_position, Move& t_move);
     
     /**
      * @brief Gets all valid moves for a specific piece
-     * @param t_grid Reference to the grid
+     * @param t_position Reference to the position
      * @param t_fromRow Source row
      * @param t_fromCol Source column
-     * @return Vector of (row, col) pairs of valid destinations
+     * @return (row, col) pairs of valid destinations
      */
-    std::vector<std::pair<int, int>> getValidMoves(Grid& t_grid, int t_fromRow, int t_fromCol);
+    CellList getValidMoves(const Position& t_position, int t_fromRow, int t_fromCol);
     
     /**
-     * @brief Checks if a cell is empty
-     * @param t_grid Reference to the grid
-     * @param t_row Row to check
-     * @param t_col Column to check
-     * @return True if cell is empty
+     * @brief Finds the best move using iterative deepening minimax
+     * @param t_position Reference to the position (placements are searched while in the placement phase)
+     * @param t_player The player to find best move for
+     * @return The best Move from the deepest iteration that finished
      */
-    bool isCellEmpty(Grid& t_grid, int t_row, int t_col) const;
-    
+    Move findBestMove(Position& t_position, Player t_player);
+
     /**
-     * @brief Finds the best move using minimax algorithm
-     * @param t_grid Reference to the grid
+     * @brief Finds the best move with Monte Carlo tree search
+     * @param t_position Reference to the position
      * @param t_player The player to find best move for
-     * @return The best Move found
+     * @return The most visited Move, its score the percentage of points it got
+     *
+     * Keeps the tree from the last move if this position is in it
      */
-    Move findBestMove(Grid& t_grid, Player t_player);
+    Move findBestMoveMonteCarlo(Position& t_position, Player t_player);
     
+    /**
+     * @brief Gets how long the current search has been running
+     * @return Elapsed time in ms
+     */
+    long long getElapsedMs() const;
+
+    /**
+     * @brief Counts a visited position and checks the budget
+     *
+     * Sets m_stopSearch when time or nodes run out. Never stops the first
+     * iteration, so there is always a finished move to fall back on.
+     */
+    void countNode();
+
     /**
      * @brief Minimax algorithm with alpha-beta pruning
-     * @param t_grid Reference to the grid
+     *
+     * The first move gets the full window, the rest a null window that is
+     * only widened again if the move turns out better than the first.
+     *
+     * @param t_position Reference to the position
      * @param t_depth Current search depth
      * @param t_isMaximizing Whether this is a maximizing node
      * @param t_aiPlayer The AI player
      * @param t_alpha Alpha value for pruning
      * @param t_beta Beta value for pruning
-     * @return Evaluated score of the position
+     * @return Evaluated score of the position, meaningless if the search was stopped
      */
-    int minimax(Grid& t_grid, int t_depth, bool t_isMaximizing, Player t_aiPlayer, int t_alpha, int t_beta);
+    int minimax(Position& t_position, int t_depth, bool t_isMaximizing, Player t_aiPlayer, int t_alpha, int t_beta);
     
     /**
-     * @brief Evaluates the current board state
-     * @param t_grid Reference to the grid
+     * @brief Plays out wins and forced blocks past the horizon
+     * @param t_position Reference to the position
+     * @param t_isMaximizing Whether this is a maximizing node
      * @param t_aiPlayer The AI player
-     * @return Heuristic score of the board
+     * @param t_alpha Alpha value for pruning
+     * @param t_beta Beta value for pruning
+     * @param t_ply Plies searched past the horizon so far
+     * @return Score once nobody can finish a four next move
+     *
+     * The side to move can stand on the static evaluation unless the
+     * opponent can finish a four next move, then it has to block.
      */
-    int evaluateBoard(Grid& t_grid, Player t_aiPlayer);
+    int quiescence(Position& t_position, bool t_isMaximizing, Player t_aiPlayer, int t_alpha, int t_beta, int t_ply);
 
     /**
-     * @brief Temporarily applies a move to test it
-     * @param t_grid Reference to the grid
-     * @param t_move The move to test
-     */
-    void testMove(Grid& t_grid, const Move& t_move);
-    
-    /**
-     * @brief Undoes a tested move
-     * @param t_grid Reference to the grid
-     * @param t_move The move to undo
-     * @param t_capturedType Type of piece that was at destination
-     * @param t_capturedOwner Owner of piece that was at destination
+     * @brief Evaluates the current board state
+     * @param t_position Reference to the position
+     * @param t_aiPlayer The AI player
+     * @return Heuristic score of the board
+     *
+     * Checks the evaluation cache first, then scores it with the running
+     * totals (or the full rescan if that is switched on)
      */
-    void undoMove(Grid& t_grid, const Move& t_move, PieceType t_capturedType, Player t_capturedOwner);
+    int evaluateBoard(const Position& t_position, Player t_aiPlayer);
 
     /**
-     * @brief Checks if a move would cause a win
-     * @param t_grid Reference to the grid
-     * @param row Row to check
-     * @param col Column to check
-     * @param player Player to check for
-     * @return True if placing a piece here would win
+     * @brief Evaluates the board from the totals Position keeps up to date
+     * @param t_position Reference to the position
+     * @param t_aiPlayer The AI player
+     * @return Same score as evaluateBoardFull, only mobility is counted here
      */
-    bool doesMoveCauseWin(Grid& t_grid, int row, int col, Player player);
+    int evaluateBoardIncremental(const Position& t_position, Player t_aiPlayer);
 
     /**
-     * @brief Counts number of 4-in-a-row lines for a player
-     * @param t_grid Reference to the grid
-     * @param t_player Player to count for
-     * @return Number of 4-in-a-row lines
-     */
-    int count4InARow(Grid& t_grid, Player t_player);
-    
-    /**
-     * @brief Counts number of 3-in-a-row threats for a player
-     * @param t_grid Reference to the grid
-     * @param t_player Player to count for
-     * @return Number of 3-in-a-row lines with one empty space
+     * @brief Evaluates the board by rescanning every window and piece
+     * @param t_position Reference to the position
+     * @param t_aiPlayer The AI player
+     * @return Same score as evaluateBoard
      */
-    int count3InARow(Grid& t_grid, Player t_player);
-    
+    int evaluateBoardFull(const Position& t_position, Player t_aiPlayer);
+
     /**
-     * @brief Counts potential winning opportunities (2+ in a row)
-     * @param t_grid Reference to the grid
-     * @param t_player Player to count for
-     * @return Number of potential winning lines
+     * @brief Checks if a player has a piece blocking one of the opponent's threes
+     * @param t_position Reference to the position
+     * @param t_player Player to check for
+     * @return True if one of the player's pieces is the only thing stopping a four
+     *
+     * Null move is unsafe then, because having to move can mean moving the blocker
      */
-    int countPotentialWins(Grid& t_grid, Player t_player);
+    bool holdsBlock(const Position& t_position, Player t_player);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "AllocationCounter.h"
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+#ifdef _DEBUG
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// per thread so the audio thread allocating doesnt trip a check on the game thread
+static thread_local std::uint64_t s_allocations = 0;
+
+static void* countedAlloc(std::size_t t_size) noexcept
+{
+    s_allocations++;
+    return std::malloc(t_size ? t_size : 1);
+}
+
+static void* countedAlignedAlloc(std::size_t t_size, std::align_val_t t_alignment) noexcept
+{
+    s_allocations++;
+    std::size_t alignment = static_cast<std::size_t>(t_alignment);
+#ifdef _WIN32
+    return _aligned_malloc(t_size ? t_size : 1, alignment);
+#else
+    // aligned_alloc wants the size rounded up to the alignment
+    std::size_t size = t_size ? (t_size + alignment - 1) / alignment * alignment : alignment;
+    return std::aligned_alloc(alignment, size);
+#endif
+}
+
+static void alignedFree(void* t_memory) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(t_memory);
+#else
+    std::free(t_memory);
+#endif
+}
+
+void* operator new(std::size_t t_size)
+{
+    if (void* memory = countedAlloc(t_size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t t_size)
+{
+    return operator new(t_size);
+}
+
+void* operator new(std::size_t t_size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(t_size);
+}
+
+void* operator new[](std::size_t t_size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(t_size);
+}
+
+void* operator new(std::size_t t_size, std::align_val_t t_alignment)
+{
+    if (void* memory = countedAlignedAlloc(t_size, t_alignment))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t t_size, std::align_val_t t_alignment)
+{
+    return operator new(t_size, t_alignment);
+}
+
+void* operator new(std::size_t t_size, std::align_val_t t_alignment, const std::nothrow_t&) noexcept
+{
+    return countedAlignedAlloc(t_size, t_alignment);
+}
+
+void* operator new[](std::size_t t_size, std::align_val_t t_alignment, const std::nothrow_t&) noexcept
+{
+    return countedAlignedAlloc(t_size, t_alignment);
+}
+
+void operator delete(void* t_memory) noexcept
+{
+    std::free(t_memory);
+}
+
+void operator delete[](void* t_memory) noexcept
+{
+    std::free(t_memory);
+}
+
+void operator delete(void* t_memory, std::size_t) noexcept
+{
+    std::free(t_memory);
+}
+
+void operator delete[](void* t_memory, std::size_t) noexcept
+{
+    std::free(t_memory);
+}
+
+void operator delete(void* t_memory, const std::nothrow_t&) noexcept
+{
+    std::free(t_memory);
+}
+
+void operator delete[](void* t_memory, const std::nothrow_t&) noexcept
+{
+    std::free(t_memory);
+}
+
+void operator delete(void* t_memory, std::align_val_t) noexcept
+{
+    alignedFree(t_memory);
+}
+
+void operator delete[](void* t_memory, std::align_val_t) noexcept
+{
+    alignedFree(t_memory);
+}
+
+void operator delete(void* t_memory, std::size_t, std::align_val_t) noexcept
+{
+    alignedFree(t_memory);
+}
+
+void operator delete[](void* t_memory, std::size_t, std::align_val_t) noexcept
+{
+    alignedFree(t_memory);
+}
+
+void operator delete(void* t_memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    alignedFree(t_memory);
+}
+
+void operator delete[](void* t_memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    alignedFree(t_memory);
+}
+#endif
+
+namespace AllocationCounter
+{
+    std::uint64_t getCount()
+    {
+#ifdef _DEBUG
+        return s_allocations;
+#else
+        return 0;
+#endif
+    }
+}
+
+NoAllocationScope::NoAllocationScope() :
+    m_start(AllocationCounter::getCount())
+{
+}
+
+NoAllocationScope::~NoAllocationScope()
+{
+    assert(AllocationCounter::getCount() == m_start && "heap allocation inside a NoAllocationScope");
+}
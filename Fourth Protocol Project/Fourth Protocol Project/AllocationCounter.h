@@ -0,0 +1,44 @@
+/**
+ * @file AllocationCounter.h
+ * @brief Counts heap allocations in debug builds
+ * @authors: Kyle & Monika
+ *
+ * In _DEBUG builds every global operator new (plain, nothrow and aligned)
+ * is replaced with one that counts calls per thread, so code that
+ * promises not to allocate can assert it. Release builds keep the normal operator new and count nothing.
+ */
+
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+#include <cstdint>
+
+namespace AllocationCounter
+{
+    /**
+     * @brief Gets how many allocations this thread has made
+     * @return Allocation count (always 0 outside _DEBUG builds)
+     */
+    std::uint64_t getCount();
+}
+
+/**
+ * @class NoAllocationScope
+ * @brief Asserts that nothing on this thread allocates while it is alive
+ *
+ * Only checks in _DEBUG builds, anywhere else it does nothing
+ */
+class NoAllocationScope
+{
+public:
+    NoAllocationScope();
+    ~NoAllocationScope();
+
+    NoAllocationScope(const NoAllocationScope&) = delete;
+    NoAllocationScope& operator=(const NoAllocationScope&) = delete;
+
+private:
+    std::uint64_t m_start;  ///< Count when the scope was entered
+};
+
+#endif
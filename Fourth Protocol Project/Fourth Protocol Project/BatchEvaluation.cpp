@@ -0,0 +1,415 @@
+#include "BatchEvaluation.h"
+#include "Evaluation.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BATCH_EVALUATION_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// gcc and clang only emit AVX2 inside functions marked for it, msvc allows it anywhere
+#if defined(__GNUC__)
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define AVX2_FUNCTION
+#endif
+
+namespace
+{
+    static const int NUM_RINGS = 5;     // centre distances 0 to 4
+    static const int CENTER_SQUARE = NUM_SQUARES / 2;
+
+    // window scores split out of WINDOW_PATTERNS into flat int tables so lanes can gather them
+    constexpr std::array<std::array<int, NUM_PATTERNS>, 2> buildPatternScores()
+    {
+        std::array<std::array<int, NUM_PATTERNS>, 2> scores{};
+        for (int player = 0; player < 2; ++player)
+            for (int index = 0; index < NUM_PATTERNS; ++index)
+                scores[player][index] = WINDOW_PATTERNS[index].scores[player];
+        return scores;
+    }
+
+    // our four in the low byte, theirs in the next one
+    constexpr std::array<std::array<int, NUM_PATTERNS>, 2> buildFourFlags()
+    {
+        std::array<std::array<int, NUM_PATTERNS>, 2> flags{};
+        for (int player = 0; player < 2; ++player)
+            for (int index = 0; index < NUM_PATTERNS; ++index)
+                flags[player][index] = WINDOW_PATTERNS[index].fours[player] | (WINDOW_PATTERNS[index].fours[1 - player] << 8);
+        return flags;
+    }
+
+    // cells grouped by distance from the centre, since every cell in a group scores the same
+    constexpr std::array<Bitboard, NUM_RINGS> buildRings()
+    {
+        std::array<Bitboard, NUM_RINGS> rings{};
+        for (int square = 0; square < NUM_SQUARES; ++square)
+        {
+            int rowDist = square / GRID_SIZE - GRID_SIZE / 2;
+            int colDist = square % GRID_SIZE - GRID_SIZE / 2;
+            rings[(rowDist < 0 ? -rowDist : rowDist) + (colDist < 0 ? -colDist : colDist)] |= squareBit(square);
+        }
+        return rings;
+    }
+
+    constexpr std::array<std::array<int, NUM_PATTERNS>, 2> PATTERN_SCORES = buildPatternScores();
+    constexpr std::array<std::array<int, NUM_PATTERNS>, 2> FOUR_FLAGS = buildFourFlags();
+    constexpr std::array<Bitboard, NUM_RINGS> RINGS = buildRings();
+
+    // neighbour pairs are counted once each, looking right, down and along both downward diagonals.
+    // the mask keeps cells whose neighbour that way is on the board (and not wrapped to the next row)
+    static const int NUM_PAIR_DIRECTIONS = 4;
+    constexpr int PAIR_SHIFTS[NUM_PAIR_DIRECTIONS] = { 1, GRID_SIZE, GRID_SIZE + 1, GRID_SIZE - 1 };
+
+    constexpr std::array<Bitboard, NUM_PAIR_DIRECTIONS> buildPairMasks()
+    {
+        std::array<Bitboard, NUM_PAIR_DIRECTIONS> masks{};
+        for (int square = 0; square < NUM_SQUARES; ++square)
+        {
+            int row = square / GRID_SIZE;
+            int col = square % GRID_SIZE;
+            if (col < GRID_SIZE - 1)
+                masks[0] |= squareBit(square);
+            if (row < GRID_SIZE - 1)
+                masks[1] |= squareBit(square);
+            if (row < GRID_SIZE - 1 && col < GRID_SIZE - 1)
+                masks[2] |= squareBit(square);
+            if (row < GRID_SIZE - 1 && col > 0)
+                masks[3] |= squareBit(square);
+        }
+        return masks;
+    }
+
+    constexpr std::array<Bitboard, NUM_PAIR_DIRECTIONS> PAIR_MASKS = buildPairMasks();
+
+    // same as Position's running piece score, worked out from scratch
+    int scorePieces(Bitboard t_pieces)
+    {
+        int score = ((t_pieces >> CENTER_SQUARE) & 1) * CENTER_BONUS;
+        for (int ring = 0; ring < NUM_RINGS; ++ring)
+        {
+            score += popCount(t_pieces & RINGS[ring]) * (8 - ring) * CENTER_WEIGHT;
+        }
+
+        int pairs = 0;
+        for (int dir = 0; dir < NUM_PAIR_DIRECTIONS; ++dir)
+        {
+            pairs += popCount(t_pieces & PAIR_MASKS[dir] & (t_pieces >> PAIR_SHIFTS[dir]));
+        }
+        return score + 2 * pairs * ADJACENT_WEIGHT;
+    }
+
+    int evaluateOne(Bitboard t_playerOne, Bitboard t_playerTwo, int t_ai)
+    {
+        int score = 0;
+        int fours = 0;
+        for (int line = 0; line < NUM_WIN_LINES; ++line)
+        {
+            int index = getWindowPattern(t_playerOne, t_playerTwo, line);
+            score += PATTERN_SCORES[t_ai][index];
+            fours |= FOUR_FLAGS[t_ai][index];
+        }
+
+        if (fours & 0xFF)
+            return WIN_SCORE;
+        if (fours)
+            return LOSE_SCORE;
+
+        int ours = scorePieces(t_ai == 0 ? t_playerOne : t_playerTwo);
+        int theirs = scorePieces(t_ai == 0 ? t_playerTwo : t_playerOne);
+        return score + ours - theirs;
+    }
+
+    void evaluateScalar(PositionBatch& t_batch, int t_ai, int t_start)
+    {
+        for (int i = t_start; i < t_batch.size(); ++i)
+        {
+            t_batch.scores[i] = evaluateOne(t_batch.playerOne[i], t_batch.playerTwo[i], t_ai);
+        }
+    }
+
+#ifdef BATCH_EVALUATION_X86
+    // bit count of every 32-bit lane, no popcount instruction before AVX-512
+    __m128i popCount4(__m128i t_value)
+    {
+        const __m128i m1 = _mm_set1_epi32(0x55555555);
+        const __m128i m2 = _mm_set1_epi32(0x33333333);
+        const __m128i m4 = _mm_set1_epi32(0x0F0F0F0F);
+
+        __m128i x = _mm_sub_epi32(t_value, _mm_and_si128(_mm_srli_epi32(t_value, 1), m1));
+        x = _mm_add_epi32(_mm_and_si128(x, m2), _mm_and_si128(_mm_srli_epi32(x, 2), m2));
+        x = _mm_and_si128(_mm_add_epi32(x, _mm_srli_epi32(x, 4)), m4);
+        x = _mm_add_epi32(x, _mm_srli_epi32(x, 8));
+        x = _mm_add_epi32(x, _mm_srli_epi32(x, 16));
+        return _mm_and_si128(x, _mm_set1_epi32(0x3F));
+    }
+
+    // small constants only, so a 16-bit multiply is enough (SSE2 has no 32-bit one)
+    __m128i multiplySmall4(__m128i t_value, int t_factor)
+    {
+        return _mm_mullo_epi16(t_value, _mm_set1_epi32(t_factor));
+    }
+
+    __m128i scorePieces4(__m128i t_pieces)
+    {
+        __m128i centre = _mm_and_si128(_mm_srli_epi32(t_pieces, CENTER_SQUARE), _mm_set1_epi32(1));
+        __m128i score = multiplySmall4(centre, CENTER_BONUS);
+        for (int ring = 0; ring < NUM_RINGS; ++ring)
+        {
+            __m128i count = popCount4(_mm_and_si128(t_pieces, _mm_set1_epi32(static_cast<int>(RINGS[ring]))));
+            score = _mm_add_epi32(score, multiplySmall4(count, (8 - ring) * CENTER_WEIGHT));
+        }
+
+        __m128i pairs = _mm_setzero_si128();
+        for (int dir = 0; dir < NUM_PAIR_DIRECTIONS; ++dir)
+        {
+            __m128i shifted = _mm_srl_epi32(t_pieces, _mm_cvtsi32_si128(PAIR_SHIFTS[dir]));
+            __m128i both = _mm_and_si128(_mm_and_si128(t_pieces, shifted), _mm_set1_epi32(static_cast<int>(PAIR_MASKS[dir])));
+            pairs = _mm_add_epi32(pairs, popCount4(both));
+        }
+        return _mm_add_epi32(score, multiplySmall4(pairs, 2 * ADJACENT_WEIGHT));
+    }
+
+    // one base 3 digit per cell of the window, highest cell first so it can be built up times 3
+    __m128i windowPattern4(__m128i t_playerOne, __m128i t_playerTwo, int t_line)
+    {
+        const __m128i one = _mm_set1_epi32(1);
+        __m128i index = _mm_setzero_si128();
+        for (int cell = LINE_LENGTH - 1; cell >= 0; --cell)
+        {
+            __m128i shift = _mm_cvtsi32_si128(LINE_SQUARES[t_line][cell]);
+            __m128i digit = _mm_add_epi32(
+                _mm_and_si128(_mm_srl_epi32(t_playerOne, shift), one),
+                _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(t_playerTwo, shift), one), 1));
+            index = _mm_add_epi32(_mm_add_epi32(index, _mm_add_epi32(index, index)), digit);
+        }
+        return index;
+    }
+
+    int evaluateSse2(PositionBatch& t_batch, int t_ai)
+    {
+        const int* patternScores = PATTERN_SCORES[t_ai].data();
+        const int* fourFlags = FOUR_FLAGS[t_ai].data();
+        int count = t_batch.size() & ~3;
+
+        for (int i = 0; i < count; i += 4)
+        {
+            __m128i playerOne = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&t_batch.playerOne[i]));
+            __m128i playerTwo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&t_batch.playerTwo[i]));
+
+            // no gather in SSE2, so the indexes are built four at a time and looked up one by one
+            alignas(16) int indexes[4];
+            int windowScores[4] = { 0, 0, 0, 0 };
+            int fours[4] = { 0, 0, 0, 0 };
+            for (int line = 0; line < NUM_WIN_LINES; ++line)
+            {
+                _mm_store_si128(reinterpret_cast<__m128i*>(indexes), windowPattern4(playerOne, playerTwo, line));
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    windowScores[lane] += patternScores[indexes[lane]];
+                    fours[lane] |= fourFlags[indexes[lane]];
+                }
+            }
+
+            __m128i ours = (t_ai == 0) ? playerOne : playerTwo;
+            __m128i theirs = (t_ai == 0) ? playerTwo : playerOne;
+            __m128i score = _mm_sub_epi32(scorePieces4(ours), scorePieces4(theirs));
+            score = _mm_add_epi32(score, _mm_loadu_si128(reinterpret_cast<const __m128i*>(windowScores)));
+
+            // a four overrides everything, ours first
+            __m128i flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fours));
+            __m128i lost = _mm_cmpgt_epi32(_mm_srli_epi32(flags, 8), _mm_setzero_si128());
+            __m128i won = _mm_cmpgt_epi32(_mm_and_si128(flags, _mm_set1_epi32(0xFF)), _mm_setzero_si128());
+            score = _mm_or_si128(_mm_andnot_si128(lost, score), _mm_and_si128(lost, _mm_set1_epi32(LOSE_SCORE)));
+            score = _mm_or_si128(_mm_andnot_si128(won, score), _mm_and_si128(won, _mm_set1_epi32(WIN_SCORE)));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&t_batch.scores[i]), score);
+        }
+
+        return count;
+    }
+
+    AVX2_FUNCTION __m256i popCount8(__m256i t_value)
+    {
+        // nibble lookup, 4 bits at a time through a shuffle
+        const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low = _mm256_set1_epi8(0x0F);
+
+        __m256i counts = _mm256_add_epi8(
+            _mm256_shuffle_epi8(lookup, _mm256_and_si256(t_value, low)),
+            _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi32(t_value, 4), low)));
+
+        // add the 4 byte counts of each lane together
+        return _mm256_srli_epi32(_mm256_mullo_epi32(counts, _mm256_set1_epi32(0x01010101)), 24);
+    }
+
+    AVX2_FUNCTION __m256i scorePieces8(__m256i t_pieces)
+    {
+        __m256i centre = _mm256_and_si256(_mm256_srli_epi32(t_pieces, CENTER_SQUARE), _mm256_set1_epi32(1));
+        __m256i score = _mm256_mullo_epi32(centre, _mm256_set1_epi32(CENTER_BONUS));
+        for (int ring = 0; ring < NUM_RINGS; ++ring)
+        {
+            __m256i count = popCount8(_mm256_and_si256(t_pieces, _mm256_set1_epi32(static_cast<int>(RINGS[ring]))));
+            score = _mm256_add_epi32(score, _mm256_mullo_epi32(count, _mm256_set1_epi32((8 - ring) * CENTER_WEIGHT)));
+        }
+
+        __m256i pairs = _mm256_setzero_si256();
+        for (int dir = 0; dir < NUM_PAIR_DIRECTIONS; ++dir)
+        {
+            __m256i shifted = _mm256_srl_epi32(t_pieces, _mm_cvtsi32_si128(PAIR_SHIFTS[dir]));
+            __m256i both = _mm256_and_si256(_mm256_and_si256(t_pieces, shifted), _mm256_set1_epi32(static_cast<int>(PAIR_MASKS[dir])));
+            pairs = _mm256_add_epi32(pairs, popCount8(both));
+        }
+        return _mm256_add_epi32(score, _mm256_mullo_epi32(pairs, _mm256_set1_epi32(2 * ADJACENT_WEIGHT)));
+    }
+
+    AVX2_FUNCTION __m256i windowPattern8(__m256i t_playerOne, __m256i t_playerTwo, int t_line)
+    {
+        const __m256i one = _mm256_set1_epi32(1);
+        __m256i index = _mm256_setzero_si256();
+        for (int cell = LINE_LENGTH - 1; cell >= 0; --cell)
+        {
+            __m128i shift = _mm_cvtsi32_si128(LINE_SQUARES[t_line][cell]);
+            __m256i digit = _mm256_add_epi32(
+                _mm256_and_si256(_mm256_srl_epi32(t_playerOne, shift), one),
+                _mm256_slli_epi32(_mm256_and_si256(_mm256_srl_epi32(t_playerTwo, shift), one), 1));
+            index = _mm256_add_epi32(_mm256_add_epi32(index, _mm256_add_epi32(index, index)), digit);
+        }
+        return index;
+    }
+
+    AVX2_FUNCTION int evaluateAvx2(PositionBatch& t_batch, int t_ai)
+    {
+        const int* patternScores = PATTERN_SCORES[t_ai].data();
+        const int* fourFlags = FOUR_FLAGS[t_ai].data();
+        int count = t_batch.size() & ~7;
+
+        for (int i = 0; i < count; i += 8)
+        {
+            __m256i playerOne = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&t_batch.playerOne[i]));
+            __m256i playerTwo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&t_batch.playerTwo[i]));
+
+            __m256i score = _mm256_setzero_si256();
+            __m256i flags = _mm256_setzero_si256();
+            for (int line = 0; line < NUM_WIN_LINES; ++line)
+            {
+                __m256i index = windowPattern8(playerOne, playerTwo, line);
+                score = _mm256_add_epi32(score, _mm256_i32gather_epi32(patternScores, index, 4));
+                flags = _mm256_or_si256(flags, _mm256_i32gather_epi32(fourFlags, index, 4));
+            }
+
+            __m256i ours = (t_ai == 0) ? playerOne : playerTwo;
+            __m256i theirs = (t_ai == 0) ? playerTwo : playerOne;
+            score = _mm256_add_epi32(score, _mm256_sub_epi32(scorePieces8(ours), scorePieces8(theirs)));
+
+            // a four overrides everything, ours first
+            __m256i lost = _mm256_cmpgt_epi32(_mm256_srli_epi32(flags, 8), _mm256_setzero_si256());
+            __m256i won = _mm256_cmpgt_epi32(_mm256_and_si256(flags, _mm256_set1_epi32(0xFF)), _mm256_setzero_si256());
+            score = _mm256_blendv_epi8(score, _mm256_set1_epi32(LOSE_SCORE), lost);
+            score = _mm256_blendv_epi8(score, _mm256_set1_epi32(WIN_SCORE), won);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&t_batch.scores[i]), score);
+        }
+
+        return count;
+    }
+
+    SimdLevel detectLevel()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        bool hasSse2 = (info[3] & (1 << 26)) != 0;
+        bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+        if (maxLeaf >= 7 && osSavesAvx && (_xgetbv(0) & 6) == 6)
+        {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5))
+            {
+                return SimdLevel::AVX2;
+            }
+        }
+        return hasSse2 ? SimdLevel::SSE2 : SimdLevel::SCALAR;
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return SimdLevel::AVX2;
+        }
+        return __builtin_cpu_supports("sse2") ? SimdLevel::SSE2 : SimdLevel::SCALAR;
+#endif
+    }
+#else
+    SimdLevel detectLevel()
+    {
+        return SimdLevel::SCALAR;
+    }
+#endif
+}
+
+void PositionBatch::add(const Position& t_position)
+{
+    playerOne.push_back(t_position.getPlayerMask(Player::PLAYER_ONE));
+    playerTwo.push_back(t_position.getPlayerMask(Player::PLAYER_TWO));
+}
+
+void PositionBatch::clear()
+{
+    playerOne.clear();
+    playerTwo.clear();
+    scores.clear();
+}
+
+namespace BatchEvaluation
+{
+    SimdLevel getBestLevel()
+    {
+        static const SimdLevel level = detectLevel();
+        return level;
+    }
+
+    const char* getLevelName(SimdLevel t_level)
+    {
+        switch (t_level)
+        {
+        case SimdLevel::AVX2:
+            return "AVX2";
+        case SimdLevel::SSE2:
+            return "SSE2";
+        default:
+            return "scalar";
+        }
+    }
+
+    void evaluateBatch(PositionBatch& t_batch, Player t_aiPlayer, SimdLevel t_level)
+    {
+        int ai = (t_aiPlayer == Player::PLAYER_ONE) ? 0 : 1;
+        t_batch.scores.resize(t_batch.playerOne.size());
+
+        // cant run what the CPU doesnt have
+        if (static_cast<int>(t_level) > static_cast<int>(getBestLevel()))
+        {
+            t_level = getBestLevel();
+        }
+
+        // the vector paths do whole registers, whatever is left over goes through the scalar one
+        int done = 0;
+#ifdef BATCH_EVALUATION_X86
+        if (t_level == SimdLevel::AVX2)
+        {
+            done = evaluateAvx2(t_batch, ai);
+        }
+        else if (t_level == SimdLevel::SSE2)
+        {
+            done = evaluateSse2(t_batch, ai);
+        }
+#endif
+        evaluateScalar(t_batch, ai, done);
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * @file BatchEvaluation.h
+ * @brief Evaluates many positions in one call using SIMD lanes
+ * @authors: Kyle & Monika
+ *
+ * Playouts, self-play and offline analysis score far more positions than
+ * the search does one at a time. Here the positions are stored as separate
+ * arrays of player one and player two masks (structure of arrays), so 4
+ * (SSE2) or 8 (AVX2) positions sit side by side in a register and every
+ * window and piece term is worked out for all of them at once.
+ */
+
+#ifndef BATCH_EVALUATION_HPP
+#define BATCH_EVALUATION_HPP
+
+#include <vector>
+#include "Position.h"
+
+/**
+ * @enum SimdLevel
+ * @brief Which instruction set the batch evaluation runs on
+ */
+enum class SimdLevel
+{
+    SCALAR,     ///< One position at a time, works everywhere
+    SSE2,       ///< 4 positions per register
+    AVX2        ///< 8 positions per register, windows looked up with gathers
+};
+
+/**
+ * @struct PositionBatch
+ * @brief Positions to evaluate, one array per mask
+ */
+struct PositionBatch
+{
+    std::vector<Bitboard> playerOne;    ///< Player one's pieces, one entry per position
+    std::vector<Bitboard> playerTwo;    ///< Player two's pieces, one entry per position
+    std::vector<int> scores;            ///< Filled in by evaluateBatch
+
+    /**
+     * @brief Adds a position to the end of the batch
+     * @param t_position Position to add
+     */
+    void add(const Position& t_position);
+
+    /**
+     * @brief Empties the batch, keeping the memory
+     */
+    void clear();
+
+    int size() const { return static_cast<int>(playerOne.size()); }
+};
+
+namespace BatchEvaluation
+{
+    /**
+     * @brief Gets the fastest level this CPU supports
+     * @return AVX2, SSE2 or SCALAR
+     */
+    SimdLevel getBestLevel();
+
+    /**
+     * @brief Gets a level's name for printing
+     * @param t_level Level to name
+     * @return "scalar", "SSE2" or "AVX2"
+     */
+    const char* getLevelName(SimdLevel t_level);
+
+    /**
+     * @brief Scores every position in the batch
+     * @param t_batch Positions to score, scores are written to t_batch.scores
+     * @param t_aiPlayer Side the scores are from
+     * @param t_level Instruction set to use (dropped to the best supported if too high)
+     *
+     * Gives the same score as AI::evaluateBoard apart from mobility, which
+     * needs the piece types and a frog's jumps depend on the whole board.
+     * That is getLineScore plus our getPieceScore minus theirs, or
+     * WIN_SCORE / LOSE_SCORE when someone has a four.
+     */
+    void evaluateBatch(PositionBatch& t_batch, Player t_aiPlayer, SimdLevel t_level);
+
+    /**
+     * @brief Scores every position in the batch with the best level available
+     * @param t_batch Positions to score, scores are written to t_batch.scores
+     * @param t_aiPlayer Side the scores are from
+     */
+    inline void evaluateBatch(PositionBatch& t_batch, Player t_aiPlayer)
+    {
+        evaluateBatch(t_batch, t_aiPlayer, getBestLevel());
+    }
+}
+
+#endif
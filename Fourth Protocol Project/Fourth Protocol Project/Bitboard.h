@@ -0,0 +1,360 @@
+/**
+ * @file Bitboard.h
+ * @brief 25-bit board masks and the lookup tables built from them
+ * @authors: Kyle & Monika
+ *
+ * Each cell is one bit, numbered row * GRID_SIZE + col, so the whole 5x5
+ * board fits in the low 25 bits of a 32-bit integer. The tables in here are
+ * all worked out at compile time.
+ */
+
+#ifndef BITBOARD_HPP
+#define BITBOARD_HPP
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include "Constants.h"
+
+typedef std::uint32_t Bitboard;    ///< One bit per cell
+
+static const int NUM_SQUARES = GRID_SIZE * GRID_SIZE;                  ///< Number of cells on the board
+static const Bitboard FULL_BOARD = (Bitboard(1) << NUM_SQUARES) - 1;   ///< Every cell set
+
+/**
+ * @brief Gets the mask for a single cell
+ * @param t_square Cell index (row * GRID_SIZE + col)
+ * @return Mask with just that cell set
+ */
+constexpr Bitboard squareBit(int t_square)
+{
+    return Bitboard(1) << t_square;
+}
+
+/**
+ * @brief Counts the cells set in a mask
+ * @param t_mask Mask to count
+ * @return Number of set cells
+ */
+constexpr int popCount(Bitboard t_mask)
+{
+    return std::popcount(t_mask);
+}
+
+/**
+ * @brief Removes the lowest set cell from a mask
+ * @param t_mask Mask to take the cell from, must not be empty
+ * @return Index of the cell that was removed
+ */
+inline int popLowest(Bitboard& t_mask)
+{
+    int square = std::countr_zero(t_mask);
+    t_mask &= t_mask - 1;
+    return square;
+}
+
+namespace BitboardTables
+{
+    /**
+     * @brief Builds the mask of cells one step away from each cell
+     * @param t_diagonals True to include diagonal steps
+     * @return One mask per cell
+     */
+    constexpr std::array<Bitboard, NUM_SQUARES> buildStepMasks(bool t_diagonals)
+    {
+        std::array<Bitboard, NUM_SQUARES> masks{};
+
+        for (int square = 0; square < NUM_SQUARES; ++square)
+        {
+            int row = square / GRID_SIZE;
+            int col = square % GRID_SIZE;
+
+            for (int dr = -1; dr <= 1; ++dr)
+            {
+                for (int dc = -1; dc <= 1; ++dc)
+                {
+                    if (dr == 0 && dc == 0)
+                        continue;
+                    if (!t_diagonals && dr != 0 && dc != 0)
+                        continue;
+
+                    int newRow = row + dr;
+                    int newCol = col + dc;
+                    if (newRow >= 0 && newRow < GRID_SIZE && newCol >= 0 && newCol < GRID_SIZE)
+                    {
+                        masks[square] |= squareBit(newRow * GRID_SIZE + newCol);
+                    }
+                }
+            }
+        }
+
+        return masks;
+    }
+}
+
+/// Cells a donkey can step to from each cell (up, down, left, right)
+inline constexpr std::array<Bitboard, NUM_SQUARES> ORTHOGONAL_STEPS = BitboardTables::buildStepMasks(false);
+
+/// Cells a snake can step to from each cell (all 8 neighbours)
+inline constexpr std::array<Bitboard, NUM_SQUARES> KING_STEPS = BitboardTables::buildStepMasks(true);
+
+static const int NUM_DIRECTIONS = 8;              ///< Straight and diagonal directions
+static const int MAX_RAY_LENGTH = GRID_SIZE - 1;  ///< Most cells a ray can cover
+
+/**
+ * @struct Ray
+ * @brief The cells in one direction from a cell, nearest first
+ */
+struct Ray
+{
+    int length;                         ///< Number of cells before the edge
+    int squares[MAX_RAY_LENGTH];        ///< Cell indexes along the ray
+};
+
+namespace BitboardTables
+{
+    /// Row and column step for each of the 8 directions
+    constexpr int DIRECTION_STEPS[NUM_DIRECTIONS][2] = {
+        {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}
+    };
+
+    /**
+     * @brief Builds the ray in every direction from every cell
+     * @return Rays indexed by [cell][direction]
+     */
+    constexpr std::array<std::array<Ray, NUM_DIRECTIONS>, NUM_SQUARES> buildRays()
+    {
+        std::array<std::array<Ray, NUM_DIRECTIONS>, NUM_SQUARES> rays{};
+
+        for (int square = 0; square < NUM_SQUARES; ++square)
+        {
+            for (int dir = 0; dir < NUM_DIRECTIONS; ++dir)
+            {
+                Ray& ray = rays[square][dir];
+                int row = square / GRID_SIZE + DIRECTION_STEPS[dir][0];
+                int col = square % GRID_SIZE + DIRECTION_STEPS[dir][1];
+
+                while (row >= 0 && row < GRID_SIZE && col >= 0 && col < GRID_SIZE)
+                {
+                    ray.squares[ray.length++] = row * GRID_SIZE + col;
+                    row += DIRECTION_STEPS[dir][0];
+                    col += DIRECTION_STEPS[dir][1];
+                }
+            }
+        }
+
+        return rays;
+    }
+
+    /**
+     * @brief Builds where a frog ends up for every ray and ray occupancy
+     * @param t_rays Rays from buildRays()
+     * @return Destination masks indexed by [cell][direction][occupancy]
+     *
+     * Occupancy bit k is set when the k-th cell along the ray has a piece.
+     * If the nearest cell is empty the frog steps onto it, otherwise it jumps
+     * the whole run of pieces and lands on the first empty cell behind them.
+     * A run that reaches the edge leaves the frog with nowhere to go.
+     */
+    constexpr std::array<std::array<std::array<Bitboard, 1 << MAX_RAY_LENGTH>, NUM_DIRECTIONS>, NUM_SQUARES>
+        buildFrogDestinations(const std::array<std::array<Ray, NUM_DIRECTIONS>, NUM_SQUARES>& t_rays)
+    {
+        std::array<std::array<std::array<Bitboard, 1 << MAX_RAY_LENGTH>, NUM_DIRECTIONS>, NUM_SQUARES> table{};
+
+        for (int square = 0; square < NUM_SQUARES; ++square)
+        {
+            for (int dir = 0; dir < NUM_DIRECTIONS; ++dir)
+            {
+                const Ray& ray = t_rays[square][dir];
+
+                for (int occupancy = 0; occupancy < (1 << ray.length); ++occupancy)
+                {
+                    int landing = 0;
+                    while (landing < ray.length && (occupancy & (1 << landing)))
+                    {
+                        ++landing;
+                    }
+
+                    if (landing < ray.length)
+                    {
+                        table[square][dir][occupancy] = squareBit(ray.squares[landing]);
+                    }
+                }
+            }
+        }
+
+        return table;
+    }
+}
+
+/// Cells in each direction from each cell, indexed by [cell][direction]
+inline constexpr std::array<std::array<Ray, NUM_DIRECTIONS>, NUM_SQUARES> RAYS = BitboardTables::buildRays();
+
+/// Frog destination for each ray occupancy, indexed by [cell][direction][occupancy]
+inline constexpr std::array<std::array<std::array<Bitboard, 1 << MAX_RAY_LENGTH>, NUM_DIRECTIONS>, NUM_SQUARES>
+    FROG_DESTINATIONS = BitboardTables::buildFrogDestinations(RAYS);
+
+/**
+ * @brief Gets every cell a frog can reach, steps and jumps together
+ * @param t_square Cell the frog is on
+ * @param t_occupied Mask of every occupied cell
+ * @return Mask of legal frog destinations
+ */
+inline Bitboard getFrogTargets(int t_square, Bitboard t_occupied)
+{
+    Bitboard targets = 0;
+
+    for (int dir = 0; dir < NUM_DIRECTIONS; ++dir)
+    {
+        const Ray& ray = RAYS[t_square][dir];
+
+        // pack the pieces along the ray into a table index
+        int occupancy = 0;
+        for (int i = 0; i < ray.length; ++i)
+        {
+            occupancy |= ((t_occupied >> ray.squares[i]) & 1) << i;
+        }
+
+        targets |= FROG_DESTINATIONS[t_square][dir][occupancy];
+    }
+
+    return targets;
+}
+
+static const int LINE_LENGTH = 4;           ///< Pieces in a row needed to win
+static const int NUM_WIN_LINES = 28;        ///< Every four-in-a-row window on the board
+static const int MAX_LINES_PER_SQUARE = 8;  ///< Most windows that pass through one cell
+
+/**
+ * @struct LinesThrough
+ * @brief The win windows that pass through one cell
+ */
+struct LinesThrough
+{
+    int count;                              ///< Number of windows through the cell
+    int lines[MAX_LINES_PER_SQUARE];        ///< Indexes into WIN_LINES
+};
+
+namespace BitboardTables
+{
+    /**
+     * @brief Builds the mask of every four-in-a-row window
+     * @return Window masks, horizontal then vertical then both diagonals
+     */
+    constexpr std::array<Bitboard, NUM_WIN_LINES> buildWinLines()
+    {
+        std::array<Bitboard, NUM_WIN_LINES> lines{};
+        const int directions[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+        int count = 0;
+
+        for (const auto& dir : directions)
+        {
+            for (int row = 0; row < GRID_SIZE; ++row)
+            {
+                for (int col = 0; col < GRID_SIZE; ++col)
+                {
+                    int endRow = row + (LINE_LENGTH - 1) * dir[0];
+                    int endCol = col + (LINE_LENGTH - 1) * dir[1];
+                    if (endRow < 0 || endRow >= GRID_SIZE || endCol < 0 || endCol >= GRID_SIZE)
+                        continue;
+
+                    Bitboard line = 0;
+                    for (int i = 0; i < LINE_LENGTH; ++i)
+                    {
+                        line |= squareBit((row + i * dir[0]) * GRID_SIZE + (col + i * dir[1]));
+                    }
+                    lines[count++] = line;
+                }
+            }
+        }
+
+        return lines;
+    }
+
+    /**
+     * @brief Builds the list of windows through each cell
+     * @param t_lines Windows from buildWinLines()
+     * @return Window lists indexed by cell
+     */
+    constexpr std::array<LinesThrough, NUM_SQUARES> buildLinesThrough(const std::array<Bitboard, NUM_WIN_LINES>& t_lines)
+    {
+        std::array<LinesThrough, NUM_SQUARES> through{};
+
+        for (int square = 0; square < NUM_SQUARES; ++square)
+        {
+            for (int line = 0; line < NUM_WIN_LINES; ++line)
+            {
+                if (t_lines[line] & squareBit(square))
+                {
+                    through[square].lines[through[square].count++] = line;
+                }
+            }
+        }
+
+        return through;
+    }
+}
+
+/// Every four-in-a-row window as a mask
+inline constexpr std::array<Bitboard, NUM_WIN_LINES> WIN_LINES = BitboardTables::buildWinLines();
+
+/// Windows through each cell, so a move only has to check its own windows
+inline constexpr std::array<LinesThrough, NUM_SQUARES> LINES_THROUGH = BitboardTables::buildLinesThrough(WIN_LINES);
+
+/**
+ * @brief Checks if a player has a full window through a cell
+ * @param t_pieces Mask of the player's pieces
+ * @param t_square Cell that just changed
+ * @return True if one of the windows through the cell is full
+ */
+inline bool hasLineThrough(Bitboard t_pieces, int t_square)
+{
+    const LinesThrough& through = LINES_THROUGH[t_square];
+    for (int i = 0; i < through.count; ++i)
+    {
+        Bitboard line = WIN_LINES[through.lines[i]];
+        if ((t_pieces & line) == line)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Checks if a player has a full window anywhere
+ * @param t_pieces Mask of the player's pieces
+ * @return True if any window is full
+ */
+inline bool hasAnyLine(Bitboard t_pieces)
+{
+    for (Bitboard line : WIN_LINES)
+    {
+        if ((t_pieces & line) == line)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Finds the cells that would finish a window for a player
+ * @param t_pieces Mask of the player's pieces
+ * @param t_empty Mask of the empty cells
+ * @return Empty cells that complete a window holding three of the player's pieces
+ */
+inline Bitboard getThreatCells(Bitboard t_pieces, Bitboard t_empty)
+{
+    Bitboard cells = 0;
+    for (Bitboard line : WIN_LINES)
+    {
+        if (popCount(t_pieces & line) == LINE_LENGTH - 1)
+        {
+            cells |= line & t_empty;
+        }
+    }
+    return cells;
+}
+
+#endif
@@ -0,0 +1,174 @@
+#include "Compression.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+static const std::size_t MIN_MATCH = 4;         ///< Shortest copy worth a token and an offset
+static const std::size_t MAX_OFFSET = 65535;    ///< Furthest back a 2 byte offset reaches
+static const int HASH_BITS = 12;                ///< Size of the table of where each 4 bytes was last seen
+
+// writes a length that didnt fit in its 4 bits
+static void writeLength(std::size_t t_length, std::vector<unsigned char>& t_output)
+{
+    while (t_length >= 255)
+    {
+        t_output.push_back(255);
+        t_length -= 255;
+    }
+    t_output.push_back(static_cast<unsigned char>(t_length));
+}
+
+// reads the rest of a length whose 4 bits were all set
+static bool readLength(const unsigned char* t_input, std::size_t t_inputSize, std::size_t& t_position, std::size_t& t_length)
+{
+    unsigned char byte;
+    do
+    {
+        if (t_position >= t_inputSize)
+        {
+            return false;
+        }
+        byte = t_input[t_position++];
+        t_length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+static void writeSequence(const unsigned char* t_literals, std::size_t t_literalCount, std::size_t t_matchLength, std::size_t t_offset, std::vector<unsigned char>& t_output)
+{
+    std::size_t matchCode = (t_matchLength > 0) ? t_matchLength - MIN_MATCH : 0;
+    unsigned char token = static_cast<unsigned char>(((t_literalCount < 15) ? t_literalCount : 15) << 4);
+    token |= static_cast<unsigned char>((matchCode < 15) ? matchCode : 15);
+    t_output.push_back(token);
+
+    if (t_literalCount >= 15)
+    {
+        writeLength(t_literalCount - 15, t_output);
+    }
+    t_output.insert(t_output.end(), t_literals, t_literals + t_literalCount);
+
+    if (t_matchLength == 0)
+    {
+        return;
+    }
+    t_output.push_back(static_cast<unsigned char>(t_offset & 0xFF));
+    t_output.push_back(static_cast<unsigned char>(t_offset >> 8));
+    if (matchCode >= 15)
+    {
+        writeLength(matchCode - 15, t_output);
+    }
+}
+
+static std::uint32_t read32(const unsigned char* t_bytes)
+{
+    std::uint32_t value;
+    std::memcpy(&value, t_bytes, sizeof(value));
+    return value;
+}
+
+namespace Compression
+{
+    void compress(const unsigned char* t_input, std::size_t t_size, std::vector<unsigned char>& t_output)
+    {
+        t_output.clear();
+
+        // where each hash of 4 bytes was last seen, one past it so 0 means never
+        std::vector<std::size_t> lastSeen(std::size_t(1) << HASH_BITS, 0);
+
+        std::size_t literalStart = 0;
+        std::size_t position = 0;
+        while (position + MIN_MATCH <= t_size)
+        {
+            std::uint32_t bytes = read32(t_input + position);
+            std::uint32_t hash = (bytes * 2654435761u) >> (32 - HASH_BITS);
+            std::size_t candidate = lastSeen[hash];
+            lastSeen[hash] = position + 1;
+
+            // greedy, the first match found is taken as far as it goes
+            if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET || read32(t_input + candidate - 1) != bytes)
+            {
+                ++position;
+                continue;
+            }
+
+            std::size_t from = candidate - 1;
+            std::size_t length = MIN_MATCH;
+            while (position + length < t_size && t_input[from + length] == t_input[position + length])
+            {
+                ++length;
+            }
+
+            writeSequence(t_input + literalStart, position - literalStart, length, position - from, t_output);
+            position += length;
+            literalStart = position;
+        }
+
+        if (literalStart < t_size || t_size == 0)
+        {
+            writeSequence(t_input + literalStart, t_size - literalStart, 0, 0, t_output);
+        }
+    }
+
+    bool decompress(const unsigned char* t_input, std::size_t t_inputSize, unsigned char* t_output, std::size_t t_outputSize)
+    {
+        std::size_t in = 0;
+        std::size_t out = 0;
+        while (in < t_inputSize)
+        {
+            unsigned char token = t_input[in++];
+
+            std::size_t literals = token >> 4;
+            if (literals == 15 && !readLength(t_input, t_inputSize, in, literals))
+            {
+                return false;
+            }
+            if (literals > t_inputSize - in || literals > t_outputSize - out)
+            {
+                return false;
+            }
+            std::memcpy(t_output + out, t_input + in, literals);
+            in += literals;
+            out += literals;
+
+            // only the last sequence stops after its literals
+            if (in == t_inputSize)
+            {
+                break;
+            }
+
+            if (t_inputSize - in < 2)
+            {
+                return false;
+            }
+            std::size_t offset = t_input[in] | (static_cast<std::size_t>(t_input[in + 1]) << 8);
+            in += 2;
+
+            std::size_t length = token & 15;
+            if (length == 15 && !readLength(t_input, t_inputSize, in, length))
+            {
+                return false;
+            }
+            length += MIN_MATCH;
+            if (offset == 0 || offset > out || length > t_outputSize - out)
+            {
+                return false;
+            }
+
+            // a short offset repeats the last few bytes, each copy doubles how far back the
+            // repeat can be taken from so a long run is a handful of copies rather than a byte at a time
+            unsigned char* target = t_output + out;
+            std::size_t copied = 0;
+            std::size_t distance = offset;
+            while (copied < length)
+            {
+                std::size_t bytes = std::min(distance, length - copied);
+                std::memcpy(target + copied, target + copied - distance, bytes);
+                copied += bytes;
+                distance *= 2;
+            }
+            out += length;
+        }
+
+        return out == t_outputSize;
+    }
+}
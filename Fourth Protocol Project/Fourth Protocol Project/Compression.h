@@ -0,0 +1,45 @@
+/**
+ * @file Compression.h
+ * @brief Small byte compressor for tablebase blocks
+ * @authors: Kyle & Monika
+ *
+ * An LZ77 in the same shape as LZ4: each sequence is a token byte (literal
+ * count in the top 4 bits, match length in the bottom 4), any extra length
+ * as bytes of 255 and a remainder, the literals, then a 2 byte offset back
+ * into what was already written and any extra match length. The last
+ * sequence can stop after its literals. Tablebase results repeat a lot
+ * (long runs of draws, wins and losses swapping with the side to move), so
+ * copying from a little way back does nearly all the work, and decoding is
+ * just copies so a 16KB block comes back in a few microseconds.
+ */
+
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace Compression
+{
+    /**
+     * @brief Compresses a buffer
+     * @param t_input Bytes to compress
+     * @param t_size Number of bytes
+     * @param t_output Replaced with the compressed bytes
+     */
+    void compress(const unsigned char* t_input, std::size_t t_size, std::vector<unsigned char>& t_output);
+
+    /**
+     * @brief Decompresses a buffer made by compress()
+     * @param t_input Compressed bytes
+     * @param t_inputSize Number of compressed bytes
+     * @param t_output Where to write, must have room for t_outputSize bytes
+     * @param t_outputSize Exact size the data decompresses to
+     * @return False if the data is corrupt or isnt exactly t_outputSize bytes, t_output is then partly written
+     *
+     * Never reads or writes past either buffer, whatever the input holds
+     */
+    bool decompress(const unsigned char* t_input, std::size_t t_inputSize, unsigned char* t_output, std::size_t t_outputSize);
+}
+
+#endif
@@ -26,18 +26,56 @@ static const int MAX_DONKEYS_PER_PLAYER = 3;   ///< Maximum donkeys per player
  */
 enum class Difficulty
 {
-    EASY,       ///< Easy difficulty (depth 1)
-    MEDIUM,     ///< Medium difficulty (depth 3)
-    HARD        ///< Hard difficulty (depth 5)
+    EASY,       ///< Easy difficulty (depth 1, 100ms)
+    MEDIUM,     ///< Medium difficulty (up to depth 3, 300ms)
+    HARD        ///< Hard difficulty (as deep as 1s allows)
+};
+
+/**
+ * @enum SearchEngine
+ * @brief How the AI picks its move, set per difficulty
+ */
+enum class SearchEngine
+{
+    MINIMAX,        ///< Alpha-beta on one thread, scored by the evaluation
+    MONTE_CARLO     ///< Tree search from random playouts, on every core
 };
 
 // AI configuration constants
 static const int MAX_DEPTH_EASY = 1;      ///< Minimax depth for easy AI
 static const int MAX_DEPTH_MEDIUM = 3;    ///< Minimax depth for medium AI
-static const int MAX_DEPTH_HARD = 5;      ///< Minimax depth for hard AI
+static const int MAX_DEPTH_HARD = 64;     ///< Minimax depth cap for hard AI (time runs out first)
+static const int TIME_BUDGET_EASY = 100;  ///< Time per move in ms for easy AI
+static const int TIME_BUDGET_MEDIUM = 300;///< Time per move in ms for medium AI
+static const int TIME_BUDGET_HARD = 1000; ///< Time per move in ms for hard AI
 static const int MAX_DEPTH = 3;           ///< Default minimax search depth
 static const int WIN_SCORE = 10000;       ///< Score value for winning position
 static const int LOSE_SCORE = -10000;     ///< Score value for losing position
+static const int ASPIRATION_WINDOW = 50;  ///< How far either side of the last score the root search looks first
+static const int NULL_MOVE_REDUCTION = 2;  ///< Extra depth taken off when searching after a pass
+static const int LATE_MOVE_INDEX = 3;     ///< Moves searched at full depth before reductions start
+static const int FUTILITY_MARGIN = 250;   ///< Most a quiet move changes the evaluation (about 99% of the time)
+static const int MAX_QUIESCENCE_PLY = 8;  ///< Most plies of wins and blocks searched past the horizon
+static const int THREAT_SOLVER_NODES = 20000; ///< Node budget for the forced win check before each search
+static const int THREAT_SOLVER_THREATS = 6;   ///< Most threats in a row the forced win check looks for
+static const int DEFAULT_HASH_MB = 16;    ///< Default transposition table size in MB
+static const int DEFAULT_EVAL_CACHE_KB = 512; ///< Default evaluation cache size in KB
+static const int PROOF_SEARCH_NODES = 3000;  ///< Positions the placement proof search expands per move
+static const int PROOF_SEARCH_HASH_MB = 8;    ///< Placement proof table size in MB
+static const int PROOF_SEARCH_TIME_SHARE = 4; ///< The proof search gets at most 1/this of the move's time
+static const int PN_LEAF_NODES = 400;         ///< Threat solver budget for each position where placement ends
+static const int PN_LEAF_THREATS = 4;         ///< Most threats in a row checked where placement ends
+static const int MAX_VISUALS = 15;            ///< Root moves shown on the board after a search
+static const char* const DEFAULT_BOOK_FILE = "ASSETS\\BOOK\\opening.book";  ///< Opening book the AI maps at startup (built with --build-book)
+static const char* const DEFAULT_TABLEBASE_FOLDER = "ASSETS\\TABLEBASE";  ///< Where --solve keeps the movement tablebase and its work files
+static const char* const DEFAULT_TABLEBASE_FILE = "ASSETS\\TABLEBASE\\movement.tbz";  ///< Compressed movement tablebase the AI maps at startup (the file --solve finishes with)
+static const int DEFAULT_TABLEBASE_CACHE_MB = 256;  ///< Decompressed tablebase blocks kept in memory, in MB
+static const int TABLEBASE_WIN_SCORE = 9000;  ///< Score for a position the tablebase says is won, below any four the search finds
+static const SearchEngine ENGINE_EASY = SearchEngine::MINIMAX;     ///< Search used by easy AI
+static const SearchEngine ENGINE_MEDIUM = SearchEngine::MINIMAX;   ///< Search used by medium AI
+static const SearchEngine ENGINE_HARD = SearchEngine::MINIMAX;     ///< Search used by hard AI
+static const int MONTE_CARLO_TREE_MB = 128;   ///< Memory for the Monte Carlo tree in MB, half is kept to copy the reused part into
+static const int MONTE_CARLO_THREADS = 0;     ///< Threads the Monte Carlo search uses, 0 for one per core
 
 // custom colours for the overhaul
 static const sf::Color DARK_BLUE = sf::Color(15, 25, 50);     
@@ -0,0 +1,212 @@
+/**
+ * @file Evaluation.h
+ * @brief Weights for the board evaluation and the tables built from them
+ * @authors: Kyle & Monika
+ *
+ * Every term of the evaluation apart from mobility only depends on what is
+ * in one window or around one cell, so Position keeps the totals up to date
+ * as pieces go on and come off instead of the AI rescanning the board at
+ * every leaf. The weights live here so the full rescan and the running
+ * totals always agree.
+ *
+ * A window's four cells are read as a base 3 number (0 empty, 1 player
+ * one, 2 player two, first cell lowest), which indexes a table built at
+ * compile time holding everything the evaluation wants to know about that
+ * window for both players. Scoring a window is one lookup, and a weight
+ * only has to change in the table builder.
+ */
+
+#ifndef EVALUATION_HPP
+#define EVALUATION_HPP
+
+#include <array>
+#include <cstdint>
+#include "Bitboard.h"
+
+static const int THREE_BONUS = 800;         ///< Our window with 3 pieces and a gap
+static const int THREE_PENALTY = 900;       ///< Their window with 3 pieces and a gap
+static const int POTENTIAL_BONUS = 50;      ///< Our window with 2 or 3 pieces and none of theirs
+static const int POTENTIAL_PENALTY = 40;    ///< Their window with 2 or 3 pieces and none of ours
+static const int CENTER_WEIGHT = 8;         ///< Per step closer to the centre
+static const int CENTER_BONUS = 15;         ///< Extra for the centre cell itself
+static const int ADJACENT_WEIGHT = 12;      ///< Per friendly piece next to a piece
+static const int MOBILITY_WEIGHT = 8;       ///< Per move more than the opponent
+
+static const int NUM_PATTERNS = 81;         ///< Ways to fill a window, 3^LINE_LENGTH
+
+/**
+ * @struct WindowPattern
+ * @brief What one way of filling a window is worth, for both players
+ *
+ * Arrays are indexed 0 for player one and 1 for player two
+ */
+struct WindowPattern
+{
+    std::uint8_t fours[2];          ///< 1 if the window is full
+    std::uint8_t threes[2];         ///< 1 if three pieces and a gap
+    std::uint8_t twos[2];           ///< 1 if two pieces and none of the other player's
+    std::uint8_t potentials[2];     ///< 1 if 2 or 3 pieces and none of the other player's
+    int scores[2];                  ///< Window score from each player's side
+};
+
+namespace EvaluationTables
+{
+    /**
+     * @brief Works out what a window is worth from one side
+     * @param t_ours Our pieces in the window
+     * @param t_theirs Their pieces in the window
+     * @return Window score from our side
+     */
+    constexpr int scoreWindow(int t_ours, int t_theirs)
+    {
+        int score = 0;
+        if (t_ours == LINE_LENGTH - 1 && t_theirs == 0)
+            score += THREE_BONUS;
+        if (t_theirs == LINE_LENGTH - 1 && t_ours == 0)
+            score -= THREE_PENALTY;
+        if (t_ours >= 2 && t_ours < LINE_LENGTH && t_theirs == 0)
+            score += POTENTIAL_BONUS;
+        if (t_theirs >= 2 && t_theirs < LINE_LENGTH && t_ours == 0)
+            score -= POTENTIAL_PENALTY;
+        return score;
+    }
+
+    /**
+     * @brief Builds the entry for every way of filling a window
+     * @return Patterns indexed by the window's base 3 number
+     */
+    constexpr std::array<WindowPattern, NUM_PATTERNS> buildWindowPatterns()
+    {
+        std::array<WindowPattern, NUM_PATTERNS> patterns{};
+
+        for (int index = 0; index < NUM_PATTERNS; ++index)
+        {
+            int counts[3] = { 0, 0, 0 };
+            for (int cell = 0, rest = index; cell < LINE_LENGTH; ++cell, rest /= 3)
+            {
+                counts[rest % 3]++;
+            }
+
+            WindowPattern& pattern = patterns[index];
+            for (int player = 0; player < 2; ++player)
+            {
+                int ours = counts[1 + player];
+                int theirs = counts[2 - player];
+                pattern.fours[player] = (ours == LINE_LENGTH);
+                pattern.threes[player] = (ours == LINE_LENGTH - 1 && theirs == 0);
+                pattern.twos[player] = (ours == LINE_LENGTH - 2 && theirs == 0);
+                pattern.potentials[player] = (ours >= 2 && ours < LINE_LENGTH && theirs == 0);
+                pattern.scores[player] = scoreWindow(ours, theirs);
+            }
+        }
+
+        return patterns;
+    }
+
+    /**
+     * @brief Lists the cells of every window, lowest first
+     * @return Cell indexes indexed by [window][cell in window]
+     */
+    constexpr std::array<std::array<int, LINE_LENGTH>, NUM_WIN_LINES> buildLineSquares()
+    {
+        std::array<std::array<int, LINE_LENGTH>, NUM_WIN_LINES> squares{};
+
+        for (int line = 0; line < NUM_WIN_LINES; ++line)
+        {
+            int count = 0;
+            for (int square = 0; square < NUM_SQUARES; ++square)
+            {
+                if (WIN_LINES[line] & squareBit(square))
+                    squares[line][count++] = square;
+            }
+        }
+
+        return squares;
+    }
+
+    /**
+     * @brief Builds how much a piece on each cell adds to each window through it
+     * @param t_squares Window cells from buildLineSquares()
+     * @return Place values (1, 3, 9 or 27) in the same order as LINES_THROUGH
+     */
+    constexpr std::array<std::array<int, MAX_LINES_PER_SQUARE>, NUM_SQUARES>
+        buildPatternSteps(const std::array<std::array<int, LINE_LENGTH>, NUM_WIN_LINES>& t_squares)
+    {
+        std::array<std::array<int, MAX_LINES_PER_SQUARE>, NUM_SQUARES> steps{};
+
+        for (int square = 0; square < NUM_SQUARES; ++square)
+        {
+            const LinesThrough& through = LINES_THROUGH[square];
+            for (int i = 0; i < through.count; ++i)
+            {
+                int step = 1;
+                for (int cell = 0; t_squares[through.lines[i]][cell] != square; ++cell)
+                {
+                    step *= 3;
+                }
+                steps[square][i] = step;
+            }
+        }
+
+        return steps;
+    }
+
+    /**
+     * @brief Builds what a piece is worth on each cell before its neighbours count
+     * @return Scores indexed by cell
+     */
+    constexpr std::array<int, NUM_SQUARES> buildSquareScores()
+    {
+        std::array<int, NUM_SQUARES> scores{};
+        const int center = GRID_SIZE / 2;
+
+        for (int square = 0; square < NUM_SQUARES; ++square)
+        {
+            int row = square / GRID_SIZE;
+            int col = square % GRID_SIZE;
+            int rowDist = (row > center) ? row - center : center - row;
+            int colDist = (col > center) ? col - center : center - col;
+
+            scores[square] = (8 - rowDist - colDist) * CENTER_WEIGHT;
+            if (row == center && col == center)
+                scores[square] += CENTER_BONUS;
+        }
+
+        return scores;
+    }
+}
+
+/// Everything about a window, indexed by its base 3 number
+inline constexpr std::array<WindowPattern, NUM_PATTERNS> WINDOW_PATTERNS = EvaluationTables::buildWindowPatterns();
+
+/// Cells of each window, lowest first (so the first cell is the lowest digit)
+inline constexpr std::array<std::array<int, LINE_LENGTH>, NUM_WIN_LINES> LINE_SQUARES = EvaluationTables::buildLineSquares();
+
+/// Place value of each cell in each window through it, indexed like LINES_THROUGH
+inline constexpr std::array<std::array<int, MAX_LINES_PER_SQUARE>, NUM_SQUARES> PATTERN_STEPS = EvaluationTables::buildPatternSteps(LINE_SQUARES);
+
+/// Centre score for a piece on each cell
+inline constexpr std::array<int, NUM_SQUARES> SQUARE_SCORES = EvaluationTables::buildSquareScores();
+
+/**
+ * @brief Reads a window as its base 3 number
+ * @param t_playerOne Player one's pieces
+ * @param t_playerTwo Player two's pieces
+ * @param t_line Index into WIN_LINES
+ * @return Index into WINDOW_PATTERNS
+ */
+inline int getWindowPattern(Bitboard t_playerOne, Bitboard t_playerTwo, int t_line)
+{
+    const std::array<int, LINE_LENGTH>& cells = LINE_SQUARES[t_line];
+    int index = 0;
+    int step = 1;
+    for (int cell = 0; cell < LINE_LENGTH; ++cell)
+    {
+        int square = cells[cell];
+        index += static_cast<int>(((t_playerOne >> square) & 1) + 2 * ((t_playerTwo >> square) & 1)) * step;
+        step *= 3;
+    }
+    return index;
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include "EvaluationCache.h"
+#include <algorithm>
+
+EvaluationCache::EvaluationCache(int t_kilobytes) :
+    m_mask(0),
+    m_kilobytes(0)
+{
+    resize(t_kilobytes);
+}
+
+void EvaluationCache::resize(int t_kilobytes)
+{
+    m_kilobytes = std::max(0, t_kilobytes);
+    if (m_kilobytes == 0)
+    {
+        m_entries.clear();
+        m_mask = 0;
+        resetStats();
+        return;
+    }
+
+    // round down to a power of two so the index is a mask
+    std::uint64_t entryCount = 1;
+    std::uint64_t maxEntries = (static_cast<std::uint64_t>(m_kilobytes) << 10) / sizeof(Entry);
+    while (entryCount * 2 <= maxEntries)
+    {
+        entryCount *= 2;
+    }
+
+    m_entries.assign(static_cast<size_t>(entryCount), Entry());
+    m_mask = entryCount - 1;
+    clear();
+}
+
+void EvaluationCache::clear()
+{
+    std::fill(m_entries.begin(), m_entries.end(), Entry{ 0, 0 });
+    resetStats();
+}
+
+bool EvaluationCache::probe(std::uint64_t t_key, int& t_score)
+{
+    if (m_entries.empty())
+    {
+        return false;
+    }
+
+    m_stats.probes++;
+    const Entry& entry = m_entries[t_key & m_mask];
+    if (entry.check != getCheck(t_key))
+    {
+        return false;
+    }
+
+    m_stats.hits++;
+    t_score = entry.score;
+    return true;
+}
+
+void EvaluationCache::store(std::uint64_t t_key, int t_score)
+{
+    if (m_entries.empty())
+    {
+        return;
+    }
+
+    Entry& entry = m_entries[t_key & m_mask];
+    entry.check = getCheck(t_key);
+    entry.score = t_score;
+}
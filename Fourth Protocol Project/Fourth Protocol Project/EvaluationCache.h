@@ -0,0 +1,95 @@
+/**
+ * @file EvaluationCache.h
+ * @brief Small hash table of static evaluations for the AI
+ * @authors: Kyle & Monika
+ */
+
+#ifndef EVALUATION_CACHE_HPP
+#define EVALUATION_CACHE_HPP
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class EvaluationCache
+ * @brief Remembers the static evaluation of positions already scored
+ *
+ * The same leaves get evaluated again every iteration and in sibling
+ * subtrees, and mobility still has to count every move for both sides.
+ * This is a direct-mapped table (one slot per hash, the newest score always
+ * wins) kept apart from the transposition table, so the flood of leaf
+ * scores never pushes out deep search results. Each entry is 8 bytes and
+ * the size is set in KB.
+ */
+class EvaluationCache
+{
+public:
+    /**
+     * @struct Stats
+     * @brief Counters for sizing the cache
+     */
+    struct Stats
+    {
+        std::uint64_t probes = 0;   ///< Lookups made
+        std::uint64_t hits = 0;     ///< Lookups that found the position
+
+        double hitRate() const { return probes ? 100.0 * hits / probes : 0.0; }
+    };
+
+    /**
+     * @brief Creates the cache
+     * @param t_kilobytes Size in KB, 0 turns the cache off
+     */
+    explicit EvaluationCache(int t_kilobytes);
+
+    /**
+     * @brief Changes the size of the cache, clearing it
+     * @param t_kilobytes New size in KB, 0 turns the cache off
+     */
+    void resize(int t_kilobytes);
+
+    /**
+     * @brief Empties every entry and resets the stats
+     */
+    void clear();
+
+    /**
+     * @brief Looks up a position
+     * @param t_key Hash of the position and the side it is scored for
+     * @param t_score Filled in with the stored score on a hit
+     * @return True if the position was found
+     */
+    bool probe(std::uint64_t t_key, int& t_score);
+
+    /**
+     * @brief Stores a score, replacing whatever was in its slot
+     * @param t_key Hash of the position and the side it is scored for
+     * @param t_score Static evaluation
+     */
+    void store(std::uint64_t t_key, int t_score);
+
+    bool isEnabled() const { return !m_entries.empty(); }
+    const Stats& getStats() const { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+    int getSizeKB() const { return m_kilobytes; }
+
+private:
+    /**
+     * @struct Entry
+     * @brief One stored evaluation
+     */
+    struct Entry
+    {
+        std::uint32_t check;    ///< Upper half of the hash with the low bit set, 0 when empty
+        std::int32_t score;     ///< Static evaluation
+    };
+
+    std::vector<Entry> m_entries;   ///< The cache itself
+    std::uint64_t m_mask;           ///< Entry count - 1 (count is a power of two)
+    int m_kilobytes;                ///< Size asked for in KB
+    Stats m_stats;                  ///< Probe counters
+
+    static std::uint32_t getCheck(std::uint64_t t_key) { return static_cast<std::uint32_t>(t_key >> 32) | 1; }
+};
+
+#endif
@@ -79,6 +79,7 @@ void Game::processKeys(const std::optional<sf::Event> t_event)
 		if (m_grid.getGameState() == GameState::GAME_OVER)
 		{
 			m_grid.resetGame();
+			m_ai.newGame();
 			updateAllUI();
 			m_grid.clearHighlights();
 			m_grid.clearVisuals();
@@ -96,6 +97,7 @@ void Game::processKeys(const std::optional<sf::Event> t_event)
 		if (m_grid.getGameState() == GameState::GAME_OVER)
 		{
 			m_grid.resetGame();
+			m_ai.newGame();
 			m_gameMode = GameMode::NONE;
 			m_showMenu = true;
 			m_aiWaiting = false;
@@ -281,7 +283,25 @@ void Game::handleAITurn()
 	// Clear previous visuals before AI thinks
 	m_grid.clearVisuals();
 	
+#ifdef _DEBUG
+	bool searched = m_grid.getGameState() != GameState::GAME_OVER;
+#endif
 	m_ai.makeMove(m_grid);
+
+#ifdef _DEBUG
+	// search and transposition table numbers, handy for picking budgets and a table size (debug builds only)
+	if (searched)
+	{
+		const TranspositionTable::Stats& stats = m_ai.getTableStats();
+		std::cout << "AI search: depth " << m_ai.getLastDepth() << ", " << m_ai.getLastNodes() << " nodes" << std::endl;
+		std::cout << "AI table (" << m_ai.getHashSize() << " MB): " << stats.probes << " probes, "
+			<< stats.hitRate() << "% hits, " << stats.cutoffRate() << "% cutoffs" << std::endl;
+
+		const EvaluationCache::Stats& evalStats = m_ai.getEvalCacheStats();
+		std::cout << "AI eval cache (" << m_ai.getEvalCacheSize() << " KB): " << evalStats.probes << " probes, "
+			<< evalStats.hitRate() << "% hits" << std::endl;
+	}
+#endif
 	
 	// Show what moves the AI was thinking about (dreamy lil fella)
 	if (m_grid.areVisualsOn())
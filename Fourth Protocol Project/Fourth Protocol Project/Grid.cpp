@@ -5,6 +5,7 @@ Grid::Grid() :
     m_currentPlayer(Player::PLAYER_ONE),
     m_font(nullptr),
     m_gameState(GameState::PLACEMENT),
+    m_winner(Player::NONE),
     m_selectedRow(-1),
     m_selectedCol(-1),
     m_pieceSelected(false),
@@ -251,7 +252,7 @@ void Grid::placePiece(int t_row, int t_col)
         autoSelectNextPiece();
     }
 
-    if (checkForWin())
+    if (checkForWin(t_row, t_col))
     {
         return;
     }
@@ -595,81 +596,35 @@ void Grid::setPiece(int t_row, int t_col, PieceType t_type, Player t_owner)
     setupPiece(t_row, t_col, t_type, t_owner);
 }
 
-bool Grid::checkForWin()//4 in a row check
+bool Grid::checkForWin(int t_row, int t_col)//4 in a row check
 {
     Player playerToCheck = m_currentPlayer;
 
-    for (int row = 0; row < GRID_SIZE; ++row)//horizontal lines
+    // only the lines through the cell that just changed can be new
+    if (hasLineThrough(getPlayerMask(playerToCheck), t_row * GRID_SIZE + t_col))
     {
-        for (int col = 0; col <= GRID_SIZE - 4; ++col)
-        {
-            if (checkLine(row, col, 0, 1, playerToCheck))
-            {
-                m_winner = playerToCheck;
-                m_gameState = GameState::GAME_OVER;
-                return true;
-            }
-        }
-    }
-
-    
-    for (int row = 0; row <= GRID_SIZE - 4; ++row)// vertical lines
-    {
-        for (int col = 0; col < GRID_SIZE; ++col)
-        {
-            if (checkLine(row, col, 1, 0, playerToCheck))
-            {
-                m_winner = playerToCheck;
-                m_gameState = GameState::GAME_OVER;
-                return true;
-            }
-        }
-    }
-
-    // Check diagonal lines (top-left to bottom-right)
-    for (int row = 0; row <= GRID_SIZE - 4; ++row)
-    {
-        for (int col = 0; col <= GRID_SIZE - 4; ++col)
-        {
-            if (checkLine(row, col, 1, 1, playerToCheck))
-            {
-                m_winner = playerToCheck;
-                m_gameState = GameState::GAME_OVER;
-                return true;
-            }
-        }
-    }
-
-    // Check diagonal lines (top-right to bottom-left)
-    for (int row = 0; row <= GRID_SIZE - 4; ++row)
-    {
-        for (int col = 3; col < GRID_SIZE; ++col)
-        {
-            if (checkLine(row, col, 1, -1, playerToCheck))
-            {
-                m_winner = playerToCheck;
-                m_gameState = GameState::GAME_OVER;
-                return true;
-            }
-        }
+        m_winner = playerToCheck;
+        m_gameState = GameState::GAME_OVER;
+        return true;
     }
 
     return false;
 }
 
-bool Grid::checkLine(int t_startRow, int t_startCol, int t_rowDir, int t_colDir, Player t_player) const
+Bitboard Grid::getPlayerMask(Player t_player) const
 {
-    for (int i = 0; i < 4; ++i)//checks the 4 in a row to see if its all one players
+    Bitboard pieces = 0;
+    for (int row = 0; row < GRID_SIZE; ++row)
     {
-        int row = t_startRow + i * t_rowDir;
-        int col = t_startCol + i * t_colDir;
-
-        if (m_board[row][col].owner != t_player)
+        for (int col = 0; col < GRID_SIZE; ++col)
         {
-            return false;
+            if (m_board[row][col].owner == t_player)
+            {
+                pieces |= squareBit(row * GRID_SIZE + col);
+            }
         }
     }
-    return true;
+    return pieces;
 }
 
 void Grid::movePiece(int t_fromRow, int t_fromCol, int t_toRow, int t_toCol)
@@ -683,7 +638,7 @@ void Grid::movePiece(int t_fromRow, int t_fromCol, int t_toRow, int t_toCol)
     // show it in new pos
     setupPiece(t_toRow, t_toCol, type, owner);
 
-    checkForWin();
+    checkForWin(t_toRow, t_toCol);
 }
 
 bool Grid::isValidMove(int t_fromRow, int t_fromCol, int t_toRow, int t_toCol) const
@@ -708,83 +663,49 @@ bool Grid::isValidMove(int t_fromRow, int t_fromCol, int t_toRow, int t_toCol) c
 
 bool Grid::canPieceMove(PieceType t_type, int t_fromRow, int t_fromCol, int t_toRow, int t_toCol) const
 {
-    int rowDiff = abs(t_toRow - t_fromRow);
-    int colDiff = abs(t_toCol - t_fromCol);
+    // uses the same move tables as the AI so both agree on the rules
+    int fromSquare = t_fromRow * GRID_SIZE + t_fromCol;
+    Bitboard occupied = getOccupiedMask();
+    Bitboard targets = 0;
 
     switch (t_type)
     {
     case PieceType::DONKEY:
         // Donkey moves 1 space in cardinal directions
-        return (rowDiff == 1 && colDiff == 0) || (rowDiff == 0 && colDiff == 1);
+        targets = ORTHOGONAL_STEPS[fromSquare] & ~occupied;
+        break;
 
     case PieceType::SNAKE:
         // Snake moves 1 space in any direction
-        return (rowDiff <= 1 && colDiff <= 1) && (rowDiff + colDiff > 0);
+        targets = KING_STEPS[fromSquare] & ~occupied;
+        break;
 
     case PieceType::FROG:
-    {
-        // Frog can move 1 space in any direction
-        if ((rowDiff <= 1 && colDiff <= 1) && (rowDiff + colDiff > 0))
-        {
-            return true;
-        }
-
-        // Jump must be straight or diagonal
-        if (!(rowDiff == 0 || colDiff == 0 || rowDiff == colDiff))
-        {
-            return false;
-        }
-
-        int rowStep = (t_toRow > t_fromRow) ? 1 : ((t_toRow < t_fromRow) ? -1 : 0);
-        int colStep = (t_toCol > t_fromCol) ? 1 : ((t_toCol < t_fromCol) ? -1 : 0);
-
-        int currentRow = t_fromRow + rowStep;
-        int currentCol = t_fromCol + colStep;
+        // Frog steps 1 space or jumps a solid line of pieces
+        targets = getFrogTargets(fromSquare, occupied);
+        break;
 
+    default:
+        return false;
+    }
 
-        bool foundFirstPiece = false;
+    return (targets & squareBit(t_toRow * GRID_SIZE + t_toCol)) != 0;
+}
 
-        // Move along the line until reaching target
-        while (currentRow != t_toRow || currentCol != t_toCol)
+Bitboard Grid::getOccupiedMask() const
+{
+    Bitboard occupied = 0;
+    for (int row = 0; row < GRID_SIZE; ++row)
+    {
+        for (int col = 0; col < GRID_SIZE; ++col)
         {
-            if (currentRow == t_toRow && currentCol == t_toCol)
-            {
-                break;
-            }
-
-            if (m_board[currentRow][currentCol].type != PieceType::NONE)
-            {
-                //hit a piece
-                foundFirstPiece = true;
-            }
-            else
+            if (m_board[row][col].type != PieceType::NONE)
             {
-                // Empty space before a piece breaks the chain / no jump
-                if (!foundFirstPiece)
-                    return false;
-
-                // Empty space AFTER pieces but before target / frog must stop there
-                if (currentRow != t_toRow || currentCol != t_toCol)
-                    return false;
+                occupied |= squareBit(row * GRID_SIZE + col);
             }
-
-            currentRow += rowStep;
-            currentCol += colStep;
         }
-
-        // Landing square has to be empty
-        if (m_board[t_toRow][t_toCol].type != PieceType::NONE)
-        {
-            return false;
-        }
-
-        // Must have jumped over at least one piece
-        return foundFirstPiece;
-    }
-    
-    default:
-        return false;
     }
+    return occupied;
 }
 
 void Grid::autoSelectNextPiece()
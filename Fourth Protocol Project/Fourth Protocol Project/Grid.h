@@ -5,6 +5,7 @@
 #include <array>
 #include <functional>
 #include "Constants.h"
+#include "Bitboard.h"
 
 enum class PieceType
 {
@@ -115,6 +116,7 @@ private:
 
     void setupPiece(int t_row, int t_col, PieceType t_type, Player t_player);//All piece functions
     bool canPieceMove(PieceType t_type, int t_fromRow, int t_fromCol, int t_toRow, int t_toCol) const;
+    Bitboard getOccupiedMask() const;
     void movePiece(int t_fromRow, int t_fromCol, int t_toRow, int t_toCol);
     void selectPiece(int t_row, int t_col);
     void deselectPiece();
@@ -133,8 +135,8 @@ private:
     
     void highlightAvailableMoves(int t_row, int t_col);
     
-    bool checkForWin();
-    bool checkLine(int t_startRow, int t_startCol, int t_rowDir, int t_colDir, Player t_player) const;
+    bool checkForWin(int t_row, int t_col);
+    Bitboard getPlayerMask(Player t_player) const;
 };
 
 #endif
\ No newline at end of file
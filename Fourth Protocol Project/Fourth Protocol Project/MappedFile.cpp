@@ -0,0 +1,227 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// a view bigger than size_t can count would be mapped short, and every index past the end would be a wild write
+static bool fitsInAddressSpace(std::uint64_t t_size)
+{
+    return t_size <= SIZE_MAX;
+}
+
+MappedFile::MappedFile() :
+    m_data(nullptr),
+    m_size(0),
+    m_writable(false)
+#ifdef _WIN32
+    , m_file(INVALID_HANDLE_VALUE),
+    m_mapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& t_path)
+{
+    close();
+
+    m_file = CreateFileA(t_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0 || !fitsInAddressSpace(static_cast<std::uint64_t>(size.QuadPart)))
+    {
+        close();
+        return false;
+    }
+
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping)
+    {
+        close();
+        return false;
+    }
+
+    m_data = static_cast<unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data)
+    {
+        close();
+        return false;
+    }
+
+    m_size = static_cast<std::size_t>(size.QuadPart);
+    return true;
+}
+
+bool MappedFile::openWritable(const std::string& t_path, std::uint64_t t_size)
+{
+    close();
+    if (t_size == 0 || !fitsInAddressSpace(t_size))
+    {
+        return false;
+    }
+
+    m_file = CreateFileA(t_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    // moving the end out leaves the new bytes reading as 0
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(t_size);
+    if (!SetFilePointerEx(m_file, size, nullptr, FILE_BEGIN) || !SetEndOfFile(m_file))
+    {
+        close();
+        return false;
+    }
+
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    if (!m_mapping)
+    {
+        close();
+        return false;
+    }
+
+    m_data = static_cast<unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, 0));
+    if (!m_data)
+    {
+        close();
+        return false;
+    }
+
+    m_size = static_cast<std::size_t>(t_size);
+    m_writable = true;
+    return true;
+}
+
+bool MappedFile::flush()
+{
+    if (!m_writable)
+    {
+        return false;
+    }
+    return FlushViewOfFile(m_data, 0) && FlushFileBuffers(m_file);
+}
+
+void MappedFile::close()
+{
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping)
+    {
+        CloseHandle(m_mapping);
+    }
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_writable = false;
+    m_mapping = nullptr;
+    m_file = INVALID_HANDLE_VALUE;
+}
+#else
+bool MappedFile::open(const std::string& t_path)
+{
+    close();
+
+    int file = ::open(t_path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    // the mapping keeps the file alive, so the descriptor can go straight away
+    struct stat info;
+    void* data = MAP_FAILED;
+    if (fstat(file, &info) == 0 && info.st_size > 0 && fitsInAddressSpace(static_cast<std::uint64_t>(info.st_size)))
+    {
+        data = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, file, 0);
+    }
+    ::close(file);
+
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_data = static_cast<unsigned char*>(data);
+    m_size = static_cast<std::size_t>(info.st_size);
+    return true;
+}
+
+bool MappedFile::openWritable(const std::string& t_path, std::uint64_t t_size)
+{
+    close();
+    if (t_size == 0 || !fitsInAddressSpace(t_size))
+    {
+        return false;
+    }
+
+    int file = ::open(t_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    // growing the file leaves the new bytes reading as 0 without writing them
+    void* data = MAP_FAILED;
+    if (ftruncate(file, static_cast<off_t>(t_size)) == 0)
+    {
+        data = mmap(nullptr, static_cast<std::size_t>(t_size), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    }
+    ::close(file);
+
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_data = static_cast<unsigned char*>(data);
+    m_size = static_cast<std::size_t>(t_size);
+    m_writable = true;
+    return true;
+}
+
+bool MappedFile::flush()
+{
+    if (!m_writable)
+    {
+        return false;
+    }
+    return msync(m_data, m_size, MS_SYNC) == 0;
+}
+
+void MappedFile::close()
+{
+    if (m_data)
+    {
+        munmap(m_data, m_size);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_writable = false;
+}
+#endif
@@ -0,0 +1,82 @@
+/**
+ * @file MappedFile.h
+ * @brief Memory mapped file
+ * @authors: Kyle & Monika
+ *
+ * Mapping a file costs nothing up front, the OS only reads the pages that
+ * get touched, and every process that maps the same file shares the same
+ * pages. Uses CreateFileMapping on Windows and mmap everywhere else.
+ *
+ * A file can also be mapped for writing, which is how the tablebase solver
+ * works on tables bigger than memory: the OS writes changed pages back to
+ * the file and drops them when it needs the room. The whole file is one
+ * view, so a 32-bit build can only map files that fit in its address space;
+ * anything bigger fails to open rather than being mapped short.
+ */
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @class MappedFile
+ * @brief Owns a view of a whole file, read-only unless opened with openWritable
+ */
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps a file, closing whatever was mapped before
+     * @param t_path Path of the file
+     * @return False if the file is missing, empty or cant be mapped (or is too big to address)
+     */
+    bool open(const std::string& t_path);
+
+    /**
+     * @brief Maps a file for reading and writing, closing whatever was mapped before
+     * @param t_path Path of the file, created if it is missing
+     * @param t_size Size to make the file, any new bytes read as 0
+     * @return False if the file cant be created, resized or mapped, or t_size is too big to address
+     *
+     * Writes go straight into the OS's copy of the file, so they are kept
+     * even if the program is killed; flush() waits for them to reach the disk
+     */
+    bool openWritable(const std::string& t_path, std::uint64_t t_size);
+
+    /**
+     * @brief Writes every changed page back to the disk
+     * @return False if the OS couldnt write them (or nothing writable is mapped)
+     */
+    bool flush();
+
+    /**
+     * @brief Unmaps the file, safe to call when nothing is mapped
+     */
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    bool isWritable() const { return m_writable; }
+    const unsigned char* getData() const { return m_data; }
+    unsigned char* getWritableData() { return m_writable ? m_data : nullptr; }
+    std::size_t getSize() const { return m_size; }
+
+private:
+    unsigned char* m_data;          ///< Start of the mapped view, nullptr when closed
+    std::size_t m_size;             ///< Size of the file in bytes
+    bool m_writable;                ///< Mapped with openWritable
+#ifdef _WIN32
+    void* m_file;                   ///< File handle
+    void* m_mapping;                ///< File mapping handle
+#endif
+};
+
+#endif
@@ -0,0 +1,699 @@
+#include "MonteCarloSearch.h"
+#include "TranspositionTable.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <thread>
+
+static const int PLACEMENT_SOURCE = 31;     // source cell packMove uses for placements
+static const int PIECES_PER_PLAYER = MAX_FROGS_PER_PLAYER + MAX_SNAKES_PER_PLAYER + MAX_DONKEYS_PER_PLAYER;
+
+// same layout as packMove, movement moves dont say which piece it is
+static std::uint16_t packSquares(int t_from, int t_to, int t_type)
+{
+    return static_cast<std::uint16_t>(0x8000 | (t_type << 10) | (t_from << 5) | t_to);
+}
+
+// xorshift64*, each thread has its own state so nothing is shared
+static std::uint64_t nextRandom(std::uint64_t& t_state)
+{
+    t_state ^= t_state >> 12;
+    t_state ^= t_state << 25;
+    t_state ^= t_state >> 27;
+    return t_state * 2685821657736338717ull;
+}
+
+static int randomBelow(std::uint64_t& t_state, int t_count)
+{
+    return static_cast<int>(((nextRandom(t_state) >> 32) * static_cast<std::uint64_t>(t_count)) >> 32);
+}
+
+// cell of the nth set bit in a mask
+static int getNthSquare(Bitboard t_mask, int t_index)
+{
+    for (int i = 0; i < t_index; ++i)
+    {
+        t_mask &= t_mask - 1;
+    }
+    return std::countr_zero(t_mask);
+}
+
+PlayoutBoard PlayoutBoard::fromPosition(const Position& t_position)
+{
+    PlayoutBoard board;
+    board.players[0] = t_position.getPlayerMask(Player::PLAYER_ONE);
+    board.players[1] = t_position.getPlayerMask(Player::PLAYER_TWO);
+    board.frogs = t_position.getTypeMask(PieceType::FROG);
+    board.snakes = t_position.getTypeMask(PieceType::SNAKE);
+
+    const Player players[2] = { Player::PLAYER_ONE, Player::PLAYER_TWO };
+    const PieceType types[3] = { PieceType::FROG, PieceType::SNAKE, PieceType::DONKEY };
+    for (int player = 0; player < 2; ++player)
+    {
+        for (int type = 0; type < 3; ++type)
+        {
+            board.toPlace[player][type] = static_cast<std::uint8_t>(t_position.getRemainingPieces(players[player], types[type]));
+        }
+    }
+
+    board.sideToMove = (t_position.getSideToMove() == Player::PLAYER_ONE) ? 0 : 1;
+    board.winner = -1;
+    if (t_position.getWinner() != Player::NONE)
+    {
+        board.winner = (t_position.getWinner() == Player::PLAYER_ONE) ? 0 : 1;
+    }
+    // from the counts like play() does, a four made while placing leaves pieces still to place
+    board.placing = false;
+    for (int player = 0; player < 2; ++player)
+    {
+        board.placing = board.placing || board.toPlace[player][0] || board.toPlace[player][1] || board.toPlace[player][2];
+    }
+    return board;
+}
+
+int PlayoutBoard::generateMoves(std::uint16_t* t_moves) const
+{
+    int count = 0;
+    Bitboard occupied = players[0] | players[1];
+
+    // any piece type thats left on any empty cell, in the same order as the AI lists them
+    if (placing)
+    {
+        for (int type = 0; type < 3; ++type)
+        {
+            if (toPlace[sideToMove][type] == 0)
+                continue;
+
+            Bitboard empty = ~occupied & FULL_BOARD;
+            while (empty)
+            {
+                t_moves[count++] = packSquares(PLACEMENT_SOURCE, popLowest(empty), type + 1);
+            }
+        }
+        return count;
+    }
+
+    Bitboard pieces = players[sideToMove];
+    while (pieces)
+    {
+        int from = popLowest(pieces);
+        PieceType type = (frogs & squareBit(from)) ? PieceType::FROG : (snakes & squareBit(from)) ? PieceType::SNAKE : PieceType::DONKEY;
+        Bitboard targets = getPieceTargets(type, from, occupied);
+        while (targets)
+        {
+            t_moves[count++] = packSquares(from, popLowest(targets), 0);
+        }
+    }
+    return count;
+}
+
+void PlayoutBoard::play(std::uint16_t t_move)
+{
+    int to = t_move & 31;
+    int from = (t_move >> 5) & 31;
+    int type = (t_move >> 10) & 3;
+    Bitboard toBit = squareBit(to);
+
+    if (from == PLACEMENT_SOURCE)
+    {
+        players[sideToMove] |= toBit;
+        if (type == static_cast<int>(PieceType::FROG))
+            frogs |= toBit;
+        else if (type == static_cast<int>(PieceType::SNAKE))
+            snakes |= toBit;
+        --toPlace[sideToMove][type - 1];
+
+        placing = false;
+        for (int player = 0; player < 2; ++player)
+        {
+            placing = placing || toPlace[player][0] || toPlace[player][1] || toPlace[player][2];
+        }
+    }
+    else
+    {
+        Bitboard moved = squareBit(from) | toBit;
+        players[sideToMove] ^= moved;
+        if (frogs & squareBit(from))
+            frogs ^= moved;
+        else if (snakes & squareBit(from))
+            snakes ^= moved;
+    }
+
+    // only the windows through the destination can have just been finished
+    if (hasLineThrough(players[sideToMove], to))
+    {
+        winner = static_cast<std::int8_t>(sideToMove);
+    }
+    sideToMove ^= 1;
+}
+
+bool PlayoutBoard::operator==(const PlayoutBoard& t_other) const
+{
+    for (int player = 0; player < 2; ++player)
+    {
+        for (int type = 0; type < 3; ++type)
+        {
+            if (toPlace[player][type] != t_other.toPlace[player][type])
+                return false;
+        }
+    }
+    return players[0] == t_other.players[0] && players[1] == t_other.players[1] && frogs == t_other.frogs && snakes == t_other.snakes &&
+        sideToMove == t_other.sideToMove && winner == t_other.winner && placing == t_other.placing;
+}
+
+MonteCarloSearch::MonteCarloSearch(int t_megabytes) :
+    m_megabytes(0),
+    m_capacity(0),
+    m_current(0),
+    m_used(0),
+    m_full(false),
+    m_hasTree(false),
+    m_rootBoard(),
+    m_stop(false),
+    m_completed(0),
+    m_deepest(0),
+    m_playoutLimit(0),
+    m_stopWhenFull(false),
+    m_hasDeadline(false),
+    m_playouts(0),
+    m_reusedVisits(0),
+    m_maxDepth(0)
+{
+    static_assert(sizeof(Node) == 16, "tree nodes are meant to be 16 bytes");
+    resize(t_megabytes);
+}
+
+void MonteCarloSearch::resize(int t_megabytes)
+{
+    m_megabytes = std::max(1, t_megabytes);
+
+    // two arenas, and a root with every placement as a child has to fit
+    std::uint64_t nodes = (static_cast<std::uint64_t>(m_megabytes) << 20) / (2 * sizeof(Node));
+    m_capacity = static_cast<std::uint32_t>(std::clamp<std::uint64_t>(nodes, MAX_MOVES + 1, NO_NODE - 1));
+
+    // allocated by the first search, so an AI that never uses this costs nothing
+    m_arenas[0].reset();
+    m_arenas[1].reset();
+    clear();
+}
+
+void MonteCarloSearch::clear()
+{
+    m_hasTree = false;
+    m_used = 0;
+    m_full = false;
+}
+
+std::uint32_t MonteCarloSearch::getTreeSize() const
+{
+    return std::min(m_used.load(), m_capacity);
+}
+
+Move MonteCarloSearch::search(const Position& t_position, const MoveList& t_rootMoves, int t_milliseconds, std::uint64_t t_playouts, int t_threads)
+{
+    if (!m_arenas[0])
+    {
+        m_arenas[0].reset(new Node[m_capacity]);
+        m_arenas[1].reset(new Node[m_capacity]);
+    }
+
+    // a four straight away is the only child the root gets, like any other node (see expand)
+    PlayoutBoard board = PlayoutBoard::fromPosition(t_position);
+    MoveList rootMoves = t_rootMoves;
+    for (const Move& move : t_rootMoves)
+    {
+        PlayoutBoard next = board;
+        next.play(packMove(move));
+        if (next.winner >= 0)
+        {
+            rootMoves.clear();
+            rootMoves.push_back(move);
+            break;
+        }
+    }
+
+    // whatever is left of the last search under this position is kept
+    rebuildTree(findReusable(board), rootMoves);
+    m_rootBoard = board;
+    m_hasTree = true;
+    m_reusedVisits = getNodes()[0].visits.load();
+
+    m_stop = false;
+    m_completed = 0;
+    m_deepest = 0;
+    m_playoutLimit = t_playouts;
+    m_hasDeadline = t_milliseconds > 0;
+    m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(t_milliseconds);
+    m_stopWhenFull = t_playouts == 0 && t_milliseconds == 0;
+
+    // a tree where every line ends in a four stops growing before it fills, so no limit still needs a cap
+    // (enough playouts to expand every node the arena holds)
+    if (m_stopWhenFull)
+    {
+        m_playoutLimit = static_cast<std::uint64_t>(m_capacity) * EXPAND_VISITS;
+    }
+
+    // with one move there is nothing to pick between
+    if (rootMoves.size() > 1)
+    {
+        int threads = t_threads > 0 ? t_threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        std::uint64_t seed = static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; ++i)
+        {
+            workers.emplace_back(&MonteCarloSearch::runThread, this, seed + i * 0x9E3779B97F4A7C15ull);
+        }
+        runThread(seed);
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+    m_playouts = m_completed;
+    m_maxDepth = m_deepest;
+
+    // the most visited move is the one the search trusts most, a lucky few playouts cant pick it
+    const Node& root = getNodes()[0];
+    const Node* children = getNodes() + root.firstChild;
+    const Node* best = children;
+    for (int i = 1; i < root.childCount; ++i)
+    {
+        std::uint32_t visits = children[i].visits.load();
+        if (visits > best->visits.load() || (visits == best->visits.load() && children[i].points.load() > best->points.load()))
+        {
+            best = &children[i];
+        }
+    }
+
+    Move move = unpackMove(best->move);
+    PlayoutBoard next = m_rootBoard;
+    next.play(best->move);
+    std::uint32_t visits = best->visits.load();
+    move.score = (next.winner >= 0) ? 100 : visits ? static_cast<int>(50ull * best->points.load() / visits) : 50;
+    return move;
+}
+
+void MonteCarloSearch::getVisuals(std::vector<AIVisualisation>& t_visuals, int t_count) const
+{
+    t_visuals.clear();
+    if (!m_hasTree)
+    {
+        return;
+    }
+
+    const Node& root = getNodes()[0];
+    const Node* children = getNodes() + root.firstChild;
+    FixedList<int, MAX_MOVES> order;
+    for (int i = 0; i < root.childCount; ++i)
+    {
+        order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [children](int t_a, int t_b) { return children[t_a].visits.load() > children[t_b].visits.load(); });
+
+    for (int i : order)
+    {
+        if (static_cast<int>(t_visuals.size()) >= t_count)
+            break;
+
+        // placements of different pieces share a cell, so only the most visited one is shown
+        Move move = unpackMove(children[i].move);
+        bool shown = false;
+        for (const AIVisualisation& vis : t_visuals)
+        {
+            shown = shown || (move.fromRow == -1 && vis.toRow == move.toRow && vis.toCol == move.toCol);
+        }
+        if (shown)
+            continue;
+
+        AIVisualisation vis;
+        vis.fromRow = move.fromRow;
+        vis.fromCol = move.fromCol;
+        vis.toRow = move.toRow;
+        vis.toCol = move.toCol;
+        vis.score = static_cast<int>(children[i].visits.load());
+        vis.isSource = t_visuals.empty() && move.fromRow != -1;   // where the chosen piece comes from
+        t_visuals.push_back(vis);
+    }
+}
+
+std::uint32_t MonteCarloSearch::findReusable(const PlayoutBoard& t_board) const
+{
+    if (!m_hasTree)
+    {
+        return NO_NODE;
+    }
+    if (m_rootBoard == t_board)
+    {
+        return 0;
+    }
+
+    // our move then theirs is the usual case, one move covers the AI playing both sides
+    const Node* nodes = getNodes();
+    const Node& root = nodes[0];
+    for (int i = 0; i < root.childCount; ++i)
+    {
+        std::uint32_t child = root.firstChild + i;
+        PlayoutBoard afterOne = m_rootBoard;
+        afterOne.play(nodes[child].move);
+        if (afterOne == t_board)
+        {
+            return child;
+        }
+        if (nodes[child].state.load() != EXPANDED || afterOne.winner >= 0)
+        {
+            continue;
+        }
+
+        for (int j = 0; j < nodes[child].childCount; ++j)
+        {
+            std::uint32_t grandchild = nodes[child].firstChild + j;
+            PlayoutBoard afterTwo = afterOne;
+            afterTwo.play(nodes[grandchild].move);
+            if (afterTwo == t_board)
+            {
+                return grandchild;
+            }
+        }
+    }
+    return NO_NODE;
+}
+
+void MonteCarloSearch::rebuildTree(std::uint32_t t_old, const MoveList& t_rootMoves)
+{
+    const Node* from = getNodes();
+    Node* to = m_arenas[1 - m_current].get();
+
+    // firstChild of a copied node holds the node it came from until its own children are copied
+    auto copyNode = [](Node& t_target, std::uint16_t t_move, const Node* t_source, std::uint32_t t_sourceIndex)
+    {
+        t_target.visits.store(t_source ? t_source->visits.load() : 0, std::memory_order_relaxed);
+        t_target.points.store(t_source ? t_source->points.load() : 0, std::memory_order_relaxed);
+        t_target.firstChild = t_source ? t_sourceIndex : NO_NODE;
+        t_target.move = t_move;
+        t_target.childCount = 0;
+        t_target.state.store(UNEXPANDED, std::memory_order_relaxed);
+    };
+
+    // the root gets exactly the moves asked for, keeping what the old tree knew about each
+    Node& root = to[0];
+    copyNode(root, 0, (t_old != NO_NODE) ? &from[t_old] : nullptr, 0);
+    root.firstChild = 1;
+    root.childCount = static_cast<std::uint8_t>(t_rootMoves.size());
+
+    bool oldExpanded = t_old != NO_NODE && from[t_old].state.load() == EXPANDED;
+    for (int i = 0; i < t_rootMoves.size(); ++i)
+    {
+        std::uint16_t move = packMove(t_rootMoves[i]);
+        const Node* source = nullptr;
+        std::uint32_t sourceIndex = NO_NODE;
+        for (int j = 0; oldExpanded && j < from[t_old].childCount && !source; ++j)
+        {
+            sourceIndex = from[t_old].firstChild + j;
+            source = (from[sourceIndex].move == move) ? &from[sourceIndex] : nullptr;
+        }
+        copyNode(to[1 + i], move, source, sourceIndex);
+    }
+    root.state.store(EXPANDED, std::memory_order_relaxed);
+
+    // breadth first in place, so when the room runs out it is the deepest nodes that go
+    std::uint32_t used = 1 + t_rootMoves.size();
+    for (std::uint32_t next = 1; next < used; ++next)
+    {
+        Node& target = to[next];
+        std::uint32_t sourceIndex = target.firstChild;
+        target.firstChild = 0;
+        if (sourceIndex == NO_NODE || from[sourceIndex].state.load() != EXPANDED || used + from[sourceIndex].childCount > m_capacity)
+        {
+            continue;
+        }
+
+        const Node& source = from[sourceIndex];
+        for (int i = 0; i < source.childCount; ++i)
+        {
+            std::uint32_t child = source.firstChild + i;
+            copyNode(to[used + i], from[child].move, &from[child], child);
+        }
+        target.firstChild = used;
+        target.childCount = source.childCount;
+        target.state.store(EXPANDED, std::memory_order_relaxed);
+        used += source.childCount;
+    }
+
+    m_current = 1 - m_current;
+    m_used = used;
+    m_full = false;
+}
+
+void MonteCarloSearch::runThread(std::uint64_t t_seed)
+{
+    std::uint64_t random = t_seed | 1;
+    int deepest = 0;
+    while (!m_stop.load(std::memory_order_relaxed))
+    {
+        for (int i = 0; i < CHECK_INTERVAL; ++i)
+        {
+            deepest = std::max(deepest, iterate(random));
+        }
+
+        // reading the clock every playout is slow, and the count is shared so it is only added in blocks
+        std::uint64_t completed = m_completed.fetch_add(CHECK_INTERVAL, std::memory_order_relaxed) + CHECK_INTERVAL;
+        if ((m_playoutLimit > 0 && completed >= m_playoutLimit) ||
+            (m_hasDeadline && std::chrono::steady_clock::now() >= m_deadline) ||
+            (m_stopWhenFull && m_full.load(std::memory_order_relaxed)))
+        {
+            m_stop.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    int seen = m_deepest.load();
+    while (deepest > seen && !m_deepest.compare_exchange_weak(seen, deepest))
+    {
+    }
+}
+
+int MonteCarloSearch::iterate(std::uint64_t& t_random)
+{
+    Node* path[MAX_TREE_DEPTH + 1];
+    PlayoutBoard board = m_rootBoard;
+    Node* node = getNodes();
+    node->visits.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+    path[0] = node;
+
+    // down the tree, charging each node a few losses until the result comes back
+    int depth = 0;
+    while (depth < MAX_TREE_DEPTH && board.winner < 0 && node->state.load(std::memory_order_acquire) == EXPANDED && node->childCount > 0)
+    {
+        node = &selectChild(*node);
+        node->visits.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+        path[++depth] = node;
+        board.play(node->move);
+    }
+
+    int winner = board.winner;
+    if (winner < 0)
+    {
+        std::uint8_t state = node->state.load(std::memory_order_acquire);
+        if (state == UNEXPANDED && depth < MAX_TREE_DEPTH && node->visits.load(std::memory_order_relaxed) >= EXPAND_VISITS + VIRTUAL_LOSS)
+        {
+            expand(*node, board);
+        }
+
+        // a node expanded with no children is stuck, which playout() also calls a draw
+        winner = playout(board, t_random);
+    }
+
+    // each node scores for the player who moved into it
+    for (int d = depth; d >= 0; --d)
+    {
+        int mover = m_rootBoard.sideToMove ^ (d & 1) ^ 1;
+        std::uint32_t points = (winner < 0) ? 1 : (winner == mover ? 2 : 0);
+        if (points)
+        {
+            path[d]->points.fetch_add(points, std::memory_order_relaxed);
+        }
+        path[d]->visits.fetch_sub(VIRTUAL_LOSS - 1, std::memory_order_relaxed);
+    }
+    return depth;
+}
+
+MonteCarloSearch::Node& MonteCarloSearch::selectChild(const Node& t_node) const
+{
+    Node* children = getNodes() + t_node.firstChild;
+    float logVisits = std::log(static_cast<float>(std::max<std::uint32_t>(t_node.visits.load(std::memory_order_relaxed), 1)));
+
+    Node* best = children;
+    float bestValue = -1.0f;
+    for (int i = 0; i < t_node.childCount; ++i)
+    {
+        std::uint32_t visits = children[i].visits.load(std::memory_order_relaxed);
+        if (visits == 0)
+        {
+            return children[i];    // every move gets tried once before any gets a second look
+        }
+
+        float points = static_cast<float>(children[i].points.load(std::memory_order_relaxed));
+        float value = points / (2.0f * visits) + EXPLORATION * std::sqrt(logVisits / visits);
+        if (value > bestValue)
+        {
+            bestValue = value;
+            best = &children[i];
+        }
+    }
+    return *best;
+}
+
+void MonteCarloSearch::expand(Node& t_node, const PlayoutBoard& t_board)
+{
+    std::uint8_t expected = UNEXPANDED;
+    if (m_full.load(std::memory_order_relaxed) || !t_node.state.compare_exchange_strong(expected, EXPANDING, std::memory_order_acquire))
+    {
+        return;
+    }
+
+    std::uint16_t moves[MAX_MOVES];
+    int count = t_board.generateMoves(moves);
+
+    // a move that makes a four is the only child worth having
+    for (int i = 0; i < count; ++i)
+    {
+        PlayoutBoard next = t_board;
+        next.play(moves[i]);
+        if (next.winner >= 0)
+        {
+            moves[0] = moves[i];
+            count = 1;
+            break;
+        }
+    }
+
+    std::uint32_t first = 0;
+    if (count > 0)
+    {
+        first = allocate(count);
+        if (first == NO_NODE)
+        {
+            t_node.state.store(UNEXPANDED, std::memory_order_release);
+            return;
+        }
+    }
+
+    Node* nodes = getNodes();
+    for (int i = 0; i < count; ++i)
+    {
+        Node& child = nodes[first + i];
+        child.visits.store(0, std::memory_order_relaxed);
+        child.points.store(0, std::memory_order_relaxed);
+        child.firstChild = 0;
+        child.move = moves[i];
+        child.childCount = 0;
+        child.state.store(UNEXPANDED, std::memory_order_relaxed);
+    }
+    t_node.firstChild = first;
+    t_node.childCount = static_cast<std::uint8_t>(count);
+    t_node.state.store(EXPANDED, std::memory_order_release);
+}
+
+std::uint32_t MonteCarloSearch::allocate(int t_count)
+{
+    if (m_full.load(std::memory_order_relaxed))
+    {
+        return NO_NODE;
+    }
+
+    std::uint32_t first = m_used.fetch_add(t_count, std::memory_order_relaxed);
+    if (first + t_count > m_capacity)
+    {
+        m_full.store(true, std::memory_order_relaxed);
+        return NO_NODE;
+    }
+    return first;
+}
+
+int MonteCarloSearch::playout(PlayoutBoard& t_board, std::uint64_t& t_random)
+{
+    for (int ply = 0; ply < MAX_PLAYOUT_PLIES && t_board.winner < 0; ++ply)
+    {
+        int side = t_board.sideToMove;
+        Bitboard occupied = t_board.players[0] | t_board.players[1];
+        Bitboard empty = ~occupied & FULL_BOARD;
+        Bitboard ownFours = getThreatCells(t_board.players[side], empty);
+        Bitboard theirFours = getThreatCells(t_board.players[side ^ 1], empty);
+
+        // finish a four if there is one, otherwise block theirs, otherwise anything
+        if (t_board.placing)
+        {
+            int types[3];
+            int typeCount = 0;
+            for (int type = 0; type < 3; ++type)
+            {
+                if (t_board.toPlace[side][type])
+                    types[typeCount++] = type + 1;
+            }
+
+            Bitboard cells = ownFours ? ownFours : (theirFours ? theirFours : empty);
+            int to = getNthSquare(cells, randomBelow(t_random, popCount(cells)));
+            t_board.play(packSquares(PLACEMENT_SOURCE, to, types[randomBelow(t_random, typeCount)]));
+            continue;
+        }
+
+        int froms[PIECES_PER_PLAYER];
+        Bitboard targets[PIECES_PER_PLAYER];
+        int pieceCount = 0;
+        int moveCount = 0;
+        Bitboard pieces = t_board.players[side];
+        while (pieces)
+        {
+            int from = popLowest(pieces);
+            PieceType type = (t_board.frogs & squareBit(from)) ? PieceType::FROG : (t_board.snakes & squareBit(from)) ? PieceType::SNAKE : PieceType::DONKEY;
+            froms[pieceCount] = from;
+            targets[pieceCount] = getPieceTargets(type, from, occupied);
+            moveCount += popCount(targets[pieceCount]);
+            ++pieceCount;
+        }
+        if (moveCount == 0)
+        {
+            return -1;  // stuck, nobody can win from here
+        }
+
+        // a piece taken out of its own window doesnt finish it, so each candidate is checked
+        int winFrom = -1;
+        int winTo = -1;
+        for (int i = 0; i < pieceCount && ownFours && winFrom < 0; ++i)
+        {
+            Bitboard wins = targets[i] & ownFours;
+            while (wins && winFrom < 0)
+            {
+                int to = popLowest(wins);
+                if (hasLineThrough((t_board.players[side] ^ squareBit(froms[i])) | squareBit(to), to))
+                {
+                    winFrom = froms[i];
+                    winTo = to;
+                }
+            }
+        }
+        if (winFrom >= 0)
+        {
+            t_board.play(packSquares(winFrom, winTo, 0));
+            continue;
+        }
+
+        int blockCount = 0;
+        for (int i = 0; i < pieceCount && theirFours; ++i)
+        {
+            blockCount += popCount(targets[i] & theirFours);
+        }
+        Bitboard filter = blockCount ? theirFours : FULL_BOARD;
+        int pick = randomBelow(t_random, blockCount ? blockCount : moveCount);
+        for (int i = 0; i < pieceCount; ++i)
+        {
+            int count = popCount(targets[i] & filter);
+            if (pick < count)
+            {
+                t_board.play(packSquares(froms[i], getNthSquare(targets[i] & filter, pick), 0));
+                break;
+            }
+            pick -= count;
+        }
+    }
+    return t_board.winner;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file MonteCarloSearch.h
+ * @brief Monte Carlo tree search (UCT) shared by several threads
+ * @authors: Kyle & Monika
+ *
+ * Instead of scoring positions with the evaluation, each iteration walks
+ * down the tree picking the child with the best UCT value (how often it
+ * won, plus a bonus for not having been tried much), plays the rest of the
+ * game out with quick moves from there and passes the result back up. The
+ * most visited root move is played.
+ *
+ * Every thread works on the same tree. A thread passing through a node
+ * counts a few losses there straight away (virtual loss) and takes them
+ * back once its result is in, so the other threads spread out over other
+ * moves instead of all following it. Visits and results are atomic
+ * counters and a node is expanded by whichever thread gets to it first,
+ * so there are no locks at all and the threads only ever wait on a cache
+ * line. Nothing depends on the order the threads finish in, which is why
+ * this scales across cores where alpha-beta has to search one move after
+ * another.
+ *
+ * Nodes come out of one big block (an arena), the children of a node side
+ * by side. Between moves the part of the tree under the new position
+ * (found up to two moves down) is copied into a second block and the rest
+ * is thrown away, so the visits it already has count towards the next
+ * search. Playouts run on PlayoutBoard, a few masks that are cheap to copy.
+ */
+
+#ifndef MONTE_CARLO_SEARCH_HPP
+#define MONTE_CARLO_SEARCH_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Grid.h"
+#include "MoveList.h"
+
+/**
+ * @struct PlayoutBoard
+ * @brief Just the masks and piece counts of a position, for playouts
+ *
+ * Moves are packed the same way as packMove() so they convert straight
+ * back to Moves
+ */
+struct PlayoutBoard
+{
+    Bitboard players[2];            ///< Cells owned by each player
+    Bitboard frogs;                 ///< Cells holding a frog
+    Bitboard snakes;                ///< Cells holding a snake
+    std::uint8_t toPlace[2][3];     ///< Pieces still to place by player and type (frog, snake, donkey)
+    std::uint8_t sideToMove;        ///< 0 for player one, 1 for player two
+    std::int8_t winner;             ///< Player who made a four, -1 if nobody has
+    bool placing;                   ///< Still in the placement phase
+
+    /**
+     * @brief Copies the pieces, counts and side to move out of a position
+     * @param t_position Position to copy
+     * @return Board with the same state
+     */
+    static PlayoutBoard fromPosition(const Position& t_position);
+
+    /**
+     * @brief Lists every move for the side to move
+     * @param t_moves Filled in with packed moves, room for MAX_MOVES
+     * @return Number of moves
+     */
+    int generateMoves(std::uint16_t* t_moves) const;
+
+    /**
+     * @brief Plays a packed move for the side to move
+     * @param t_move Move from generateMoves()
+     */
+    void play(std::uint16_t t_move);
+
+    bool operator==(const PlayoutBoard& t_other) const;
+};
+
+/**
+ * @class MonteCarloSearch
+ * @brief UCT search that keeps its tree from one move to the next
+ */
+class MonteCarloSearch
+{
+public:
+    /**
+     * @brief Creates the search, the tree isnt allocated until the first search
+     * @param t_megabytes Memory for the tree, half of it is kept free to copy the reused part into
+     */
+    explicit MonteCarloSearch(int t_megabytes);
+
+    /**
+     * @brief Searches a position on several threads
+     * @param t_position Position to search, the side to move is the one playing
+     * @param t_rootMoves Moves to pick between, not empty
+     * @param t_milliseconds Time allowed (0 for no limit)
+     * @param t_playouts Playouts allowed (0 for no limit)
+     * @param t_threads Threads to search with, 0 for one per core
+     * @return Most visited move, its score the percentage of points it scored
+     *
+     * With no limit at all the search stops once the tree is full, or after
+     * EXPAND_VISITS playouts per node it holds if the tree can never fill
+     * (every line ending in a four). A move that makes a four is played
+     * without any playouts
+     */
+    Move search(const Position& t_position, const MoveList& t_rootMoves, int t_milliseconds, std::uint64_t t_playouts, int t_threads);
+
+    /**
+     * @brief Gets the most visited root moves for the overlay
+     * @param t_visuals Replaced with up to t_count moves, the score is the visit count
+     * @param t_count Most moves to list, one per cell for placements
+     */
+    void getVisuals(std::vector<AIVisualisation>& t_visuals, int t_count) const;
+
+    /**
+     * @brief Throws the tree away, for a new game
+     */
+    void clear();
+
+    /**
+     * @brief Changes how much memory the tree can use, throwing it away
+     * @param t_megabytes New size in MB
+     */
+    void resize(int t_megabytes);
+
+    std::uint64_t getPlayouts() const { return m_playouts; }
+    std::uint64_t getReusedVisits() const { return m_reusedVisits; }
+    std::uint32_t getTreeSize() const;
+    int getMaxDepth() const { return m_maxDepth; }
+    int getSizeMB() const { return m_megabytes; }
+
+private:
+    /**
+     * @struct Node
+     * @brief One position in the tree, 16 bytes
+     */
+    struct Node
+    {
+        std::atomic<std::uint32_t> visits;      ///< Playouts through here, plus the virtual losses in flight
+        std::atomic<std::uint32_t> points;      ///< 2 per win and 1 per draw for the player who moved into this node
+        std::uint32_t firstChild;               ///< Arena index of the first child, set before state is EXPANDED
+        std::uint16_t move;                     ///< Packed move into this node
+        std::uint8_t childCount;                ///< Number of children, set before state is EXPANDED
+        std::atomic<std::uint8_t> state;        ///< UNEXPANDED, EXPANDING or EXPANDED
+    };
+
+    static const std::uint8_t UNEXPANDED = 0;   ///< No children yet
+    static const std::uint8_t EXPANDING = 1;    ///< A thread is adding the children
+    static const std::uint8_t EXPANDED = 2;     ///< Children are ready (none means the side to move is stuck)
+    static const std::uint32_t NO_NODE = 0xFFFFFFFF;   ///< Index for a missing node
+    static const std::uint32_t VIRTUAL_LOSS = 3;        ///< Losses a node is charged while a thread is below it
+    static const std::uint32_t EXPAND_VISITS = 4;       ///< Visits a leaf needs before it gets children
+    static const int MAX_TREE_DEPTH = 64;               ///< Deepest the walk down the tree goes
+    static const int MAX_PLAYOUT_PLIES = 80;            ///< Playouts past this are draws (pieces can shuffle forever)
+    static const int CHECK_INTERVAL = 64;               ///< Iterations between looking at the clock
+    static constexpr float EXPLORATION = 1.4f;          ///< UCT exploration constant
+
+    int m_megabytes;                            ///< Size asked for in MB
+    std::uint32_t m_capacity;                   ///< Nodes each arena holds
+    std::unique_ptr<Node[]> m_arenas[2];        ///< The tree, and the spare block the reused part is copied into
+    int m_current;                              ///< Arena the tree is in
+    std::atomic<std::uint32_t> m_used;          ///< Nodes handed out, can go past m_capacity when it runs out
+    std::atomic<bool> m_full;                   ///< An expansion failed for lack of room
+    bool m_hasTree;                             ///< m_rootBoard and the tree are from an earlier search
+
+    PlayoutBoard m_rootBoard;                   ///< Position at node 0
+    std::atomic<bool> m_stop;                   ///< Set when the budget runs out
+    std::atomic<std::uint64_t> m_completed;     ///< Playouts finished this search, added in CHECK_INTERVAL blocks
+    std::atomic<int> m_deepest;                 ///< Deepest walk down the tree this search
+    std::uint64_t m_playoutLimit;               ///< Stop once m_completed gets here, 0 for no limit
+    bool m_stopWhenFull;                        ///< No limits were given
+    std::chrono::steady_clock::time_point m_deadline;  ///< When to stop, if there is a time limit
+    bool m_hasDeadline;                         ///< A time limit was given
+
+    std::uint64_t m_playouts;                   ///< Playouts in the last search
+    std::uint64_t m_reusedVisits;               ///< Root visits carried over into the last search
+    int m_maxDepth;                             ///< Deepest walk in the last search
+
+    Node* getNodes() const { return m_arenas[m_current].get(); }
+
+    /**
+     * @brief Finds the node for a position in the tree from the last search
+     * @param t_board Position to look for, at most two moves after the old root
+     * @return Arena index of the node, NO_NODE if it isnt there
+     */
+    std::uint32_t findReusable(const PlayoutBoard& t_board) const;
+
+    /**
+     * @brief Copies a subtree into the spare arena as the new root and switches to it
+     * @param t_old Arena index of the node to keep, NO_NODE to start from nothing
+     * @param t_rootMoves Moves the new root gets as children, keeping what the old ones had found
+     */
+    void rebuildTree(std::uint32_t t_old, const MoveList& t_rootMoves);
+
+    /**
+     * @brief Runs iterations until the budget runs out, on each thread
+     * @param t_seed Seed for this thread's playouts
+     */
+    void runThread(std::uint64_t t_seed);
+
+    /**
+     * @brief Walks down the tree, plays out and passes the result back up
+     * @param t_random This thread's random state
+     * @return How deep the walk went
+     */
+    int iterate(std::uint64_t& t_random);
+
+    /**
+     * @brief Picks the child with the best UCT value
+     * @param t_node Expanded node with at least one child
+     * @return The child to go down
+     */
+    Node& selectChild(const Node& t_node) const;
+
+    /**
+     * @brief Adds a leaf's children, unless another thread already is
+     * @param t_node Leaf to expand
+     * @param t_board Position at the leaf
+     */
+    void expand(Node& t_node, const PlayoutBoard& t_board);
+
+    /**
+     * @brief Hands out a block of nodes from the arena
+     * @param t_count Nodes needed
+     * @return Index of the first, NO_NODE if the arena is full
+     */
+    std::uint32_t allocate(int t_count);
+
+    /**
+     * @brief Plays a game out with quick moves
+     * @param t_board Position to start from, played on
+     * @param t_random This thread's random state
+     * @return Player who won (0 or 1), -1 for a draw
+     */
+    static int playout(PlayoutBoard& t_board, std::uint64_t& t_random);
+};
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * @file MoveList.h
+ * @brief Fixed capacity lists that live on the stack instead of the heap
+ * @authors: Kyle & Monika
+ *
+ * A side never has more than MAX_MOVES moves, so the search keeps its move
+ * lists in plain arrays inside each ply's stack frame rather than in
+ * vectors. Nothing the search does per node allocates memory.
+ */
+
+#ifndef MOVE_LIST_HPP
+#define MOVE_LIST_HPP
+
+#include <cassert>
+#include <utility>
+#include "Position.h"
+
+static const int MAX_MOVES = 3 * NUM_SQUARES;   ///< Most moves one side can have (a placement: any piece type on any cell)
+static const int MAX_DESTINATIONS = 8;          ///< Most cells one piece can move to
+
+/**
+ * @class FixedList
+ * @brief Vector-like list with its storage inline
+ * @tparam T Item type
+ * @tparam Capacity Most items the list can hold
+ */
+template <typename T, int Capacity>
+class FixedList
+{
+public:
+    FixedList() : m_size(0) {}
+
+    /**
+     * @brief Adds an item to the end
+     * @param t_item Item to add, the list must not be full
+     */
+    void push_back(const T& t_item)
+    {
+        assert(m_size < Capacity && "FixedList is full");
+        m_items[m_size++] = t_item;
+    }
+
+    /**
+     * @brief Drops every item from t_size on
+     * @param t_size New size, no bigger than the current one
+     */
+    void shrink(int t_size)
+    {
+        assert(t_size >= 0 && t_size <= m_size);
+        m_size = t_size;
+    }
+
+    void clear() { m_size = 0; }
+    int size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    T& operator[](int t_index) { return m_items[t_index]; }
+    const T& operator[](int t_index) const { return m_items[t_index]; }
+
+    T* begin() { return m_items; }
+    T* end() { return m_items + m_size; }
+    const T* begin() const { return m_items; }
+    const T* end() const { return m_items + m_size; }
+
+private:
+    T m_items[Capacity];    ///< Storage, only the first m_size are in use
+    int m_size;             ///< Items in use
+};
+
+typedef FixedList<Move, MAX_MOVES> MoveList;    ///< Every move for one side
+typedef FixedList<std::pair<int, int>, MAX_DESTINATIONS> CellList;  ///< (row, col) cells one piece can reach
+
+#endif
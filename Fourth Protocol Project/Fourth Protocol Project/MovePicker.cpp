@@ -0,0 +1,232 @@
+#include "MovePicker.h"
+#include "TranspositionTable.h"
+#include <cstdlib>
+#include <utility>
+
+MovePicker::MovePicker(const Position& t_position, std::uint16_t t_tableMove, const std::uint16_t t_killers[2], const HistoryTable& t_history) :
+    m_position(t_position),
+    m_history(t_history),
+    m_player(t_position.getSideToMove()),
+    m_stage(Stage::TABLE_MOVE),
+    m_tableMove(t_tableMove),
+    m_killerIndex(0),
+    m_skipQuiets(false),
+    m_threats(),
+    m_count(0),
+    m_index(0)
+{
+    m_killers[0] = t_killers[0];
+    m_killers[1] = t_killers[1];
+    for (Bitboard& mask : m_handedOut)
+    {
+        mask = 0;
+    }
+}
+
+bool MovePicker::next(Move& t_move)
+{
+    while (true)
+    {
+        switch (m_stage)
+        {
+        case Stage::TABLE_MOVE:
+            {
+                bool found = takePacked(m_tableMove, t_move);
+
+                // moves onto a cell that finishes one of our threes (after the table move so its skipped)
+                m_stage = Stage::WINS;
+                m_threats = m_position.getThreatMap();
+                generate(m_threats.getFours(m_player));
+                if (found)
+                {
+                    return true;
+                }
+            }
+            break;
+
+        case Stage::WINS:
+            while (m_index < m_count)
+            {
+                const Move& move = m_moves[m_index++];
+                int to = move.toRow * GRID_SIZE + move.toCol;
+
+                // the piece that moves might be part of the line it lands on, a placed piece always finishes it
+                Bitboard after = m_position.getPlayerMask(m_player);
+                if (move.fromRow != -1)
+                    after &= ~squareBit(move.fromRow * GRID_SIZE + move.fromCol);
+                after |= squareBit(to);
+                if (hasLineThrough(after, to))
+                {
+                    t_move = move;
+                    markHandedOut(t_move);
+                    return true;
+                }
+            }
+
+            // anything left onto the threat cells goes to the quiet stage (it was never handed out)
+            m_stage = Stage::BLOCKS;
+            generate(m_threats.getFours((m_player == Player::PLAYER_ONE) ? Player::PLAYER_TWO : Player::PLAYER_ONE));
+            break;
+
+        case Stage::BLOCKS:
+            if (m_index < m_count)
+            {
+                t_move = m_moves[m_index++];
+                markHandedOut(t_move);
+                return true;
+            }
+            m_stage = m_skipQuiets ? Stage::DONE : Stage::KILLERS;
+            break;
+
+        case Stage::KILLERS:
+            while (m_killerIndex < 2)
+            {
+                if (takePacked(m_killers[m_killerIndex++], t_move))
+                {
+                    return true;
+                }
+            }
+
+            m_stage = Stage::QUIETS;
+            generate(FULL_BOARD);
+            for (int i = 0; i < m_count; ++i)
+            {
+                Move& move = m_moves[i];
+                int to = move.toRow * GRID_SIZE + move.toCol;
+                move.score = m_history[getMoveSource(move)][to] * 1024 + getTieBreakScore(m_position, move, m_player);
+            }
+            break;
+
+        case Stage::QUIETS:
+            if (m_index < m_count)
+            {
+                // pick the best one left rather than sorting them all, most nodes never get this far
+                int best = m_index;
+                for (int i = m_index + 1; i < m_count; ++i)
+                {
+                    if (m_moves[i].score > m_moves[best].score)
+                    {
+                        best = i;
+                    }
+                }
+                std::swap(m_moves[m_index], m_moves[best]);
+                t_move = m_moves[m_index++];
+                return true;
+            }
+            m_stage = Stage::DONE;
+            break;
+
+        case Stage::DONE:
+            return false;
+        }
+    }
+}
+
+int MovePicker::getTieBreakScore(const Position& t_position, const Move& t_move, Player t_player)
+{
+    int moveScore = 0;
+
+    // Prioritize moves toward center
+    int centerDist = abs(t_move.toRow - 2) + abs(t_move.toCol - 2);
+    moveScore += (8 - centerDist) * 5;
+
+    // Check if move stops opponent piece
+    if (t_position.getCellOwner(t_move.toRow, t_move.toCol) != Player::NONE)
+    {
+        moveScore += 100; // higher score
+    }
+
+    // Count adjacent friendly pieces
+    int to = t_move.toRow * GRID_SIZE + t_move.toCol;
+    moveScore += popCount(KING_STEPS[to] & t_position.getPlayerMask(t_player)) * 10;
+
+    return moveScore;
+}
+
+void MovePicker::generate(Bitboard t_targets)
+{
+    m_count = 0;
+    m_index = 0;
+
+    if (m_position.getGameState() == GameState::PLACEMENT)
+    {
+        const PieceType types[] = { PieceType::FROG, PieceType::SNAKE, PieceType::DONKEY };
+        for (PieceType type : types)
+        {
+            if (m_position.getRemainingPieces(m_player, type) == 0)
+            {
+                continue;
+            }
+
+            Move move = { -1, -1, -1, -1, 0 };
+            move.pieceType = type;
+            Bitboard cells = m_position.getEmptyMask() & t_targets & ~m_handedOut[getMoveSource(move)];
+            while (cells)
+            {
+                int to = popLowest(cells);
+                move.toRow = to / GRID_SIZE;
+                move.toCol = to % GRID_SIZE;
+                m_moves[m_count++] = move;
+            }
+        }
+        return;
+    }
+
+    Bitboard pieces = m_position.getPlayerMask(m_player);
+    while (pieces)
+    {
+        int from = popLowest(pieces);
+        Bitboard targets = m_position.getMoveTargets(from) & t_targets & ~m_handedOut[from];
+
+        while (targets)
+        {
+            int to = popLowest(targets);
+            m_moves[m_count++] = { from / GRID_SIZE, from % GRID_SIZE, to / GRID_SIZE, to % GRID_SIZE, 0 };
+        }
+    }
+}
+
+bool MovePicker::takePacked(std::uint16_t t_packed, Move& t_move)
+{
+    if (t_packed == 0)
+    {
+        return false;
+    }
+
+    // table moves can come from another position, so make sure it works in this one
+    Move move = unpackMove(t_packed);
+    int to = move.toRow * GRID_SIZE + move.toCol;
+    if ((m_handedOut[getMoveSource(move)] & squareBit(to)) ||
+        (move.fromRow == -1) != (m_position.getGameState() == GameState::PLACEMENT))
+    {
+        return false;
+    }
+
+    if (move.fromRow == -1)
+    {
+        if (move.pieceType == PieceType::NONE ||
+            m_position.getRemainingPieces(m_player, move.pieceType) == 0 ||
+            !(m_position.getEmptyMask() & squareBit(to)))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        int from = move.fromRow * GRID_SIZE + move.fromCol;
+        if (!(m_position.getPlayerMask(m_player) & squareBit(from)) ||
+            !(m_position.getMoveTargets(from) & squareBit(to)))
+        {
+            return false;
+        }
+    }
+
+    t_move = move;
+    markHandedOut(t_move);
+    return true;
+}
+
+void MovePicker::markHandedOut(const Move& t_move)
+{
+    m_handedOut[getMoveSource(t_move)] |= squareBit(t_move.toRow * GRID_SIZE + t_move.toCol);
+}
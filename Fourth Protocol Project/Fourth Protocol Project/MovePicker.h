@@ -0,0 +1,141 @@
+/**
+ * @file MovePicker.h
+ * @brief Hands out moves to the search one at a time, best guesses first
+ * @authors: Kyle & Monika
+ */
+
+#ifndef MOVE_PICKER_HPP
+#define MOVE_PICKER_HPP
+
+#include <cstdint>
+#include "Position.h"
+#include "MoveList.h"
+
+static const int NUM_MOVE_SOURCES = NUM_SQUARES + 3;  ///< Cells a piece can move from, then one per piece type for placements
+
+typedef int HistoryTable[NUM_MOVE_SOURCES][NUM_SQUARES];   ///< Cutoff score by source (see getMoveSource) and to cell
+
+/**
+ * @brief Gets where a move comes from, for the history table
+ * @param t_move The move
+ * @return The from cell, or NUM_SQUARES + type - 1 for a placement
+ */
+inline int getMoveSource(const Move& t_move)
+{
+    if (t_move.fromRow == -1)
+    {
+        return NUM_SQUARES + static_cast<int>(t_move.pieceType) - 1;
+    }
+    return t_move.fromRow * GRID_SIZE + t_move.fromCol;
+}
+
+/**
+ * @class MovePicker
+ * @brief Staged move generator for the alpha-beta search
+ *
+ * Most nodes cut off after the first move or two, so sorting every move up
+ * front is mostly wasted. The picker works in stages and only generates a
+ * stage once the one before it has run out:
+ * - the transposition table move
+ * - moves that finish a four in a row
+ * - moves that block the opponent's three
+ * - the two killer moves for this ply
+ * - everything else, best history score first
+ *
+ * During placement the moves are placements (a piece type and an empty
+ * cell) and go through the same stages.
+ *
+ * A move is only ever handed out once. Everything lives inside the picker,
+ * so making one allocates nothing.
+ */
+class MovePicker
+{
+public:
+    /**
+     * @brief Sets up the picker for the side to move
+     * @param t_position Position to pick moves in (must outlive the picker)
+     * @param t_tableMove Packed move from the transposition table, 0 if none
+     * @param t_killers The two killer moves for this ply (packed, 0 if none)
+     * @param t_history History table for the side to move
+     */
+    MovePicker(const Position& t_position, std::uint16_t t_tableMove, const std::uint16_t t_killers[2], const HistoryTable& t_history);
+
+    /**
+     * @brief Gets the next move to try
+     * @param t_move Filled in with the move
+     * @return False once there are no moves left
+     */
+    bool next(Move& t_move);
+
+    /**
+     * @brief The old fixed ordering score, used to break history ties
+     * @param t_position Position the move is made in
+     * @param t_move The move
+     * @param t_player Player making the move
+     * @return Score from closeness to the centre and friendly neighbours (always under 1024)
+     */
+    static int getTieBreakScore(const Position& t_position, const Move& t_move, Player t_player);
+
+    /**
+     * @brief Checks if the last move handed out was a killer or a quiet move
+     * @return False for the table move, wins and blocks
+     */
+    bool isLastMoveQuiet() const { return m_stage == Stage::KILLERS || m_stage == Stage::QUIETS || m_stage == Stage::DONE; }
+
+    /**
+     * @brief Stops the picker after the wins and blocks, for the quiescence search
+     */
+    void skipQuietMoves() { m_skipQuiets = true; }
+
+private:
+    /**
+     * @enum Stage
+     * @brief Which group of moves the picker is handing out
+     */
+    enum class Stage
+    {
+        TABLE_MOVE,
+        WINS,
+        BLOCKS,
+        KILLERS,
+        QUIETS,
+        DONE
+    };
+
+    const Position& m_position;             ///< Position being searched
+    const HistoryTable& m_history;          ///< History scores for the side to move
+    Player m_player;                        ///< Side to move
+    Stage m_stage;                          ///< Current stage
+    std::uint16_t m_tableMove;              ///< Transposition table move
+    std::uint16_t m_killers[2];             ///< Killer moves for this ply
+    int m_killerIndex;                      ///< Next killer to try
+    bool m_skipQuiets;                      ///< Finish after the blocks stage
+    ThreatMap m_threats;                    ///< Cells that win or block, worked out once for both stages
+
+    Move m_moves[MAX_MOVES];                ///< Moves generated for the current stage
+    int m_count;                            ///< Number of moves in m_moves
+    int m_index;                            ///< Next move to hand out from m_moves
+    Bitboard m_handedOut[NUM_MOVE_SOURCES]; ///< Destinations already handed out, by source
+
+    /**
+     * @brief Fills m_moves with every move onto the given cells not handed out yet
+     * @param t_targets Destinations to generate
+     */
+    void generate(Bitboard t_targets);
+
+    /**
+     * @brief Checks a packed move from a table is legal here and not handed out yet
+     * @param t_packed Packed move
+     * @param t_move Filled in with the unpacked move if it is
+     * @return True if the move can be handed out
+     */
+    bool takePacked(std::uint16_t t_packed, Move& t_move);
+
+    /**
+     * @brief Marks a move as handed out
+     * @param t_move The move
+     */
+    void markHandedOut(const Move& t_move);
+};
+
+#endif
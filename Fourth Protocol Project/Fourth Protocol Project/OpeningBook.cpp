@@ -0,0 +1,133 @@
+#include "OpeningBook.h"
+#include "TranspositionTable.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+static const char BOOK_MAGIC[8] = { 'F', 'P', 'B', 'O', 'O', 'K', 0, 0 };
+static const std::uint32_t BOOK_VERSION = 1;
+
+OpeningBook::OpeningBook() :
+    m_entries(nullptr),
+    m_count(0)
+{
+}
+
+bool OpeningBook::open(const std::string& t_path)
+{
+    close();
+    static_assert(sizeof(Entry) == 16 && sizeof(Header) == 16, "the book layout has to match the file");
+
+    if (!m_file.open(t_path) || m_file.getSize() < sizeof(Header))
+    {
+        m_file.close();
+        return false;
+    }
+
+    // files are written little endian by write(), same as every machine this runs on
+    Header header;
+    std::memcpy(&header, m_file.getData(), sizeof(Header));
+    if (std::memcmp(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0 ||
+        header.version != BOOK_VERSION ||
+        m_file.getSize() != sizeof(Header) + static_cast<std::size_t>(header.count) * sizeof(Entry))
+    {
+        m_file.close();
+        return false;
+    }
+
+    // mapped views are page aligned and the header is 16 bytes, so the entries are aligned too
+    m_entries = reinterpret_cast<const Entry*>(m_file.getData() + sizeof(Header));
+    m_count = header.count;
+    return true;
+}
+
+void OpeningBook::close()
+{
+    m_file.close();
+    m_entries = nullptr;
+    m_count = 0;
+}
+
+bool OpeningBook::probe(const Position& t_position, Move& t_move) const
+{
+    if (!m_entries || t_position.getGameState() != GameState::PLACEMENT)
+    {
+        return false;
+    }
+
+    int symmetry;
+    std::uint64_t key = t_position.getCanonicalKey(symmetry);
+    const Entry* end = m_entries + m_count;
+    const Entry* entry = std::lower_bound(m_entries, end, key,
+        [](const Entry& t_entry, std::uint64_t t_key) { return t_entry.key < t_key; });
+    if (entry == end || entry->key != key || entry->move == 0)
+    {
+        return false;
+    }
+
+    // turn it back to this board, and make sure its a real placement here in case of a hash collision
+    Move move = unpackMove(Symmetry::transformPackedMove(entry->move, INVERSE_SYMMETRY[symmetry]));
+    if (move.fromRow != -1 || move.pieceType == PieceType::NONE ||
+        t_position.getRemainingPieces(t_position.getSideToMove(), move.pieceType) == 0 ||
+        !t_position.isCellEmpty(move.toRow, move.toCol))
+    {
+        return false;
+    }
+
+    move.score = entry->score;
+    t_move = move;
+    return true;
+}
+
+OpeningBook::Entry OpeningBook::makeEntry(const Position& t_position, const Move& t_move, int t_depth)
+{
+    int symmetry;
+    Entry entry;
+    entry.key = t_position.getCanonicalKey(symmetry);
+    entry.score = t_move.score;
+    entry.move = Symmetry::transformPackedMove(packMove(t_move), symmetry);
+    entry.depth = static_cast<std::uint8_t>(std::min(t_depth, 255));
+    entry.reserved = 0;
+    return entry;
+}
+
+bool OpeningBook::write(const std::string& t_path, std::vector<Entry> t_entries)
+{
+    std::sort(t_entries.begin(), t_entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+
+    Header header;
+    std::memcpy(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    header.version = BOOK_VERSION;
+    header.count = static_cast<std::uint32_t>(t_entries.size());
+
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(t_path).parent_path();
+    if (!parent.empty())
+    {
+        std::filesystem::create_directories(parent, error);
+    }
+
+    // a game can have the old book mapped, so the new one is written beside it and renamed over it
+    // (truncating it in place would pull the pages out from under that game)
+    std::string temporary = t_path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.write(reinterpret_cast<const char*>(t_entries.data()), static_cast<std::streamsize>(t_entries.size() * sizeof(Entry)));
+        if (!file)
+        {
+            std::cerr << "Couldnt write " << temporary << std::endl;
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, t_path, error);
+    if (error)
+    {
+        std::cerr << "Couldnt replace " << t_path << " (is a game using it?)" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file OpeningBook.h
+ * @brief Placements worked out ahead of time for the start of the game
+ * @authors: Kyle & Monika
+ *
+ * The first few placements are the same positions every game, so a deep
+ * search of them is done once offline (Tools, --build-book) and saved.
+ * The file is a small header and then fixed size entries sorted by the
+ * position's canonical hash, so a lookup is a binary search straight on
+ * the mapped file and nothing has to be read in when the game starts.
+ * Moves are stored turned to the canonical board, so one entry covers all
+ * 8 mirror images of a position.
+ */
+
+#ifndef OPENING_BOOK_HPP
+#define OPENING_BOOK_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Position.h"
+
+/**
+ * @class OpeningBook
+ * @brief Read-only book of best placements, keyed by canonical hash
+ */
+class OpeningBook
+{
+public:
+    /**
+     * @struct Entry
+     * @brief One position's book move, as stored in the file
+     */
+    struct Entry
+    {
+        std::uint64_t key;      ///< Canonical hash of the position (see Position::getCanonicalKey)
+        std::int32_t score;     ///< Search score for the side to move
+        std::uint16_t move;     ///< Best placement (packed), turned to the canonical board
+        std::uint8_t depth;     ///< Depth the search finished
+        std::uint8_t reserved;  ///< Always 0
+    };
+
+    OpeningBook();
+
+    /**
+     * @brief Maps a book file, replacing any book already open
+     * @param t_path Path of the file
+     * @return False if the file is missing or isnt a book (the old book is closed either way)
+     */
+    bool open(const std::string& t_path);
+
+    /**
+     * @brief Closes the book
+     */
+    void close();
+
+    /**
+     * @brief Looks up the book move for a position
+     * @param t_position Position to look up, the side to move is the one playing
+     * @param t_move Filled in with the move (turned to match t_position) and its score
+     * @return True if the position is in the book and the move is legal in it
+     */
+    bool probe(const Position& t_position, Move& t_move) const;
+
+    bool isOpen() const { return m_entries != nullptr; }
+    std::size_t getSize() const { return m_count; }
+
+    /**
+     * @brief Builds the entry for a position and the move found for it
+     * @param t_position Position that was searched
+     * @param t_move Best move found, with its score
+     * @param t_depth Depth the search finished
+     * @return Entry ready to be written
+     */
+    static Entry makeEntry(const Position& t_position, const Move& t_move, int t_depth);
+
+    /**
+     * @brief Sorts entries and writes them out as a book file
+     * @param t_path Path of the file to write, its folder is made if it isnt there
+     * @param t_entries Entries to write, one per canonical position
+     * @return False if the file couldnt be written
+     *
+     * Writes a .tmp file and renames it over the old book, so anything
+     * that still has the old one mapped keeps reading it safely
+     */
+    static bool write(const std::string& t_path, std::vector<Entry> t_entries);
+
+private:
+    /**
+     * @struct Header
+     * @brief Start of a book file
+     */
+    struct Header
+    {
+        char magic[8];          ///< BOOK_MAGIC
+        std::uint32_t version;  ///< BOOK_VERSION
+        std::uint32_t count;    ///< Number of entries after the header
+    };
+
+    MappedFile m_file;              ///< The mapped book
+    const Entry* m_entries;         ///< First entry in the mapped file, nullptr when closed
+    std::size_t m_count;            ///< Number of entries
+};
+
+#endif
@@ -0,0 +1,497 @@
+#include "Position.h"
+#include "Evaluation.h"
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<Position>::value, "Position has to stay a plain copyable type");
+
+Position Position::fromGrid(const Grid& t_grid)
+{
+    Position position;
+    position.clearBoard();
+
+    for (int row = 0; row < GRID_SIZE; ++row)
+    {
+        for (int col = 0; col < GRID_SIZE; ++col)
+        {
+            if (!t_grid.isCellEmpty(row, col))
+            {
+                position.putPiece(row, col, t_grid.getPieceType(row, col), t_grid.getCellOwner(row, col));
+            }
+        }
+    }
+
+    // grid only tracks whats left so work back to whats been placed
+    const PieceType types[] = { PieceType::FROG, PieceType::SNAKE, PieceType::DONKEY };
+    const Player players[] = { Player::PLAYER_ONE, Player::PLAYER_TWO };
+    for (Player player : players)
+    {
+        position.m_piecesPlaced[playerIndex(player)][static_cast<int>(PieceType::NONE)] = 0;
+        for (PieceType type : types)
+        {
+            position.m_piecesPlaced[playerIndex(player)][static_cast<int>(type)] =
+                getMaxPiecesForType(type) - t_grid.getRemainingPieces(player, type);
+        }
+    }
+
+    position.m_sideToMove = t_grid.getCurrentPlayer();
+    position.m_gameState = t_grid.getGameState();
+    position.m_winner = (position.m_gameState == GameState::GAME_OVER) ? t_grid.getWinner() : Player::NONE;
+    position.m_ply = 0;
+    if (position.m_sideToMove == Player::PLAYER_TWO)
+    {
+        position.m_key ^= Zobrist::SIDE_KEY;
+    }
+
+    return position;
+}
+
+Position Position::startingPosition()
+{
+    Position position;
+    position.clearBoard();
+    for (int player = 0; player < 2; ++player)
+    {
+        for (int type = 0; type < 4; ++type)
+        {
+            position.m_piecesPlaced[player][type] = 0;
+        }
+    }
+
+    position.m_sideToMove = Player::PLAYER_ONE;
+    position.m_gameState = GameState::PLACEMENT;
+    position.m_winner = Player::NONE;
+    position.m_ply = 0;
+    return position;
+}
+
+std::uint64_t Position::getCanonicalKey() const
+{
+    int symmetry;
+    return getCanonicalKey(symmetry);
+}
+
+std::uint64_t Position::getCanonicalKey(int& t_symmetry) const
+{
+    t_symmetry = 0;
+    for (int symmetry = 1; symmetry < NUM_SYMMETRIES; ++symmetry)
+    {
+        if (m_symmetryKeys[symmetry] < m_symmetryKeys[t_symmetry])
+        {
+            t_symmetry = symmetry;
+        }
+    }
+
+    // m_key only differs from the unturned pieces hash by the side to move key
+    return m_symmetryKeys[t_symmetry] ^ (m_key ^ m_symmetryKeys[0]);
+}
+
+std::uint8_t Position::getSymmetries() const
+{
+    std::uint8_t symmetries = 1;
+    for (int symmetry = 1; symmetry < NUM_SYMMETRIES; ++symmetry)
+    {
+        // exact masks rather than the hashes, so a collision cant drop a real move
+        bool same = transformBoard(m_playerMasks[0], symmetry) == m_playerMasks[0] &&
+            transformBoard(m_playerMasks[1], symmetry) == m_playerMasks[1];
+        for (int type = 1; type < 4 && same; ++type)
+        {
+            same = transformBoard(m_typeMasks[type], symmetry) == m_typeMasks[type];
+        }
+
+        if (same)
+        {
+            symmetries |= 1 << symmetry;
+        }
+    }
+    return symmetries;
+}
+
+Position Position::getTransformed(int t_symmetry) const
+{
+    Position position = *this;
+    position.clearBoard();
+
+    for (int square = 0; square < NUM_SQUARES; ++square)
+    {
+        int row = square / GRID_SIZE;
+        int col = square % GRID_SIZE;
+        if (!isCellEmpty(row, col))
+        {
+            int target = SYMMETRY_SQUARES[t_symmetry][square];
+            position.putPiece(target / GRID_SIZE, target % GRID_SIZE, getPieceType(row, col), getCellOwner(row, col));
+        }
+    }
+
+    position.m_ply = 0;
+    if (m_sideToMove == Player::PLAYER_TWO)
+    {
+        position.m_key ^= Zobrist::SIDE_KEY;
+    }
+    return position;
+}
+
+Position Position::getCanonical() const
+{
+    int symmetry;
+    getCanonicalKey(symmetry);
+    return getTransformed(symmetry);
+}
+
+void Position::make(const Move& t_move)
+{
+    assert(m_ply < MAX_PLY && "Position undo stack is full");
+    Undo& undo = m_history[m_ply++];
+    undo.move = t_move;
+    undo.sideToMove = m_sideToMove;
+    undo.gameState = m_gameState;
+    undo.winner = m_winner;
+    undo.key = m_key;
+
+    Player mover = m_sideToMove;
+
+    if (t_move.fromRow == -1)
+    {
+        // placement, same as Grid::placePiece
+        putPiece(t_move.toRow, t_move.toCol, t_move.pieceType, mover);
+        m_piecesPlaced[playerIndex(mover)][static_cast<int>(t_move.pieceType)]++;
+    }
+    else
+    {
+        PieceType type = getPieceType(t_move.fromRow, t_move.fromCol);
+        removePiece(t_move.fromRow, t_move.fromCol);
+        putPiece(t_move.toRow, t_move.toCol, type, mover);
+    }
+
+    // only the windows through the destination can have just been finished
+    if (hasLineThrough(getPlayerMask(mover), t_move.toRow * GRID_SIZE + t_move.toCol))
+    {
+        m_winner = mover;
+        m_gameState = GameState::GAME_OVER;
+    }
+    else if (m_gameState == GameState::PLACEMENT &&
+        getTotalPiecesRemaining(Player::PLAYER_ONE) == 0 &&
+        getTotalPiecesRemaining(Player::PLAYER_TWO) == 0)
+    {
+        m_gameState = GameState::MOVEMENT;
+    }
+
+    m_sideToMove = (mover == Player::PLAYER_ONE) ? Player::PLAYER_TWO : Player::PLAYER_ONE;
+    m_key ^= Zobrist::SIDE_KEY;
+}
+
+void Position::unmake()
+{
+    const Undo& undo = m_history[--m_ply];
+    const Move& move = undo.move;
+
+    m_sideToMove = undo.sideToMove;
+    m_gameState = undo.gameState;
+    m_winner = undo.winner;
+
+    if (move.fromRow == -1)
+    {
+        removePiece(move.toRow, move.toCol);
+        m_piecesPlaced[playerIndex(m_sideToMove)][static_cast<int>(move.pieceType)]--;
+    }
+    else
+    {
+        PieceType type = getPieceType(move.toRow, move.toCol);
+        removePiece(move.toRow, move.toCol);
+        putPiece(move.fromRow, move.fromCol, type, m_sideToMove);
+    }
+
+    m_key = undo.key;
+}
+
+void Position::makeNull()
+{
+    assert(m_ply < MAX_PLY && "Position undo stack is full");
+    Undo& undo = m_history[m_ply++];
+    undo.move = { -1, -1, -1, -1, 0 };
+    undo.sideToMove = m_sideToMove;
+    undo.gameState = m_gameState;
+    undo.winner = m_winner;
+    undo.key = m_key;
+
+    m_sideToMove = (m_sideToMove == Player::PLAYER_ONE) ? Player::PLAYER_TWO : Player::PLAYER_ONE;
+    m_key ^= Zobrist::SIDE_KEY;
+}
+
+void Position::unmakeNull()
+{
+    const Undo& undo = m_history[--m_ply];
+    m_sideToMove = undo.sideToMove;
+    m_key = undo.key;
+}
+
+void Position::putPiece(int t_row, int t_col, PieceType t_type, Player t_owner)
+{
+    int square = t_row * GRID_SIZE + t_col;
+    m_playerMasks[playerIndex(t_owner)] |= squareBit(square);
+    m_typeMasks[static_cast<int>(t_type)] |= squareBit(square);
+    m_key ^= Zobrist::pieceKey(playerIndex(t_owner), static_cast<int>(t_type), square);
+    const std::uint64_t* symmetryKeys = Zobrist::SYMMETRY_KEYS[playerIndex(t_owner) * 4 + static_cast<int>(t_type)][square].data();
+    for (int symmetry = 0; symmetry < NUM_SYMMETRIES; ++symmetry)
+    {
+        m_symmetryKeys[symmetry] ^= symmetryKeys[symmetry];
+    }
+    updateEvaluation(square, t_owner, 1);
+}
+
+void Position::removePiece(int t_row, int t_col)
+{
+    if (isCellEmpty(t_row, t_col))
+    {
+        return;
+    }
+
+    int square = t_row * GRID_SIZE + t_col;
+    Player owner = getCellOwner(t_row, t_col);
+    int type = static_cast<int>(getPieceType(t_row, t_col));
+    m_key ^= Zobrist::pieceKey(playerIndex(owner), type, square);
+    const std::uint64_t* symmetryKeys = Zobrist::SYMMETRY_KEYS[playerIndex(owner) * 4 + type][square].data();
+    for (int symmetry = 0; symmetry < NUM_SYMMETRIES; ++symmetry)
+    {
+        m_symmetryKeys[symmetry] ^= symmetryKeys[symmetry];
+    }
+
+    Bitboard keep = ~squareBit(square);
+    m_playerMasks[0] &= keep;
+    m_playerMasks[1] &= keep;
+    for (int i = 0; i < 4; ++i)
+    {
+        m_typeMasks[i] &= keep;
+    }
+    updateEvaluation(square, owner, -1);
+}
+
+void Position::clearBoard()
+{
+    m_key = 0;
+    for (int symmetry = 0; symmetry < NUM_SYMMETRIES; ++symmetry)
+    {
+        m_symmetryKeys[symmetry] = 0;
+    }
+    m_playerMasks[0] = 0;
+    m_playerMasks[1] = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        m_typeMasks[i] = 0;
+    }
+
+    std::memset(m_linePatterns, 0, sizeof(m_linePatterns));
+    for (int player = 0; player < 2; ++player)
+    {
+        m_fullLines[player] = 0;
+        m_lineScore[player] = 0;
+        m_pieceScore[player] = 0;
+    }
+}
+
+void Position::updateEvaluation(int t_square, Player t_owner, int t_change)
+{
+    int own = playerIndex(t_owner);
+    int digit = t_change * (own + 1);
+
+    // only the windows through this cell change, swap their old pattern's scores for the new one's
+    const LinesThrough& through = LINES_THROUGH[t_square];
+    for (int i = 0; i < through.count; ++i)
+    {
+        std::uint8_t& pattern = m_linePatterns[through.lines[i]];
+        const WindowPattern& before = WINDOW_PATTERNS[pattern];
+        pattern = static_cast<std::uint8_t>(pattern + digit * PATTERN_STEPS[t_square][i]);
+        const WindowPattern& after = WINDOW_PATTERNS[pattern];
+
+        m_lineScore[0] += after.scores[0] - before.scores[0];
+        m_lineScore[1] += after.scores[1] - before.scores[1];
+        m_fullLines[0] += after.fours[0] - before.fours[0];
+        m_fullLines[1] += after.fours[1] - before.fours[1];
+    }
+
+    // the mask already has (or no longer has) this cell, so this only counts the neighbours.
+    // each friendly pair counts once for both pieces
+    int neighbours = popCount(KING_STEPS[t_square] & m_playerMasks[own]);
+    m_pieceScore[own] += t_change * (SQUARE_SCORES[t_square] + 2 * neighbours * ADJACENT_WEIGHT);
+}
+
+bool Position::isValidPosition(int t_row, int t_col)
+{
+    return (t_row >= 0 && t_row < GRID_SIZE && t_col >= 0 && t_col < GRID_SIZE);
+}
+
+int Position::getMaxPiecesForType(PieceType t_type)
+{
+    switch (t_type)
+    {
+    case PieceType::FROG:
+        return MAX_FROGS_PER_PLAYER;
+    case PieceType::SNAKE:
+        return MAX_SNAKES_PER_PLAYER;
+    case PieceType::DONKEY:
+        return MAX_DONKEYS_PER_PLAYER;
+    default:
+        return 0;
+    }
+}
+
+bool Position::isCellEmpty(int t_row, int t_col) const
+{
+    if (!isValidPosition(t_row, t_col))
+    {
+        return false;
+    }
+    return (getOccupiedMask() & squareBit(t_row * GRID_SIZE + t_col)) == 0;
+}
+
+Player Position::getCellOwner(int t_row, int t_col) const
+{
+    if (!isValidPosition(t_row, t_col))
+    {
+        return Player::NONE;
+    }
+    Bitboard bit = squareBit(t_row * GRID_SIZE + t_col);
+    if (m_playerMasks[0] & bit)
+    {
+        return Player::PLAYER_ONE;
+    }
+    if (m_playerMasks[1] & bit)
+    {
+        return Player::PLAYER_TWO;
+    }
+    return Player::NONE;
+}
+
+PieceType Position::getPieceType(int t_row, int t_col) const
+{
+    if (!isValidPosition(t_row, t_col))
+    {
+        return PieceType::NONE;
+    }
+    Bitboard bit = squareBit(t_row * GRID_SIZE + t_col);
+    if (m_typeMasks[static_cast<int>(PieceType::DONKEY)] & bit)
+    {
+        return PieceType::DONKEY;
+    }
+    if (m_typeMasks[static_cast<int>(PieceType::SNAKE)] & bit)
+    {
+        return PieceType::SNAKE;
+    }
+    if (m_typeMasks[static_cast<int>(PieceType::FROG)] & bit)
+    {
+        return PieceType::FROG;
+    }
+    return PieceType::NONE;
+}
+
+int Position::getRemainingPieces(Player t_player, PieceType t_type) const
+{
+    if (t_type == PieceType::NONE)
+    {
+        return 0;
+    }
+    return getMaxPiecesForType(t_type) - m_piecesPlaced[playerIndex(t_player)][static_cast<int>(t_type)];
+}
+
+int Position::getTotalPiecesRemaining(Player t_player) const
+{
+    int total = 0;
+    total += getRemainingPieces(t_player, PieceType::FROG);
+    total += getRemainingPieces(t_player, PieceType::SNAKE);
+    total += getRemainingPieces(t_player, PieceType::DONKEY);
+    return total;
+}
+
+bool Position::canPieceMoveTo(int t_fromRow, int t_fromCol, int t_toRow, int t_toCol) const
+{
+    if (!isValidPosition(t_fromRow, t_fromCol) || !isValidPosition(t_toRow, t_toCol))
+    {
+        return false;
+    }
+
+    return (getMoveTargets(t_fromRow * GRID_SIZE + t_fromCol) & squareBit(t_toRow * GRID_SIZE + t_toCol)) != 0;
+}
+
+Bitboard Position::getMoveTargets(int t_square) const
+{
+    Bitboard bit = squareBit(t_square);
+    const PieceType types[] = { PieceType::DONKEY, PieceType::SNAKE, PieceType::FROG };
+    for (PieceType type : types)
+    {
+        if (m_typeMasks[static_cast<int>(type)] & bit)
+        {
+            return getPieceTargets(type, t_square, getOccupiedMask());
+        }
+    }
+    return 0;
+}
+
+int Position::countMoves(Player t_player) const
+{
+    int count = 0;
+    Bitboard pieces = getPlayerMask(t_player);
+    while (pieces)
+    {
+        count += popCount(getMoveTargets(popLowest(pieces)));
+    }
+    return count;
+}
+
+bool Position::canCompleteFour(Player t_player) const
+{
+    Bitboard own = getPlayerMask(t_player);
+    Bitboard cells = getThreatMap().getFours(t_player);
+    if (!cells)
+    {
+        return false;
+    }
+
+    // a piece still to place can go on any empty cell, so every four cell is reachable
+    if (m_gameState == GameState::PLACEMENT && getTotalPiecesRemaining(t_player) > 0)
+    {
+        return true;
+    }
+
+    Bitboard pieces = own;
+    while (pieces)
+    {
+        int from = popLowest(pieces);
+        Bitboard targets = getMoveTargets(from) & cells;
+        while (targets)
+        {
+            // the piece that moves cant be one of the three
+            int to = popLowest(targets);
+            if (hasLineThrough((own & ~squareBit(from)) | squareBit(to), to))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+ThreatMap Position::getThreatMap() const
+{
+    ThreatMap map = { { 0, 0 }, { 0, 0 } };
+    Bitboard empty = getEmptyMask();
+
+    // a flag of 1 turns into an all ones mask, so there is no branching per window
+    for (int line = 0; line < NUM_WIN_LINES; ++line)
+    {
+        const WindowPattern& pattern = WINDOW_PATTERNS[m_linePatterns[line]];
+        Bitboard gaps = WIN_LINES[line] & empty;
+        for (int player = 0; player < 2; ++player)
+        {
+            map.fours[player] |= gaps & (Bitboard(0) - pattern.threes[player]);
+            map.threes[player] |= gaps & (Bitboard(0) - pattern.twos[player]);
+        }
+    }
+
+    return map;
+}
+
+bool Position::hasFourInARow(Player t_player) const
+{
+    return hasAnyLine(getPlayerMask(t_player));
+}
@@ -0,0 +1,321 @@
+/**
+ * @file Position.h
+ * @brief Compact board state used by the AI search
+ * @authors: Kyle & Monika
+ */
+
+#ifndef POSITION_HPP
+#define POSITION_HPP
+
+#include "Grid.h"
+#include "Constants.h"
+#include "Bitboard.h"
+#include "Zobrist.h"
+#include "Symmetry.h"
+#include <cstdint>
+
+static const int MAX_PLY = 128;    ///< Deepest make() stack a Position can hold
+
+/**
+ * @struct Move
+ * @brief A single move, either a placement or a piece movement
+ *
+ * Placements use -1 for fromRow/fromCol (same as the visualiser does)
+ * and say which piece is going down in pieceType.
+ */
+struct Move
+{
+    int fromRow;                            ///< Source row (-1 for placement)
+    int fromCol;                            ///< Source column (-1 for placement)
+    int toRow;                              ///< Destination row
+    int toCol;                              ///< Destination column
+    int score;                              ///< Evaluated score of this move
+    PieceType pieceType = PieceType::NONE;  ///< Piece to place (placement moves only)
+};
+
+/**
+ * @brief Gets every cell a piece can move to, same rules as Grid::canPieceMove
+ * @param t_type Type of the piece
+ * @param t_square Cell the piece is on
+ * @param t_occupied Mask of every occupied cell
+ * @return Mask of legal destinations, always empty cells
+ *
+ * Every move can be played straight back (steps go both ways and a frog
+ * can jump back over the same pieces), so these are also the cells the
+ * piece could have just come from
+ */
+inline Bitboard getPieceTargets(PieceType t_type, int t_square, Bitboard t_occupied)
+{
+    switch (t_type)
+    {
+    case PieceType::DONKEY:
+        return ORTHOGONAL_STEPS[t_square] & ~t_occupied & FULL_BOARD;
+    case PieceType::SNAKE:
+        return KING_STEPS[t_square] & ~t_occupied & FULL_BOARD;
+    case PieceType::FROG:
+        return getFrogTargets(t_square, t_occupied);
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @struct ThreatMap
+ * @brief Empty cells that matter to each player, from one pass over the windows
+ *
+ * Arrays are indexed 0 for player one and 1 for player two
+ */
+struct ThreatMap
+{
+    Bitboard fours[2];      ///< Cells that finish a four (the gap in a window of three)
+    Bitboard threes[2];     ///< Cells that make a three with a gap (windows of two and none of theirs)
+
+    Bitboard getFours(Player t_player) const { return fours[(t_player == Player::PLAYER_ONE) ? 0 : 1]; }
+    Bitboard getThrees(Player t_player) const { return threes[(t_player == Player::PLAYER_ONE) ? 0 : 1]; }
+};
+
+/**
+ * @class Position
+ * @brief Plain copy of the game state that the AI can search on
+ *
+ * The Grid owns all of the SFML shapes and text, so changing it restyles
+ * sprites every time. Position only holds the game itself (cells, side to
+ * move, pieces placed and the winner) and is trivially copyable. The cells
+ * are stored as bitboards, one mask per player and one per piece type, so
+ * move generation is a few mask lookups instead of trying every cell. make()
+ * and unmake() apply and take back moves using an internal undo stack, and
+ * they follow the same rules as the Grid: the side to move flips after
+ * every move and a four in a row ends the game. A Zobrist hash of the
+ * pieces and side to move is kept up to date as moves are made, and so are
+ * the evaluation terms that only depend on nearby cells (see Evaluation.h).
+ * The hash of each of the board's 7 mirror images is kept alongside it, so
+ * all 8 versions of a position can share one canonical hash.
+ */
+class Position
+{
+public:
+    /**
+     * @brief Takes a snapshot of the grid's game state
+     * @param t_grid The grid to copy from
+     * @return Position matching the grid
+     */
+    static Position fromGrid(const Grid& t_grid);
+
+    /**
+     * @brief Gets the position a new game starts from
+     * @return Empty board, player one to place
+     */
+    static Position startingPosition();
+
+    /**
+     * @brief Applies a move for the side to move
+     * @param t_move The move to play (placement if fromRow is -1)
+     */
+    void make(const Move& t_move);
+
+    /**
+     * @brief Takes back the last move made with make()
+     */
+    void unmake();
+
+    /**
+     * @brief Passes the turn without moving, for null-move pruning
+     *
+     * Not a legal move in the game, only the search uses it
+     */
+    void makeNull();
+
+    /**
+     * @brief Takes back a pass made with makeNull()
+     */
+    void unmakeNull();
+
+    /**
+     * @brief Puts a piece straight onto a cell, ignoring the rules
+     * @param t_row Row of the cell
+     * @param t_col Column of the cell
+     * @param t_type Type of the piece
+     * @param t_owner Owner of the piece
+     *
+     * Used for "what if" checks, remove it again with removePiece()
+     */
+    void putPiece(int t_row, int t_col, PieceType t_type, Player t_owner);
+
+    /**
+     * @brief Clears a cell, ignoring the rules
+     * @param t_row Row of the cell
+     * @param t_col Column of the cell
+     */
+    void removePiece(int t_row, int t_col);
+
+    Player getSideToMove() const { return m_sideToMove; }
+    GameState getGameState() const { return m_gameState; }
+    Player getWinner() const { return m_winner; }
+    int getPly() const { return m_ply; }
+    std::uint64_t getKey() const { return m_key; }
+
+    /**
+     * @brief Gets a hash that is the same for the position and all its mirror images
+     * @return Lowest of the 8 symmetric hashes
+     */
+    std::uint64_t getCanonicalKey() const;
+
+    /**
+     * @brief Gets the canonical hash and the symmetry it comes from
+     * @param t_symmetry Filled in with the symmetry that turns this position into its canonical form
+     * @return Lowest of the 8 symmetric hashes
+     *
+     * Anything stored under the canonical hash that has cells in it (such as
+     * a best move) should be stored with t_symmetry applied, and read back
+     * with INVERSE_SYMMETRY[t_symmetry]
+     */
+    std::uint64_t getCanonicalKey(int& t_symmetry) const;
+
+    /**
+     * @brief Gets the symmetries that leave the board exactly as it is
+     * @return Bit s set if symmetry s does (bit 0 always is)
+     *
+     * On an empty board all 8 are set, so only 6 of the 25 cells are
+     * really different
+     */
+    std::uint8_t getSymmetries() const;
+
+    /**
+     * @brief Builds the position with the board turned or flipped
+     * @param t_symmetry Symmetry to apply
+     * @return Mirrored position, same side to move and pieces left, with an empty undo stack
+     */
+    Position getTransformed(int t_symmetry) const;
+
+    /**
+     * @brief Builds the mirror image that the canonical hash belongs to
+     * @return The position in its canonical form
+     */
+    Position getCanonical() const;
+
+    bool isCellEmpty(int t_row, int t_col) const;
+    Player getCellOwner(int t_row, int t_col) const;
+    PieceType getPieceType(int t_row, int t_col) const;
+    int getRemainingPieces(Player t_player, PieceType t_type) const;
+    int getTotalPiecesRemaining(Player t_player) const;
+
+    /**
+     * @brief Checks if the piece on a cell can move to another cell
+     * @param t_fromRow Source row
+     * @param t_fromCol Source column
+     * @param t_toRow Destination row
+     * @param t_toCol Destination column
+     * @return True if the move follows the piece's rules
+     */
+    bool canPieceMoveTo(int t_fromRow, int t_fromCol, int t_toRow, int t_toCol) const;
+
+    /**
+     * @brief Gets every cell the piece on a cell can move to
+     * @param t_square Cell index of the piece
+     * @return Mask of legal destinations (empty if there is no piece)
+     */
+    Bitboard getMoveTargets(int t_square) const;
+
+    /**
+     * @brief Counts how many moves a player has
+     * @param t_player Player to count for
+     * @return Number of legal moves, whoever's turn it is
+     */
+    int countMoves(Player t_player) const;
+
+    Bitboard getPlayerMask(Player t_player) const { return m_playerMasks[playerIndex(t_player)]; }
+    Bitboard getTypeMask(PieceType t_type) const { return m_typeMasks[static_cast<int>(t_type)]; }
+    Bitboard getOccupiedMask() const { return m_playerMasks[0] | m_playerMasks[1]; }
+    Bitboard getEmptyMask() const { return ~getOccupiedMask() & FULL_BOARD; }
+
+    /**
+     * @brief Checks if a player has four in a row anywhere
+     * @param t_player Player to check
+     * @return True if the player has a full line
+     */
+    bool hasFourInARow(Player t_player) const;
+
+    /**
+     * @brief Checks if a player can finish a four with their next move
+     * @param t_player Player to check for
+     * @return True if one of their pieces can reach a cell that completes a window,
+     *         or any such cell is empty while they still have a piece to place
+     */
+    bool canCompleteFour(Player t_player) const;
+
+    /**
+     * @brief Gets the cells that finish a four or make a three, for both players
+     * @return Masks read straight from the window patterns kept by make/unmake
+     */
+    ThreatMap getThreatMap() const;
+
+    /**
+     * @brief Gets how many full windows a player has
+     * @param t_player Player to check
+     * @return Number of four-in-a-row windows
+     */
+    int getFullLines(Player t_player) const { return m_fullLines[playerIndex(t_player)]; }
+
+    /**
+     * @brief Gets every window's score added up, from one player's side
+     * @param t_player Player the scores are for
+     * @return Threes and potential lines for the player minus the opponent's
+     */
+    int getLineScore(Player t_player) const { return m_lineScore[playerIndex(t_player)]; }
+
+    /**
+     * @brief Gets the centre and neighbour scores of a player's pieces
+     * @param t_player Player whose pieces to score
+     * @return Sum over the player's pieces
+     */
+    int getPieceScore(Player t_player) const { return m_pieceScore[playerIndex(t_player)]; }
+
+private:
+    /**
+     * @struct Undo
+     * @brief What make() needs to remember to put the position back
+     */
+    struct Undo
+    {
+        Move move;              ///< The move that was made
+        Player sideToMove;      ///< Side to move before the move
+        GameState gameState;    ///< Game state before the move
+        Player winner;          ///< Winner before the move
+        std::uint64_t key;      ///< Hash before the move
+    };
+
+    Bitboard m_playerMasks[2];          ///< Cells owned by each player
+    Bitboard m_typeMasks[4];            ///< Cells holding each piece type (indexed by PieceType)
+    int m_piecesPlaced[2][4];           ///< Pieces placed so far, by player and type
+    Player m_sideToMove;                ///< Player whose turn it is
+    GameState m_gameState;              ///< Placement, movement or game over
+    Player m_winner;                    ///< Winner once the game is over
+    std::uint64_t m_key;                ///< Zobrist hash of the pieces and side to move
+    std::uint64_t m_symmetryKeys[NUM_SYMMETRIES];  ///< Hash of the pieces (no side to move) under each symmetry
+    std::uint8_t m_linePatterns[NUM_WIN_LINES];    ///< Each window as a base 3 number (see Evaluation.h)
+    int m_fullLines[2];                 ///< Full windows per player
+    int m_lineScore[2];                 ///< Window scores added up, from each player's side
+    int m_pieceScore[2];                ///< Centre and neighbour scores of each player's pieces
+
+    Undo m_history[MAX_PLY];            ///< Undo stack for make/unmake
+    int m_ply;                          ///< Number of moves on the undo stack
+
+    /**
+     * @brief Empties the board and zeroes the evaluation totals
+     */
+    void clearBoard();
+
+    /**
+     * @brief Moves the window patterns and totals for a piece going on or off a cell
+     * @param t_square Cell that changed
+     * @param t_owner Owner of the piece
+     * @param t_change +1 when the piece goes on, -1 when it comes off
+     */
+    void updateEvaluation(int t_square, Player t_owner, int t_change);
+
+    static bool isValidPosition(int t_row, int t_col);
+    static int getMaxPiecesForType(PieceType t_type);
+    static int playerIndex(Player t_player) { return t_player == Player::PLAYER_ONE ? 0 : 1; }
+};
+
+#endif
@@ -0,0 +1,298 @@
+#include "ProofNumberSearch.h"
+#include "TranspositionTable.h"
+#include <algorithm>
+
+static const std::uint32_t PN_INFINITY = 0xFFFFFFFF;    // proven or disproven for good
+
+// adds proof numbers without wrapping, infinity stays infinity
+static std::uint32_t addNumbers(std::uint32_t t_a, std::uint32_t t_b)
+{
+    if (t_a == PN_INFINITY || t_b == PN_INFINITY)
+    {
+        return PN_INFINITY;
+    }
+    return static_cast<std::uint32_t>(std::min<std::uint64_t>(static_cast<std::uint64_t>(t_a) + t_b, PN_INFINITY - 1));
+}
+
+ProofNumberSearch::ProofNumberSearch(std::uint64_t t_megabytes) :
+    m_bucketMask(0),
+    m_megabytes(std::max<std::uint64_t>(1, t_megabytes)),
+    m_nodes(0),
+    m_nodeLimit(0),
+    m_hasDeadline(false),
+    m_outOfTime(false),
+    m_attacker(Player::NONE),
+    m_salt(0),
+    m_leafSolver(PN_LEAF_NODES, PN_LEAF_THREATS)
+{
+    // round down to a power of two so the index is a mask
+    std::uint64_t bucketCount = 1;
+    std::uint64_t maxBuckets = (m_megabytes << 20) / (sizeof(Entry) * ENTRIES_PER_BUCKET);
+    while (bucketCount * 2 <= maxBuckets)
+    {
+        bucketCount *= 2;
+    }
+
+    m_table.assign(static_cast<size_t>(bucketCount * ENTRIES_PER_BUCKET), Entry());
+    m_bucketMask = bucketCount - 1;
+    clear();
+}
+
+void ProofNumberSearch::clear()
+{
+    std::fill(m_table.begin(), m_table.end(), Entry{ 0, 0, 0, 0, 0 });
+}
+
+ProofResult ProofNumberSearch::solve(const Position& t_position, std::uint64_t t_nodeBudget, Move& t_move, int t_milliseconds)
+{
+    m_nodes = 0;
+    m_hasDeadline = t_milliseconds > 0;
+    m_outOfTime = false;
+    m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(t_milliseconds);
+    if (t_position.getGameState() != GameState::PLACEMENT)
+    {
+        return ProofResult::UNKNOWN;
+    }
+
+    Position root = t_position;
+    Player side = root.getSideToMove();
+    Player opponent = (side == Player::PLAYER_ONE) ? Player::PLAYER_TWO : Player::PLAYER_ONE;
+
+    // half the nodes to look for our win, whatever is left to look for theirs
+    m_nodeLimit = t_nodeBudget / 2;
+    if (prove(root, side, t_move))
+    {
+        return ProofResult::WIN;
+    }
+
+    m_nodeLimit = t_nodeBudget;
+    Move reply;
+    if (prove(root, opponent, reply))
+    {
+        return ProofResult::LOSS;
+    }
+
+    return ProofResult::UNKNOWN;
+}
+
+bool ProofNumberSearch::prove(Position& t_position, Player t_attacker, Move& t_move)
+{
+    m_attacker = t_attacker;
+    m_salt = (t_attacker == Player::PLAYER_TWO) ? Zobrist::PERSPECTIVE_KEY : 0;
+
+    std::uint64_t key = t_position.getKey() ^ m_salt;
+    expand(t_position, key, PN_INFINITY, PN_INFINITY);
+
+    Entry* entry = find(key);
+    if (!entry || entry->proof != 0)
+    {
+        return false;
+    }
+
+    if (entry->move != 0)
+    {
+        t_move = unpackMove(entry->move);
+        t_move.score = WIN_SCORE;
+    }
+    return true;
+}
+
+void ProofNumberSearch::expand(Position& t_position, std::uint64_t t_key, std::uint32_t t_phiLimit, std::uint32_t t_deltaLimit)
+{
+    m_nodes++;
+
+    std::uint32_t proof;
+    std::uint32_t disproof;
+    if (evaluateLeaf(t_position, proof, disproof))
+    {
+        store(t_key, proof, disproof, 1, 0);
+        return;
+    }
+
+    // OR node when the attacker picks the move, AND node when the defender does
+    bool orNode = t_position.getSideToMove() == m_attacker;
+    Player mover = t_position.getSideToMove();
+    std::uint64_t startNodes = m_nodes;
+
+    Move moves[MAX_PLACEMENTS];
+    std::uint64_t keys[MAX_PLACEMENTS];
+    int count = generatePlacements(t_position, moves);
+
+    // children that end the game or the placement phase get scored before anything is picked
+    for (int i = 0; i < count; ++i)
+    {
+        keys[i] = keyAfter(t_key, mover, moves[i]);
+        if (!find(keys[i]))
+        {
+            t_position.make(moves[i]);
+            if (evaluateLeaf(t_position, proof, disproof))
+            {
+                store(keys[i], proof, disproof, 1, 0);
+            }
+            t_position.unmake();
+        }
+    }
+
+    while (true)
+    {
+        // phi is this node's own number (proof at OR, disproof at AND), delta the other one
+        std::uint32_t phi = PN_INFINITY;
+        std::uint32_t delta = 0;
+        std::uint32_t secondDelta = PN_INFINITY;
+        std::uint32_t bestChildPhi = 0;
+        int best = 0;
+
+        for (int i = 0; i < count; ++i)
+        {
+            Entry* entry = find(keys[i]);
+            std::uint32_t childProof = entry ? entry->proof : 1;
+            std::uint32_t childDisproof = entry ? entry->disproof : 1;
+            std::uint32_t childPhi = orNode ? childDisproof : childProof;
+            std::uint32_t childDelta = orNode ? childProof : childDisproof;
+
+            delta = addNumbers(delta, childPhi);
+            if (childDelta < phi)
+            {
+                secondDelta = phi;
+                phi = childDelta;
+                bestChildPhi = childPhi;
+                best = i;
+            }
+            else if (childDelta < secondDelta)
+            {
+                secondDelta = childDelta;
+            }
+        }
+
+        if (phi >= t_phiLimit || delta >= t_deltaLimit || isOutOfBudget())
+        {
+            std::uint32_t work = static_cast<std::uint32_t>(std::min<std::uint64_t>(m_nodes - startNodes + 1, PN_INFINITY));
+            std::uint16_t move = (count > 0) ? packMove(moves[best]) : 0;
+            store(t_key, orNode ? phi : delta, orNode ? delta : phi, work, move);
+            return;
+        }
+
+        // give the most proving child as much room as it can have before another one is better
+        std::uint64_t childPhiLimit = static_cast<std::uint64_t>(t_deltaLimit) - delta + bestChildPhi;
+        std::uint64_t childDeltaLimit = std::min<std::uint64_t>(t_phiLimit, static_cast<std::uint64_t>(secondDelta) + 1);
+
+        t_position.make(moves[best]);
+        expand(t_position, keys[best],
+            static_cast<std::uint32_t>(std::min<std::uint64_t>(childPhiLimit, PN_INFINITY)),
+            static_cast<std::uint32_t>(std::min<std::uint64_t>(childDeltaLimit, PN_INFINITY)));
+        t_position.unmake();
+    }
+}
+
+bool ProofNumberSearch::isOutOfBudget()
+{
+    // a node can run a threat solve for each of its children, so the clock is cheap next to that
+    if (m_hasDeadline && !m_outOfTime)
+    {
+        m_outOfTime = std::chrono::steady_clock::now() >= m_deadline;
+    }
+    return m_nodes >= m_nodeLimit || m_outOfTime;
+}
+
+bool ProofNumberSearch::evaluateLeaf(Position& t_position, std::uint32_t& t_proof, std::uint32_t& t_disproof)
+{
+    bool attackerWins;
+
+    if (t_position.getGameState() == GameState::GAME_OVER)
+    {
+        attackerWins = t_position.getWinner() == m_attacker;
+    }
+    else if (t_position.getGameState() == GameState::MOVEMENT)
+    {
+        // past placement only a win the threat solver can prove counts
+        Move move;
+        bool sideWins = m_leafSolver.findWin(t_position, move);
+        attackerWins = sideWins && t_position.getSideToMove() == m_attacker;
+    }
+    else
+    {
+        return false;
+    }
+
+    t_proof = attackerWins ? 0 : PN_INFINITY;
+    t_disproof = attackerWins ? PN_INFINITY : 0;
+    return true;
+}
+
+int ProofNumberSearch::generatePlacements(const Position& t_position, Move* t_moves) const
+{
+    const PieceType types[] = { PieceType::FROG, PieceType::SNAKE, PieceType::DONKEY };
+    Player player = t_position.getSideToMove();
+    int count = 0;
+
+    for (PieceType type : types)
+    {
+        if (t_position.getRemainingPieces(player, type) == 0)
+        {
+            continue;
+        }
+
+        Bitboard empty = t_position.getEmptyMask();
+        while (empty)
+        {
+            int square = popLowest(empty);
+            Move move = { -1, -1, square / GRID_SIZE, square % GRID_SIZE, 0 };
+            move.pieceType = type;
+            t_moves[count++] = move;
+        }
+    }
+
+    return count;
+}
+
+std::uint64_t ProofNumberSearch::keyAfter(std::uint64_t t_key, Player t_player, const Move& t_move)
+{
+    int owner = (t_player == Player::PLAYER_ONE) ? 0 : 1;
+    int square = t_move.toRow * GRID_SIZE + t_move.toCol;
+    return t_key ^ Zobrist::pieceKey(owner, static_cast<int>(t_move.pieceType), square) ^ Zobrist::SIDE_KEY;
+}
+
+ProofNumberSearch::Entry* ProofNumberSearch::find(std::uint64_t t_key)
+{
+    Entry* bucket = &m_table[static_cast<size_t>((t_key & m_bucketMask) * ENTRIES_PER_BUCKET)];
+    for (int i = 0; i < ENTRIES_PER_BUCKET; ++i)
+    {
+        // both numbers 0 never happens, so that marks an empty slot
+        if (bucket[i].key == t_key && (bucket[i].proof != 0 || bucket[i].disproof != 0))
+        {
+            return &bucket[i];
+        }
+    }
+    return nullptr;
+}
+
+void ProofNumberSearch::store(std::uint64_t t_key, std::uint32_t t_proof, std::uint32_t t_disproof, std::uint32_t t_work, std::uint16_t t_move)
+{
+    Entry* bucket = &m_table[static_cast<size_t>((t_key & m_bucketMask) * ENTRIES_PER_BUCKET)];
+    Entry* replace = &bucket[0];
+
+    for (int i = 0; i < ENTRIES_PER_BUCKET; ++i)
+    {
+        Entry& entry = bucket[i];
+        bool empty = entry.proof == 0 && entry.disproof == 0;
+        if (empty || entry.key == t_key)
+        {
+            replace = &entry;
+            break;
+        }
+
+        // otherwise throw away whatever was cheapest to work out
+        if (entry.work < replace->work)
+        {
+            replace = &entry;
+        }
+    }
+
+    // going back into a position only counts the new nodes, so keep whichever took more work
+    bool samePosition = replace->key == t_key;
+    replace->work = samePosition ? std::max(replace->work, t_work) : t_work;
+    replace->key = t_key;
+    replace->proof = t_proof;
+    replace->disproof = t_disproof;
+    replace->move = t_move;
+}
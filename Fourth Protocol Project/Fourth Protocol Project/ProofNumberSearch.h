@@ -0,0 +1,164 @@
+/**
+ * @file ProofNumberSearch.h
+ * @brief Proves wins and losses in the placement phase
+ * @authors: Kyle & Monika
+ */
+
+#ifndef PROOF_NUMBER_SEARCH_HPP
+#define PROOF_NUMBER_SEARCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "Position.h"
+#include "ThreatSolver.h"
+
+/**
+ * @enum ProofResult
+ * @brief What the proof search managed to show
+ */
+enum class ProofResult
+{
+    WIN,        ///< Side to move has a forced win
+    LOSS,       ///< Side to move loses whatever it does
+    UNKNOWN     ///< Neither could be proven (out of nodes, or decided later in the game)
+};
+
+/**
+ * @class ProofNumberSearch
+ * @brief Depth-first proof-number search (df-pn) over the placement tree
+ *
+ * A placement move is a piece type and an empty cell, so there are up to
+ * 75 moves a ply, but only 10 plies before the movement phase starts. Each
+ * node keeps a proof number (how many leaves still need proving for a win)
+ * and a disproof number, and the search always expands the most proving
+ * node, so it finds short forced wins without searching the whole tree.
+ *
+ * A win during placement ends the line. When placement finishes, the
+ * position only counts as a win if the threat solver can prove one from
+ * there; anything decided later is left as unknown.
+ *
+ * The numbers are kept in a fixed size table, so memory stays bounded
+ * however many nodes the search is given; when the table fills up the
+ * entries that took the least work to find are replaced.
+ */
+class ProofNumberSearch
+{
+public:
+    /**
+     * @brief Creates the search
+     * @param t_megabytes Size of the table in MB
+     */
+    explicit ProofNumberSearch(std::uint64_t t_megabytes);
+
+    /**
+     * @brief Tries to prove a win or a loss for the side to move
+     * @param t_position Position to solve, must be in the placement phase
+     * @param t_nodeBudget Most positions to expand, split between the win and loss proofs
+     * @param t_move Filled in with the winning placement if the result is WIN
+     * @param t_milliseconds Time allowed (0 for no limit), UNKNOWN if it runs out first
+     * @return WIN, LOSS or UNKNOWN
+     */
+    ProofResult solve(const Position& t_position, std::uint64_t t_nodeBudget, Move& t_move, int t_milliseconds = 0);
+
+    /**
+     * @brief Empties the table
+     */
+    void clear();
+
+    /**
+     * @brief Gets the number of positions expanded by the last solve
+     * @return Node count
+     */
+    std::uint64_t getNodes() const { return m_nodes; }
+
+    /**
+     * @brief Gets the size of the table
+     * @return Table size in MB
+     */
+    std::uint64_t getSizeMB() const { return m_megabytes; }
+
+private:
+    /**
+     * @struct Entry
+     * @brief Proof and disproof numbers for one position
+     */
+    struct Entry
+    {
+        std::uint64_t key;      ///< Full hash (0 for an empty slot)
+        std::uint32_t proof;    ///< Proof number
+        std::uint32_t disproof; ///< Disproof number
+        std::uint32_t work;     ///< Nodes spent on this position, for replacement
+        std::uint16_t move;     ///< Best placement found (packed), 0 if none
+    };
+
+    static const int ENTRIES_PER_BUCKET = 4;    ///< Entries checked per lookup
+    static const int MAX_PLACEMENTS = 3 * NUM_SQUARES;  ///< Piece types x cells
+
+    std::vector<Entry> m_table;     ///< The table, in buckets of ENTRIES_PER_BUCKET
+    std::uint64_t m_bucketMask;     ///< Bucket count - 1 (count is a power of two)
+    std::uint64_t m_megabytes;      ///< Size asked for in MB
+    std::uint64_t m_nodes;          ///< Positions expanded this solve
+    std::uint64_t m_nodeLimit;      ///< Stop expanding once m_nodes gets here
+    std::chrono::steady_clock::time_point m_deadline;  ///< When to stop, if there is a time limit
+    bool m_hasDeadline;             ///< A time limit was given
+    bool m_outOfTime;               ///< The time limit has passed, stays set for the rest of the solve
+    Player m_attacker;              ///< Side the current proof is for
+    std::uint64_t m_salt;           ///< Keeps the two proofs apart in the table
+    ThreatSolver m_leafSolver;      ///< Proves wins once placement is over
+
+    /**
+     * @brief Runs one proof from the root
+     * @param t_position Root position
+     * @param t_attacker Side to prove a win for
+     * @param t_move Filled in with the proving move if the attacker is to move
+     * @return True if proven, false if disproven or out of nodes
+     */
+    bool prove(Position& t_position, Player t_attacker, Move& t_move);
+
+    /**
+     * @brief Expands a node until its numbers pass the thresholds
+     * @param t_position Position to expand
+     * @param t_key Salted hash of the position
+     * @param t_phiLimit Threshold for the node's own number (proof at OR, disproof at AND)
+     * @param t_deltaLimit Threshold for the other number
+     */
+    void expand(Position& t_position, std::uint64_t t_key, std::uint32_t t_phiLimit, std::uint32_t t_deltaLimit);
+
+    /**
+     * @brief Scores a position that needs no expanding
+     * @param t_position Position to check
+     * @param t_proof Filled in with the proof number
+     * @param t_disproof Filled in with the disproof number
+     * @return True if the position is a leaf
+     */
+    bool evaluateLeaf(Position& t_position, std::uint32_t& t_proof, std::uint32_t& t_disproof);
+
+    /**
+     * @brief Lists every placement for the side to move
+     * @param t_position Position to list them in
+     * @param t_moves Filled in with the placements
+     * @return Number of placements
+     */
+    int generatePlacements(const Position& t_position, Move* t_moves) const;
+
+    /**
+     * @brief Gets the hash a placement leads to without making it
+     * @param t_key Hash before the move
+     * @param t_player Player placing
+     * @param t_move The placement
+     * @return Hash after the move
+     */
+    static std::uint64_t keyAfter(std::uint64_t t_key, Player t_player, const Move& t_move);
+
+    /**
+     * @brief Checks if the node or time budget has run out
+     * @return True if expanding should stop
+     */
+    bool isOutOfBudget();
+
+    Entry* find(std::uint64_t t_key);
+    void store(std::uint64_t t_key, std::uint32_t t_proof, std::uint32_t t_disproof, std::uint32_t t_work, std::uint16_t t_move);
+};
+
+#endif
@@ -0,0 +1,502 @@
+#include "RetrogradeSolver.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+static const char* const TABLE_FILE = "movement.tb";
+static const char* const PENDING_FILE = "pending.bin";
+static const char* const CHECKPOINT_FILE = "checkpoint.txt";
+
+// 1 bit per index, rounded up to whole words
+static std::uint64_t getPendingBytes(std::uint64_t t_size)
+{
+    return ((t_size + 63) / 64) * sizeof(std::uint64_t);
+}
+
+RetrogradeSolver::RetrogradeSolver(const PieceSet& t_set, const std::string& t_directory, int t_threads) :
+    m_index(t_set),
+    m_directory(t_directory),
+    m_threads(t_threads > 0 ? t_threads : std::max(1u, std::thread::hardware_concurrency())),
+    m_values(nullptr),
+    m_pendingBits(nullptr),
+    m_checkpoint{ Phase::INITIALISE, 0, 0 },
+    m_passedBack(0),
+    m_recovering(false),
+    m_wins(0),
+    m_losses(0)
+{
+}
+
+bool RetrogradeSolver::run()
+{
+    // both files are mapped whole at the same time, so they have to fit in the address space together
+    std::uint64_t mappedBytes = sizeof(Tablebase::Header) + Tablebase::getValueBytes(m_index.getSize()) + getPendingBytes(m_index.getSize());
+    if (mappedBytes > SIZE_MAX)
+    {
+        std::cerr << "Solving " << getPieceNames() << " maps " << (mappedBytes >> 20) << "MB at once, which a 32-bit build cant address"
+            << " (build the x64 configuration)" << std::endl;
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+
+    std::string pieces;
+    bool resuming = loadCheckpoint(pieces);
+    if (resuming && pieces != getPieceNames())
+    {
+        std::cerr << "The checkpoint in " << m_directory << " is for " << pieces << ", not " << getPieceNames() << std::endl;
+        return false;
+    }
+    if (!openFiles(!resuming))
+    {
+        std::cerr << "Couldnt map the files in " << m_directory << std::endl;
+        return false;
+    }
+
+    std::uint64_t size = m_index.getSize();
+    std::uint64_t segments = (size + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+    auto start = std::chrono::steady_clock::now();
+
+    if (resuming)
+    {
+        m_recovering = m_checkpoint.phase == Phase::PROPAGATE;
+        std::cout << "Carrying on from segment " << m_checkpoint.segment << " of " << segments
+            << ((m_checkpoint.phase == Phase::INITIALISE) ? " (setting up)" : "") << std::endl;
+    }
+    else if (!saveCheckpoint())
+    {
+        return false;
+    }
+
+    while (m_checkpoint.phase == Phase::INITIALISE)
+    {
+        if (m_checkpoint.segment == segments)
+        {
+            m_checkpoint = { Phase::PROPAGATE, 0, 1 };
+        }
+        else
+        {
+            std::uint64_t first = m_checkpoint.segment * SEGMENT_SIZE;
+            runParallel(first, std::min(first + SEGMENT_SIZE, size), &RetrogradeSolver::initialiseRange);
+            m_checkpoint.segment++;
+            std::cout << "\rSetting up " << m_checkpoint.segment << "/" << segments << std::flush;
+        }
+
+        if (!saveCheckpoint())
+        {
+            return false;
+        }
+    }
+
+    while (m_checkpoint.phase == Phase::PROPAGATE)
+    {
+        if (m_checkpoint.segment == segments)
+        {
+            // done once a whole pass has left nothing behind
+            if (hasPending())
+            {
+                m_checkpoint.segment = 0;
+                m_checkpoint.pass++;
+            }
+            else
+            {
+                m_checkpoint.phase = Phase::FINISHED;
+            }
+        }
+        else
+        {
+            std::uint64_t first = m_checkpoint.segment * SEGMENT_SIZE;
+            m_passedBack = 0;
+            runParallel(first, std::min(first + SEGMENT_SIZE, size), &RetrogradeSolver::propagateRange);
+            m_recovering = false;
+            m_checkpoint.segment++;
+            std::cout << "\rPass " << m_checkpoint.pass << ", segment " << m_checkpoint.segment << "/" << segments
+                << ", " << m_passedBack << " passed back   " << std::flush;
+        }
+
+        if (!saveCheckpoint())
+        {
+            return false;
+        }
+    }
+
+    // only a finished table gets the solved flag, so the AI never reads a half done one
+    Tablebase::Header header = Tablebase::makeHeader(m_index, true);
+    std::memcpy(m_table.getWritableData(), &header, sizeof(header));
+    if (!m_table.flush())
+    {
+        return false;
+    }
+
+    countResults();
+    m_pending.close();
+    m_pendingBits = nullptr;
+    std::filesystem::remove(getPath(PENDING_FILE), error);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::endl << "Solved in " << elapsed << "s" << std::endl;
+    return true;
+}
+
+std::string RetrogradeSolver::getTablePath() const
+{
+    return getPath(TABLE_FILE);
+}
+
+bool RetrogradeSolver::openFiles(bool t_fresh)
+{
+    std::uint64_t size = m_index.getSize();
+    std::string tablePath = getPath(TABLE_FILE);
+    std::string pendingPath = getPath(PENDING_FILE);
+
+    // anything left over from another solve has to go, the results in it would be wrong
+    if (t_fresh)
+    {
+        std::error_code error;
+        std::filesystem::remove(tablePath, error);
+        std::filesystem::remove(pendingPath, error);
+    }
+
+    if (!m_table.openWritable(tablePath, sizeof(Tablebase::Header) + Tablebase::getValueBytes(size)) ||
+        !m_pending.openWritable(pendingPath, getPendingBytes(size)))
+    {
+        return false;
+    }
+
+    if (t_fresh)
+    {
+        Tablebase::Header header = Tablebase::makeHeader(m_index, false);
+        std::memcpy(m_table.getWritableData(), &header, sizeof(header));
+    }
+    else
+    {
+        // a checkpoint is no use without the table it was saved with
+        Tablebase::Header header;
+        PieceSet set;
+        std::memcpy(&header, m_table.getData(), sizeof(header));
+        if (!Tablebase::readHeader(header, set) || !(set == m_index.getPieceSet()) || header.size != size)
+        {
+            return false;
+        }
+    }
+
+    // both views are page aligned and the header is 64 bytes, so the atomics below are aligned
+    m_values = m_table.getWritableData() + sizeof(Tablebase::Header);
+    m_pendingBits = reinterpret_cast<std::uint64_t*>(m_pending.getWritableData());
+    return true;
+}
+
+void RetrogradeSolver::runParallel(std::uint64_t t_first, std::uint64_t t_last, RangeWork t_work)
+{
+    std::atomic<std::uint64_t> next(t_first);
+    auto worker = [&]()
+    {
+        while (true)
+        {
+            std::uint64_t first = next.fetch_add(CHUNK_SIZE);
+            if (first >= t_last)
+            {
+                return;
+            }
+            (this->*t_work)(first, std::min(first + CHUNK_SIZE, t_last));
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < m_threads; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void RetrogradeSolver::initialiseRange(std::uint64_t t_first, std::uint64_t t_last)
+{
+    TablebaseBoard board;
+    for (std::uint64_t index = t_first; index < t_last; ++index)
+    {
+        if (!m_index.getBoard(index, board))
+        {
+            continue;
+        }
+
+        int side = board.sideToMove;
+        if (hasAnyLine(board.players[1 - side]))
+        {
+            // the last move made a four, pending even if it was set before a restart
+            decide(index, Tablebase::VALUE_LOSS);
+            setPending(index);
+            continue;
+        }
+        if (hasAnyLine(board.players[side]))
+        {
+            // cant come up in a game, the side to move would already have won
+            decide(index, Tablebase::VALUE_WIN);
+            continue;
+        }
+
+        bool hasMove = false;
+        Bitboard pieces = board.players[side];
+        while (pieces && !hasMove)
+        {
+            int square = popLowest(pieces);
+            hasMove = getPieceTargets(board.getPieceType(square), square, board.getOccupied()) != 0;
+        }
+
+        // with no moves at all the game is stuck rather than lost
+        if (!hasMove)
+        {
+            decide(index, Tablebase::VALUE_DRAW);
+        }
+    }
+}
+
+void RetrogradeSolver::propagateRange(std::uint64_t t_first, std::uint64_t t_last)
+{
+    std::uint64_t passedBack = 0;
+    for (std::uint64_t word = t_first / 64; word * 64 < t_last; ++word)
+    {
+        std::uint64_t bits = std::atomic_ref<std::uint64_t>(m_pendingBits[word]).load(std::memory_order_relaxed);
+        while (bits)
+        {
+            std::uint64_t index = word * 64 + std::countr_zero(bits);
+            bits &= bits - 1;
+
+            // cleared after, so a solve killed half way through does this one again
+            propagate(index);
+            clearPending(index);
+            passedBack++;
+        }
+    }
+    m_passedBack += passedBack;
+}
+
+void RetrogradeSolver::propagate(std::uint64_t t_index)
+{
+    TablebaseBoard board;
+    if (!m_index.getBoard(t_index, board))
+    {
+        return;
+    }
+
+    std::uint8_t value = readValue(t_index);
+    int mover = 1 - board.sideToMove;
+    Bitboard occupied = board.getOccupied();
+
+    // every way the last mover could have got here
+    Bitboard pieces = board.players[mover];
+    while (pieces)
+    {
+        int to = popLowest(pieces);
+        Bitboard origins = getPieceTargets(board.getPieceType(to), to, occupied);
+        while (origins)
+        {
+            int from = popLowest(origins);
+            TablebaseBoard previous = board.afterMove(to, from);
+
+            // nobody moves once there is a four on the board
+            if (hasAnyLine(previous.players[0]) || hasAnyLine(previous.players[1]))
+            {
+                continue;
+            }
+
+            std::uint64_t previousIndex;
+            m_index.getIndex(previous, previousIndex);
+            std::uint8_t previousValue = readValue(previousIndex);
+            if (previousValue != Tablebase::VALUE_UNKNOWN)
+            {
+                // a restart can land between deciding a position and marking it, so mark it again to be safe
+                if (m_recovering && previousValue == ((value == Tablebase::VALUE_LOSS) ? Tablebase::VALUE_WIN : Tablebase::VALUE_LOSS))
+                {
+                    setPending(previousIndex);
+                }
+                continue;
+            }
+
+            if (value == Tablebase::VALUE_LOSS)
+            {
+                if (decide(previousIndex, Tablebase::VALUE_WIN))
+                {
+                    setPending(previousIndex);
+                }
+            }
+            else if (value == Tablebase::VALUE_WIN && allRepliesWin(previous))
+            {
+                if (decide(previousIndex, Tablebase::VALUE_LOSS))
+                {
+                    setPending(previousIndex);
+                }
+            }
+        }
+    }
+}
+
+bool RetrogradeSolver::allRepliesWin(const TablebaseBoard& t_board) const
+{
+    Bitboard occupied = t_board.getOccupied();
+    Bitboard pieces = t_board.players[t_board.sideToMove];
+    while (pieces)
+    {
+        int from = popLowest(pieces);
+        Bitboard targets = getPieceTargets(t_board.getPieceType(from), from, occupied);
+        while (targets)
+        {
+            std::uint64_t index;
+            m_index.getIndex(t_board.afterMove(from, popLowest(targets)), index);
+            if (readValue(index) != Tablebase::VALUE_WIN)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool RetrogradeSolver::hasPending() const
+{
+    std::uint64_t words = (m_index.getSize() + 63) / 64;
+    for (std::uint64_t word = 0; word < words; ++word)
+    {
+        if (m_pendingBits[word])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::uint8_t RetrogradeSolver::readValue(std::uint64_t t_index) const
+{
+    std::uint8_t byte = std::atomic_ref<std::uint8_t>(m_values[t_index >> 2]).load(std::memory_order_relaxed);
+    return (byte >> ((t_index & 3) * 2)) & 3;
+}
+
+bool RetrogradeSolver::decide(std::uint64_t t_index, std::uint8_t t_value)
+{
+    // 4 results share a byte, so another thread could be setting a neighbour
+    std::atomic_ref<std::uint8_t> byte(m_values[t_index >> 2]);
+    int shift = static_cast<int>(t_index & 3) * 2;
+    std::uint8_t current = byte.load(std::memory_order_relaxed);
+    while (((current >> shift) & 3) == Tablebase::VALUE_UNKNOWN)
+    {
+        if (byte.compare_exchange_weak(current, static_cast<std::uint8_t>(current | (t_value << shift)), std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RetrogradeSolver::setPending(std::uint64_t t_index)
+{
+    std::atomic_ref<std::uint64_t>(m_pendingBits[t_index / 64]).fetch_or(std::uint64_t(1) << (t_index % 64), std::memory_order_relaxed);
+}
+
+void RetrogradeSolver::clearPending(std::uint64_t t_index)
+{
+    std::atomic_ref<std::uint64_t>(m_pendingBits[t_index / 64]).fetch_and(~(std::uint64_t(1) << (t_index % 64)), std::memory_order_relaxed);
+}
+
+bool RetrogradeSolver::saveCheckpoint()
+{
+    // the results have to be on the disk before the checkpoint says they are
+    if (!m_table.flush() || (m_pending.isOpen() && !m_pending.flush()))
+    {
+        std::cerr << "Couldnt flush the tablebase files" << std::endl;
+        return false;
+    }
+
+    std::string path = getPath(CHECKPOINT_FILE);
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        file << "pieces " << getPieceNames() << "\n"
+            << "phase " << static_cast<int>(m_checkpoint.phase) << "\n"
+            << "segment " << m_checkpoint.segment << "\n"
+            << "pass " << m_checkpoint.pass << "\n";
+        if (!file)
+        {
+            std::cerr << "Couldnt write " << temporary << std::endl;
+            return false;
+        }
+    }
+
+    // renaming over the old one means theres always a whole checkpoint on disk
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        std::cerr << "Couldnt replace " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool RetrogradeSolver::loadCheckpoint(std::string& t_pieces)
+{
+    std::ifstream file(getPath(CHECKPOINT_FILE));
+    std::string name;
+    int phase = 0;
+    Checkpoint checkpoint = { Phase::INITIALISE, 0, 0 };
+
+    if (!(file >> name >> t_pieces) || name != "pieces")
+    {
+        return false;
+    }
+    while (file >> name)
+    {
+        if (name == "phase")
+            file >> phase;
+        else if (name == "segment")
+            file >> checkpoint.segment;
+        else if (name == "pass")
+            file >> checkpoint.pass;
+    }
+
+    if (phase < static_cast<int>(Phase::INITIALISE) || phase > static_cast<int>(Phase::FINISHED))
+    {
+        return false;
+    }
+    checkpoint.phase = static_cast<Phase>(phase);
+    m_checkpoint = checkpoint;
+    return true;
+}
+
+void RetrogradeSolver::countResults()
+{
+    m_wins = 0;
+    m_losses = 0;
+
+    // gaps in the index are never decided, so these only count real positions
+    std::uint64_t bytes = Tablebase::getValueBytes(m_index.getSize());
+    for (std::uint64_t i = 0; i < bytes; ++i)
+    {
+        // low bit of each pair alone is a win (01), high bit alone a loss (10)
+        unsigned int low = m_values[i] & 0x55;
+        unsigned int high = (m_values[i] >> 1) & 0x55;
+        m_wins += std::popcount(low & ~high);
+        m_losses += std::popcount(high & ~low);
+    }
+}
+
+std::string RetrogradeSolver::getPath(const char* t_name) const
+{
+    return (std::filesystem::path(m_directory) / t_name).string();
+}
+
+std::string RetrogradeSolver::getPieceNames() const
+{
+    return m_index.getPieceSet().toString(0) + "/" + m_index.getPieceSet().toString(1);
+}
@@ -0,0 +1,195 @@
+/**
+ * @file RetrogradeSolver.h
+ * @brief Solves every movement-phase position backwards from the finished games
+ * @authors: Kyle & Monika
+ *
+ * Every position where the last move made a four is a loss for the side
+ * to move. From there the solve works backwards: any position with a move
+ * into a loss is a win, and any position where every move goes into a win
+ * is a loss. Whatever is never decided is a draw, because neither side can
+ * force a four from it.
+ *
+ * Moves can always be played straight back (see getPieceTargets), so the
+ * positions a result came from are found by moving the last mover's pieces
+ * with the normal rules. A possible loss is only marked once every move out
+ * of it has been checked, which is what lets the results fit in 2 bits.
+ *
+ * The full game has about 9.3e10 indexes, 23GB at 2 bits each plus 12GB for
+ * the list of results still to pass back (1 bit each), so both are files
+ * mapped for writing and the OS keeps whatever pages it has room for. The
+ * indexes are split into segments that all the cores work through
+ * together, and after each segment the files are flushed and a small
+ * checkpoint is written. Killing the solver and running it again carries
+ * on from the last checkpoint; redoing part of a segment is harmless since
+ * results only ever go from unknown to decided.
+ *
+ * A result is passed back to positions anywhere in the table, so both
+ * files stay mapped whole rather than a segment at a time. The full game
+ * needs the x64 configuration; a 32-bit build refuses any set whose files
+ * dont fit in its address space instead of mapping them short.
+ */
+
+#ifndef RETROGRADE_SOLVER_HPP
+#define RETROGRADE_SOLVER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "MappedFile.h"
+#include "Tablebase.h"
+
+/**
+ * @class RetrogradeSolver
+ * @brief Builds a tablebase file for one piece set, resuming if it was stopped
+ */
+class RetrogradeSolver
+{
+public:
+    /**
+     * @brief Sets up a solve, nothing is touched until run()
+     * @param t_set Pieces on the board
+     * @param t_directory Folder for the table, the work file and the checkpoint
+     * @param t_threads Threads to solve with, 0 for one per core
+     */
+    RetrogradeSolver(const PieceSet& t_set, const std::string& t_directory, int t_threads);
+
+    /**
+     * @brief Solves the table, picking up from the checkpoint if there is one
+     * @return False if the files couldnt be made or mapped (too big for a 32-bit build), or the checkpoint is for other pieces
+     */
+    bool run();
+
+    /**
+     * @brief Gets the path the finished table is written to
+     * @return Path of the table file
+     */
+    std::string getTablePath() const;
+
+    std::uint64_t getWins() const { return m_wins; }
+    std::uint64_t getLosses() const { return m_losses; }
+
+private:
+    /**
+     * @enum Phase
+     * @brief How far the solve has got
+     */
+    enum class Phase
+    {
+        INITIALISE,     ///< Marking the finished and stuck positions
+        PROPAGATE,      ///< Passing results back until nothing changes
+        FINISHED        ///< Table is final
+    };
+
+    /**
+     * @struct Checkpoint
+     * @brief Everything needed to carry on, besides the mapped files
+     */
+    struct Checkpoint
+    {
+        Phase phase;            ///< Current phase
+        std::uint64_t segment;  ///< First segment not finished in this phase (or pass)
+        std::uint64_t pass;     ///< Propagation passes started
+    };
+
+    typedef void (RetrogradeSolver::*RangeWork)(std::uint64_t, std::uint64_t);
+
+    static const std::uint64_t CHUNK_SIZE = 1 << 16;        ///< Indexes a thread takes at a time
+    static const std::uint64_t SEGMENT_SIZE = 1ull << 28;   ///< Indexes between checkpoints
+
+    TablebaseIndex m_index;             ///< Numbers the positions
+    std::string m_directory;            ///< Folder the files go in
+    int m_threads;                      ///< Threads to solve with
+    MappedFile m_table;                 ///< Header and 2 bit results
+    MappedFile m_pending;               ///< 1 bit per index, set when its result still has to be passed back
+    unsigned char* m_values;            ///< Results, just after the table header
+    std::uint64_t* m_pendingBits;       ///< Start of the pending bits
+    Checkpoint m_checkpoint;            ///< Progress, as last saved
+    std::atomic<std::uint64_t> m_passedBack;   ///< Results passed back this segment
+    bool m_recovering;                  ///< First segment after a restart, see propagate()
+    std::uint64_t m_wins;               ///< Wins in the finished table
+    std::uint64_t m_losses;             ///< Losses in the finished table
+
+    /**
+     * @brief Maps the table and pending files
+     * @param t_fresh True to throw away any old files first
+     * @return False if a file couldnt be made or mapped
+     */
+    bool openFiles(bool t_fresh);
+
+    /**
+     * @brief Splits a range into chunks and works through them on every thread
+     * @param t_first First index
+     * @param t_last One past the last index
+     * @param t_work Member function to run on each chunk
+     */
+    void runParallel(std::uint64_t t_first, std::uint64_t t_last, RangeWork t_work);
+
+    /**
+     * @brief Marks the positions that are decided before any move is looked at
+     * @param t_first First index
+     * @param t_last One past the last index
+     */
+    void initialiseRange(std::uint64_t t_first, std::uint64_t t_last);
+
+    /**
+     * @brief Passes back the result of every pending index in a range
+     * @param t_first First index, a multiple of 64
+     * @param t_last One past the last index
+     */
+    void propagateRange(std::uint64_t t_first, std::uint64_t t_last);
+
+    /**
+     * @brief Decides whatever positions a result settles, one move back
+     * @param t_index Index whose result is passed back
+     */
+    void propagate(std::uint64_t t_index);
+
+    /**
+     * @brief Checks if every move from a board goes into a win for the other side
+     * @param t_board Board to check, the side to move has at least one move
+     * @return True if the side to move is lost
+     */
+    bool allRepliesWin(const TablebaseBoard& t_board) const;
+
+    /**
+     * @brief Checks if any index is still waiting to be passed back
+     * @return True if a pending bit is set
+     */
+    bool hasPending() const;
+
+    std::uint8_t readValue(std::uint64_t t_index) const;
+
+    /**
+     * @brief Sets a result if nobody has decided it yet
+     * @param t_index Index to set
+     * @param t_value Result to store
+     * @return True if this call decided it
+     */
+    bool decide(std::uint64_t t_index, std::uint8_t t_value);
+
+    void setPending(std::uint64_t t_index);
+    void clearPending(std::uint64_t t_index);
+
+    /**
+     * @brief Flushes the mapped files and saves the checkpoint
+     * @return False if either couldnt be written
+     */
+    bool saveCheckpoint();
+
+    /**
+     * @brief Reads the checkpoint if there is one
+     * @param t_pieces Filled in with the piece set it was saved for, like "FSDDD/FSDDD"
+     * @return False if there is none
+     */
+    bool loadCheckpoint(std::string& t_pieces);
+
+    /**
+     * @brief Counts the wins and losses in the table
+     */
+    void countResults();
+
+    std::string getPath(const char* t_name) const;
+    std::string getPieceNames() const;
+};
+
+#endif
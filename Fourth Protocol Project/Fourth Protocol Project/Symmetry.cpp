@@ -0,0 +1,53 @@
+#include "Symmetry.h"
+#include "Position.h"
+#include "TranspositionTable.h"
+
+// the bit tricks have to land every cell where the table says
+static_assert(transformBoard(squareBit(1), 4) == squareBit(5), "transpose moved a cell to the wrong place");
+static_assert(transformBoard(squareBit(3), 1) == squareBit(1), "mirror moved a cell to the wrong place");
+static_assert(transformBoard(squareBit(7), 2) == squareBit(17), "flip moved a cell to the wrong place");
+static_assert(transformBoard(squareBit(3), 7) == squareBit(SYMMETRY_SQUARES[7][3]), "symmetries dont match the table");
+
+namespace Symmetry
+{
+    Move transformMove(const Move& t_move, int t_symmetry)
+    {
+        Move move = t_move;
+
+        if (t_move.fromRow != -1)
+        {
+            int from = SYMMETRY_SQUARES[t_symmetry][t_move.fromRow * GRID_SIZE + t_move.fromCol];
+            move.fromRow = from / GRID_SIZE;
+            move.fromCol = from % GRID_SIZE;
+        }
+
+        int to = SYMMETRY_SQUARES[t_symmetry][t_move.toRow * GRID_SIZE + t_move.toCol];
+        move.toRow = to / GRID_SIZE;
+        move.toCol = to % GRID_SIZE;
+        return move;
+    }
+
+    std::uint16_t transformPackedMove(std::uint16_t t_packed, int t_symmetry)
+    {
+        if (t_packed == 0 || t_symmetry == 0)
+        {
+            return t_packed;
+        }
+        return packMove(transformMove(unpackMove(t_packed), t_symmetry));
+    }
+
+    bool isFirstOfItsKind(const Move& t_move, std::uint8_t t_symmetries)
+    {
+        std::uint16_t packed = packMove(t_move);
+
+        // symmetry 0 is always there and changes nothing
+        for (int symmetry = 1; symmetry < NUM_SYMMETRIES; ++symmetry)
+        {
+            if ((t_symmetries & (1 << symmetry)) && packMove(transformMove(t_move, symmetry)) < packed)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,188 @@
+/**
+ * @file Symmetry.h
+ * @brief The 8 rotations and reflections of the board
+ * @authors: Kyle & Monika
+ *
+ * Every rule (the windows, donkey steps, snake steps and frog jumps) looks
+ * the same after turning or flipping the board, so a position and its 7
+ * mirror images are worth the same and their best moves are the mirror
+ * images of each other. Symmetry s maps a cell by first swapping row and
+ * column if bit 2 is set, then mirroring the column if bit 0 is set, then
+ * the row if bit 1 is set. Symmetry 0 leaves the board alone.
+ */
+
+#ifndef SYMMETRY_HPP
+#define SYMMETRY_HPP
+
+#include <array>
+#include <cstdint>
+#include "Bitboard.h"
+
+struct Move;
+
+static const int NUM_SYMMETRIES = 8;    ///< Rotations and reflections of a square board
+
+namespace SymmetryTables
+{
+    /**
+     * @brief Builds where each cell goes under each symmetry
+     * @return Cell indexes by [symmetry][cell]
+     */
+    constexpr std::array<std::array<int, NUM_SQUARES>, NUM_SYMMETRIES> buildSquareMaps()
+    {
+        std::array<std::array<int, NUM_SQUARES>, NUM_SYMMETRIES> maps{};
+
+        for (int symmetry = 0; symmetry < NUM_SYMMETRIES; ++symmetry)
+        {
+            for (int square = 0; square < NUM_SQUARES; ++square)
+            {
+                int row = square / GRID_SIZE;
+                int col = square % GRID_SIZE;
+                if (symmetry & 4)
+                {
+                    int swap = row;
+                    row = col;
+                    col = swap;
+                }
+                if (symmetry & 1)
+                    col = GRID_SIZE - 1 - col;
+                if (symmetry & 2)
+                    row = GRID_SIZE - 1 - row;
+
+                maps[symmetry][square] = row * GRID_SIZE + col;
+            }
+        }
+
+        return maps;
+    }
+
+    /**
+     * @brief Builds the symmetry that undoes each symmetry
+     * @param t_maps Cell maps from buildSquareMaps()
+     * @return Inverse of each symmetry
+     */
+    constexpr std::array<int, NUM_SYMMETRIES> buildInverses(const std::array<std::array<int, NUM_SQUARES>, NUM_SYMMETRIES>& t_maps)
+    {
+        std::array<int, NUM_SYMMETRIES> inverses{};
+
+        for (int symmetry = 0; symmetry < NUM_SYMMETRIES; ++symmetry)
+        {
+            for (int other = 0; other < NUM_SYMMETRIES; ++other)
+            {
+                bool undoes = true;
+                for (int square = 0; square < NUM_SQUARES; ++square)
+                {
+                    undoes = undoes && t_maps[other][t_maps[symmetry][square]] == square;
+                }
+                if (undoes)
+                {
+                    inverses[symmetry] = other;
+                }
+            }
+        }
+
+        return inverses;
+    }
+
+    /**
+     * @brief Builds a mask for each diagonal, by column minus row
+     * @return Masks indexed by col - row + GRID_SIZE - 1
+     */
+    constexpr std::array<Bitboard, 2 * GRID_SIZE - 1> buildDiagonals()
+    {
+        std::array<Bitboard, 2 * GRID_SIZE - 1> diagonals{};
+
+        for (int square = 0; square < NUM_SQUARES; ++square)
+        {
+            diagonals[square % GRID_SIZE - square / GRID_SIZE + GRID_SIZE - 1] |= squareBit(square);
+        }
+
+        return diagonals;
+    }
+}
+
+/// Where each cell goes, indexed by [symmetry][cell]
+inline constexpr std::array<std::array<int, NUM_SQUARES>, NUM_SYMMETRIES> SYMMETRY_SQUARES = SymmetryTables::buildSquareMaps();
+
+/// The symmetry that puts the board back, indexed by symmetry
+inline constexpr std::array<int, NUM_SYMMETRIES> INVERSE_SYMMETRY = SymmetryTables::buildInverses(SYMMETRY_SQUARES);
+
+/// Cells on each diagonal, indexed by col - row + GRID_SIZE - 1
+inline constexpr std::array<Bitboard, 2 * GRID_SIZE - 1> DIAGONAL_MASKS = SymmetryTables::buildDiagonals();
+
+/**
+ * @brief Turns and flips a whole mask at once
+ * @param t_mask Mask to move
+ * @param t_symmetry Symmetry to apply (0 to 7)
+ * @return The mask with every cell moved the same as SYMMETRY_SQUARES
+ */
+constexpr Bitboard transformBoard(Bitboard t_mask, int t_symmetry)
+{
+    const Bitboard column = 0x108421;   // cells in the first column
+    const Bitboard row = 0x1F;          // cells in the first row
+
+    if (t_symmetry & 4)
+    {
+        // a cell on diagonal d moves by (GRID_SIZE - 1) * d when row and column swap
+        Bitboard swapped = 0;
+        for (int d = -(GRID_SIZE - 1); d < GRID_SIZE; ++d)
+        {
+            Bitboard cells = t_mask & DIAGONAL_MASKS[d + GRID_SIZE - 1];
+            swapped |= (d >= 0) ? (cells << ((GRID_SIZE - 1) * d)) : (cells >> (-(GRID_SIZE - 1) * d));
+        }
+        t_mask = swapped;
+    }
+    if (t_symmetry & 1)
+    {
+        Bitboard mirrored = 0;
+        for (int col = 0; col < GRID_SIZE; ++col)
+        {
+            Bitboard cells = t_mask & (column << col);
+            int shift = GRID_SIZE - 1 - 2 * col;
+            mirrored |= (shift >= 0) ? (cells << shift) : (cells >> -shift);
+        }
+        t_mask = mirrored;
+    }
+    if (t_symmetry & 2)
+    {
+        Bitboard flipped = 0;
+        for (int r = 0; r < GRID_SIZE; ++r)
+        {
+            Bitboard cells = t_mask & (row << (r * GRID_SIZE));
+            int shift = (GRID_SIZE - 1 - 2 * r) * GRID_SIZE;
+            flipped |= (shift >= 0) ? (cells << shift) : (cells >> -shift);
+        }
+        t_mask = flipped;
+    }
+
+    return t_mask;
+}
+
+namespace Symmetry
+{
+    /**
+     * @brief Moves a move's cells the same way the board is moved
+     * @param t_move Move to transform (placements keep fromRow at -1)
+     * @param t_symmetry Symmetry to apply
+     * @return The mirrored move, same piece type and score
+     */
+    Move transformMove(const Move& t_move, int t_symmetry);
+
+    /**
+     * @brief Transforms a move packed with packMove()
+     * @param t_packed Packed move, 0 stays 0
+     * @param t_symmetry Symmetry to apply
+     * @return Packed mirrored move
+     */
+    std::uint16_t transformPackedMove(std::uint16_t t_packed, int t_symmetry);
+
+    /**
+     * @brief Checks if a move is the first of the moves a board's symmetries make equal
+     * @param t_move Move to check
+     * @param t_symmetries Symmetries that leave the board as it is (see Position::getSymmetries)
+     * @return True unless one of the symmetries turns it into a lower packed move
+     */
+    bool isFirstOfItsKind(const Move& t_move, std::uint8_t t_symmetries);
+}
+
+#endif
@@ -0,0 +1,447 @@
+#include "Tablebase.h"
+#include "Compression.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+static const char TABLEBASE_MAGIC[8] = { 'F', 'P', 'T', 'B', 'A', 'S', 'E', 0 };
+static const std::uint32_t TABLEBASE_VERSION = 1;
+
+// packs one block of a plain table the way compress() stores it
+static void packBlock(const TablebaseIndex& t_index, const unsigned char* t_values, std::uint64_t t_block, unsigned char* t_output)
+{
+    std::uint64_t first = t_block * Tablebase::BLOCK_VALUES;
+    std::uint64_t last = std::min(first + Tablebase::BLOCK_VALUES, t_index.getSize());
+    std::memset(t_output, 0, static_cast<std::size_t>(Tablebase::getValueBytes(last - first)));
+
+    TablebaseBoard board;
+    for (std::uint64_t index = first; index < last; ++index)
+    {
+        std::uint64_t offset = index - first;
+        std::uint8_t value = Tablebase::getValue(t_values, index);
+        if (value == Tablebase::VALUE_DRAW)
+        {
+            value = Tablebase::VALUE_UNKNOWN;
+        }
+
+        // nothing ever reads these, so whatever keeps the run going is best
+        bool used = t_index.getBoard(index, board) && !hasAnyLine(board.players[0]) && !hasAnyLine(board.players[1]);
+        if (!used && offset >= 2)
+        {
+            value = Tablebase::getValue(t_output, offset - 2);
+        }
+
+        t_output[offset >> 2] |= static_cast<unsigned char>(value << ((offset & 3) * 2));
+    }
+}
+
+Tablebase::Tablebase() :
+    m_values(nullptr),
+    m_blockValues(0),
+    m_blockCount(0),
+    m_offsets(nullptr),
+    m_cacheMegabytes(DEFAULT_TABLEBASE_CACHE_MB),
+    m_slotsUsed(0),
+    m_newest(-1),
+    m_oldest(-1)
+{
+}
+
+bool Tablebase::open(const std::string& t_path)
+{
+    close();
+    static_assert(sizeof(Header) == 64, "the tablebase header has to match the file");
+
+    if (!m_file.open(t_path) || m_file.getSize() < sizeof(Header))
+    {
+        m_file.close();
+        return false;
+    }
+
+    Header header;
+    PieceSet set;
+    std::memcpy(&header, m_file.getData(), sizeof(Header));
+    if (!readHeader(header, set) || !header.solved)
+    {
+        m_file.close();
+        return false;
+    }
+
+    TablebaseIndex index(set);
+    if (index.getSize() != header.size)
+    {
+        m_file.close();
+        return false;
+    }
+
+    if (header.blockValues == 0)
+    {
+        if (m_file.getSize() != sizeof(Header) + getValueBytes(header.size))
+        {
+            m_file.close();
+            return false;
+        }
+        m_index = index;
+        m_values = m_file.getData() + sizeof(Header);
+        return true;
+    }
+
+    // blocks have to start on a whole byte
+    if (header.blockValues % 4 != 0)
+    {
+        m_file.close();
+        return false;
+    }
+
+    std::uint64_t blockCount = (header.size + header.blockValues - 1) / header.blockValues;
+    std::uint64_t blocksStart = sizeof(Header) + (blockCount + 1) * sizeof(std::uint64_t);
+    if (m_file.getSize() < blocksStart)
+    {
+        m_file.close();
+        return false;
+    }
+
+    // the blocks are checked as they are decompressed, the offsets only have to stay inside the file
+    const std::uint64_t* offsets = reinterpret_cast<const std::uint64_t*>(m_file.getData() + sizeof(Header));
+    bool valid = offsets[0] == blocksStart && offsets[blockCount] == m_file.getSize();
+    for (std::uint64_t block = 0; block < blockCount && valid; ++block)
+    {
+        valid = offsets[block] <= offsets[block + 1];
+    }
+    if (!valid)
+    {
+        m_file.close();
+        return false;
+    }
+
+    m_index = index;
+    m_blockValues = header.blockValues;
+    m_blockCount = blockCount;
+    m_offsets = offsets;
+    resetCache();
+    return true;
+}
+
+void Tablebase::close()
+{
+    m_file.close();
+    m_values = nullptr;
+    m_blockValues = 0;
+    m_blockCount = 0;
+    m_offsets = nullptr;
+
+    // the cache can be hundreds of MB, so it goes with the table
+    m_cacheData.reset();
+    std::vector<CacheSlot>().swap(m_slots);
+    std::vector<std::int32_t>().swap(m_blockSlots);
+    m_slotsUsed = 0;
+    m_newest = -1;
+    m_oldest = -1;
+}
+
+TablebaseResult Tablebase::probe(const Position& t_position)
+{
+    if (!isOpen() || t_position.getGameState() != GameState::MOVEMENT)
+    {
+        return TablebaseResult::MISSING;
+    }
+    return probe(TablebaseBoard::fromPosition(t_position));
+}
+
+TablebaseResult Tablebase::probe(const TablebaseBoard& t_board)
+{
+    std::uint64_t index;
+    if (!isOpen() || !m_index.getIndex(t_board, index))
+    {
+        return TablebaseResult::MISSING;
+    }
+
+    std::uint8_t value;
+    if (m_values)
+    {
+        value = getValue(m_values, index);
+    }
+    else
+    {
+        const unsigned char* block = getBlock(index / m_blockValues);
+        if (!block)
+        {
+            return TablebaseResult::MISSING;
+        }
+        value = getValue(block, index % m_blockValues);
+    }
+
+    switch (value)
+    {
+    case VALUE_WIN:
+        return TablebaseResult::WIN;
+    case VALUE_LOSS:
+        return TablebaseResult::LOSS;
+    default:
+        // whatever the solve never decided is a draw
+        return TablebaseResult::DRAW;
+    }
+}
+
+void Tablebase::setCacheSize(int t_megabytes)
+{
+    m_cacheMegabytes = t_megabytes;
+    if (isCompressed())
+    {
+        resetCache();
+    }
+}
+
+void Tablebase::resetCache()
+{
+    std::uint64_t blockBytes = getValueBytes(m_blockValues);
+    std::uint64_t slots = (static_cast<std::uint64_t>(std::max(m_cacheMegabytes, 0)) << 20) / blockBytes;
+    slots = std::clamp<std::uint64_t>(slots, 1, std::min<std::uint64_t>(m_blockCount, INT_MAX));
+
+    // the old cache goes first so both are never held at once, and the new one is
+    // left uninitialised so the OS only hands over pages once blocks land in them
+    m_cacheData.reset();
+    m_cacheData.reset(new unsigned char[static_cast<std::size_t>(slots * blockBytes)]);
+    m_slots.assign(static_cast<std::size_t>(slots), CacheSlot{ 0, -1, -1 });
+    m_blockSlots.assign(static_cast<std::size_t>(m_blockCount), -1);
+    m_slotsUsed = 0;
+    m_newest = -1;
+    m_oldest = -1;
+    m_stats = CacheStats();
+}
+
+const unsigned char* Tablebase::getBlock(std::uint64_t t_block)
+{
+    std::size_t blockBytes = static_cast<std::size_t>(getValueBytes(m_blockValues));
+    ++m_stats.probes;
+
+    int slot = m_blockSlots[t_block];
+    if (slot >= 0)
+    {
+        ++m_stats.hits;
+        if (slot != m_newest)
+        {
+            unlinkSlot(slot);
+            linkNewest(slot);
+        }
+        return m_cacheData.get() + slot * blockBytes;
+    }
+
+    // a free slot if there is one, otherwise the one used longest ago
+    if (m_slotsUsed < static_cast<int>(m_slots.size()))
+    {
+        slot = m_slotsUsed++;
+    }
+    else
+    {
+        slot = m_oldest;
+        unlinkSlot(slot);
+        m_blockSlots[m_slots[slot].block] = -1;
+    }
+    m_slots[slot].block = t_block;
+    linkNewest(slot);
+
+    std::uint64_t first = t_block * m_blockValues;
+    std::size_t bytes = static_cast<std::size_t>(getValueBytes(std::min<std::uint64_t>(m_blockValues, m_index.getSize() - first)));
+    std::uint64_t start = m_offsets[t_block];
+    std::size_t stored = static_cast<std::size_t>(m_offsets[t_block + 1] - start);
+    unsigned char* data = m_cacheData.get() + slot * blockBytes;
+
+    // blocks that didnt get any smaller are stored as they are
+    bool valid = true;
+    if (stored == bytes)
+    {
+        std::memcpy(data, m_file.getData() + start, bytes);
+    }
+    else
+    {
+        valid = Compression::decompress(m_file.getData() + start, stored, data, bytes);
+    }
+
+    // a corrupt block keeps its slot but is never found in it
+    if (!valid)
+    {
+        return nullptr;
+    }
+    m_blockSlots[t_block] = slot;
+    return data;
+}
+
+void Tablebase::unlinkSlot(int t_slot)
+{
+    CacheSlot& entry = m_slots[t_slot];
+    if (entry.older >= 0)
+        m_slots[entry.older].newer = entry.newer;
+    else
+        m_oldest = entry.newer;
+    if (entry.newer >= 0)
+        m_slots[entry.newer].older = entry.older;
+    else
+        m_newest = entry.older;
+    entry.older = -1;
+    entry.newer = -1;
+}
+
+void Tablebase::linkNewest(int t_slot)
+{
+    CacheSlot& entry = m_slots[t_slot];
+    entry.older = m_newest;
+    entry.newer = -1;
+    if (m_newest >= 0)
+        m_slots[m_newest].newer = t_slot;
+    else
+        m_oldest = t_slot;
+    m_newest = t_slot;
+}
+
+bool Tablebase::compress(const std::string& t_inputPath, const std::string& t_outputPath, int t_threads)
+{
+    MappedFile input;
+    if (!input.open(t_inputPath) || input.getSize() < sizeof(Header))
+    {
+        std::cerr << "Couldnt map " << t_inputPath << std::endl;
+        return false;
+    }
+
+    Header header;
+    PieceSet set;
+    std::memcpy(&header, input.getData(), sizeof(Header));
+    if (!readHeader(header, set) || !header.solved || header.blockValues != 0 ||
+        header.size != TablebaseIndex(set).getSize() || input.getSize() != sizeof(Header) + getValueBytes(header.size))
+    {
+        std::cerr << t_inputPath << " isnt a finished plain tablebase" << std::endl;
+        return false;
+    }
+
+    TablebaseIndex index(set);
+    const unsigned char* values = input.getData() + sizeof(Header);
+    std::uint64_t blockCount = (header.size + BLOCK_VALUES - 1) / BLOCK_VALUES;
+    int threads = t_threads > 0 ? t_threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    // written beside the real file and swapped in at the end, so a half written table is never opened
+    std::string temporary = t_outputPath + ".tmp";
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "Couldnt write " << temporary << std::endl;
+        return false;
+    }
+
+    Header output = makeHeader(index, true);
+    output.blockValues = BLOCK_VALUES;
+    std::vector<std::uint64_t> offsets(static_cast<std::size_t>(blockCount + 1), 0);
+    offsets[0] = sizeof(Header) + offsets.size() * sizeof(std::uint64_t);
+    file.write(reinterpret_cast<const char*>(&output), sizeof(Header));
+    file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(std::uint64_t));
+
+    // blocks are done a batch at a time on every thread, then written in order
+    std::uint64_t batchSize = static_cast<std::uint64_t>(threads) * 16;
+    std::vector<std::vector<unsigned char>> batch(static_cast<std::size_t>(batchSize));
+    for (std::uint64_t first = 0; first < blockCount && file; first += batchSize)
+    {
+        std::uint64_t last = std::min(first + batchSize, blockCount);
+        std::atomic<std::uint64_t> next(first);
+        auto worker = [&]()
+        {
+            std::vector<unsigned char> packed(static_cast<std::size_t>(getValueBytes(BLOCK_VALUES)));
+            while (true)
+            {
+                std::uint64_t block = next.fetch_add(1);
+                if (block >= last)
+                {
+                    return;
+                }
+
+                packBlock(index, values, block, packed.data());
+                std::size_t bytes = static_cast<std::size_t>(getValueBytes(std::min<std::uint64_t>(BLOCK_VALUES, header.size - block * BLOCK_VALUES)));
+                std::vector<unsigned char>& compressed = batch[static_cast<std::size_t>(block - first)];
+                Compression::compress(packed.data(), bytes, compressed);
+                if (compressed.size() >= bytes)
+                {
+                    compressed.assign(packed.begin(), packed.begin() + bytes);
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; ++i)
+        {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : workers)
+        {
+            thread.join();
+        }
+
+        for (std::uint64_t block = first; block < last; ++block)
+        {
+            const std::vector<unsigned char>& compressed = batch[static_cast<std::size_t>(block - first)];
+            file.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+            offsets[static_cast<std::size_t>(block + 1)] = offsets[static_cast<std::size_t>(block)] + compressed.size();
+        }
+        std::cout << "\rCompressing " << last << "/" << blockCount << std::flush;
+    }
+    std::cout << std::endl;
+
+    file.seekp(sizeof(Header));
+    file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(std::uint64_t));
+    file.close();
+    if (!file)
+    {
+        std::cerr << "Couldnt write " << temporary << std::endl;
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, t_outputPath, error);
+    if (error)
+    {
+        std::cerr << "Couldnt replace " << t_outputPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+Tablebase::Header Tablebase::makeHeader(const TablebaseIndex& t_index, bool t_solved)
+{
+    Header header;
+    std::memset(&header, 0, sizeof(Header));
+    std::memcpy(header.magic, TABLEBASE_MAGIC, sizeof(TABLEBASE_MAGIC));
+    header.version = TABLEBASE_VERSION;
+    for (int player = 0; player < 2; ++player)
+    {
+        for (int type = 0; type < TABLEBASE_TYPES; ++type)
+        {
+            header.pieces[player][type] = static_cast<std::uint8_t>(t_index.getPieceSet().counts[player][type]);
+        }
+    }
+    header.solved = t_solved ? 1 : 0;
+    header.size = t_index.getSize();
+    return header;
+}
+
+bool Tablebase::readHeader(const Header& t_header, PieceSet& t_set)
+{
+    if (std::memcmp(t_header.magic, TABLEBASE_MAGIC, sizeof(TABLEBASE_MAGIC)) != 0 || t_header.version != TABLEBASE_VERSION)
+    {
+        return false;
+    }
+
+    // goes through the letters so a corrupt count is turned down the same as a bad command line
+    std::string letters[2];
+    const char names[TABLEBASE_TYPES] = { 'F', 'S', 'D' };
+    for (int player = 0; player < 2; ++player)
+    {
+        for (int type = 0; type < TABLEBASE_TYPES; ++type)
+        {
+            letters[player].append(t_header.pieces[player][type], names[type]);
+        }
+    }
+    return PieceSet::parse(letters[0], letters[1], t_set);
+}
@@ -0,0 +1,237 @@
+/**
+ * @file Tablebase.h
+ * @brief Solved result of every movement-phase position
+ * @authors: Kyle & Monika
+ *
+ * Written by the retrograde solver (Tools, --solve). The file is a 64 byte
+ * header and then 2 bits for every TablebaseIndex index, 4 to a byte with
+ * the lowest index in the lowest bits. A result is always for the side to
+ * move. The file is mapped, so a lookup only reads the page it lands on.
+ *
+ * The full game is 23GB like that, so the table the game ships is
+ * compressed (compress(), --compress-tablebase). The same values are cut
+ * into blocks of consecutive indexes, and each block is compressed on its
+ * own (see Compression.h). After the header comes the offset of every
+ * block and one more for the end of the file, then the blocks. Indexes go
+ * by the canonical ranking, so the positions a game moves through tend to
+ * share blocks. Blocks are decompressed into a cache with a fixed size and
+ * the one used longest ago makes room for the next, so a search keeps
+ * hitting the same few blocks and only a miss pays for decompressing.
+ */
+
+#ifndef TABLEBASE_HPP
+#define TABLEBASE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "TablebaseIndex.h"
+
+/**
+ * @enum TablebaseResult
+ * @brief What the table says about a position
+ */
+enum class TablebaseResult
+{
+    WIN,        ///< Side to move can force a four
+    LOSS,       ///< Other side can force a four whatever the side to move does
+    DRAW,       ///< Neither side can force a four
+    MISSING     ///< No table open, not the movement phase, or different pieces to the table
+};
+
+/**
+ * @class Tablebase
+ * @brief Read-only solved table, and the file layouts the solver writes
+ *
+ * Probing a compressed table changes the cache, so a Tablebase must only
+ * be probed from one thread at a time
+ */
+class Tablebase
+{
+public:
+    // 2 bit values as they are stored
+    static constexpr std::uint8_t VALUE_UNKNOWN = 0;    ///< Not decided (a draw once the solve is finished)
+    static constexpr std::uint8_t VALUE_WIN = 1;        ///< Side to move wins
+    static constexpr std::uint8_t VALUE_LOSS = 2;       ///< Side to move loses
+    static constexpr std::uint8_t VALUE_DRAW = 3;       ///< Side to move has no moves, so the game is stuck
+
+    static constexpr std::uint32_t BLOCK_VALUES = 1 << 16;     ///< Indexes in each compressed block (16KB of values)
+
+    /**
+     * @struct Header
+     * @brief Start of a tablebase file
+     */
+    struct Header
+    {
+        char magic[8];                              ///< TABLEBASE_MAGIC
+        std::uint32_t version;                      ///< TABLEBASE_VERSION
+        std::uint8_t pieces[2][TABLEBASE_TYPES];    ///< Piece set the table is for
+        std::uint8_t solved;                        ///< 1 once every result is final
+        std::uint8_t reserved[5];                   ///< Always 0
+        std::uint64_t size;                         ///< Number of indexes
+        std::uint32_t blockValues;                  ///< Indexes per compressed block, 0 for a plain 2 bit table
+        std::uint8_t padding[28];                   ///< Always 0, keeps the values 64 byte aligned
+    };
+
+    /**
+     * @struct CacheStats
+     * @brief Counters for sizing the block cache
+     */
+    struct CacheStats
+    {
+        std::uint64_t probes = 0;   ///< Blocks asked for
+        std::uint64_t hits = 0;     ///< Blocks that were already decompressed
+
+        double hitRate() const { return probes ? 100.0 * hits / probes : 0.0; }
+    };
+
+    Tablebase();
+
+    /**
+     * @brief Maps a solved table, plain or compressed, replacing any table already open
+     * @param t_path Path of the file
+     * @return False if the file is missing, isnt a table or wasnt finished
+     */
+    bool open(const std::string& t_path);
+
+    /**
+     * @brief Closes the table
+     */
+    void close();
+
+    /**
+     * @brief Looks up a position
+     * @param t_position Position to look up
+     * @return Result for the side to move, MISSING if the table doesnt cover it
+     */
+    TablebaseResult probe(const Position& t_position);
+
+    /**
+     * @brief Looks up a board
+     * @param t_board Board to look up
+     * @return Result for the side to move, MISSING if the table doesnt cover it (or its block is corrupt)
+     */
+    TablebaseResult probe(const TablebaseBoard& t_board);
+
+    /**
+     * @brief Sets how much memory compressed tables keep decompressed, emptying the cache
+     * @param t_megabytes Cache size in MB, at least one block is always kept
+     *
+     * Nothing is allocated until a compressed table is open. On top of the
+     * cache there are 4 bytes for every block in the table (about 6MB for
+     * the full game) to find a block's place in it
+     */
+    void setCacheSize(int t_megabytes);
+
+    int getCacheSizeMB() const { return m_cacheMegabytes; }
+    const CacheStats& getCacheStats() const { return m_stats; }
+    void resetCacheStats() { m_stats = CacheStats(); }
+
+    bool isOpen() const { return m_file.isOpen(); }
+    bool isCompressed() const { return m_blockValues != 0; }
+    std::uint64_t getSize() const { return isOpen() ? m_index.getSize() : 0; }
+    const PieceSet& getPieceSet() const { return m_index.getPieceSet(); }
+
+    /**
+     * @brief Builds the header for a table
+     * @param t_index Index the table is laid out by
+     * @param t_solved True if every result is final
+     * @return Header ready to be written
+     */
+    static Header makeHeader(const TablebaseIndex& t_index, bool t_solved);
+
+    /**
+     * @brief Writes a compressed copy of a plain table
+     * @param t_inputPath Solved table written by the solver
+     * @param t_outputPath File to write, replaced only once it is complete
+     * @param t_threads Threads to compress with, 0 for one per core
+     * @return False if the input isnt a solved table or the output couldnt be written
+     *
+     * Undecided and stuck positions both become draws. Indexes that never
+     * get looked up (the gaps, and boards where someone already has a four)
+     * copy the index two before them, so they dont break up the runs
+     */
+    static bool compress(const std::string& t_inputPath, const std::string& t_outputPath, int t_threads);
+
+    /**
+     * @brief Checks a header and reads the piece set out of it
+     * @param t_header Header read from a file
+     * @param t_set Filled in with the piece set
+     * @return False if it isnt a tablebase header this version can read
+     */
+    static bool readHeader(const Header& t_header, PieceSet& t_set);
+
+    /**
+     * @brief Gets the number of bytes the values of a table take
+     * @param t_size Number of indexes
+     * @return Bytes after the header
+     */
+    static std::uint64_t getValueBytes(std::uint64_t t_size) { return (t_size + 3) / 4; }
+
+    /**
+     * @brief Reads one 2 bit value
+     * @param t_values Start of the values
+     * @param t_index Index to read
+     * @return VALUE_UNKNOWN, VALUE_WIN, VALUE_LOSS or VALUE_DRAW
+     */
+    static std::uint8_t getValue(const unsigned char* t_values, std::uint64_t t_index)
+    {
+        return (t_values[t_index >> 2] >> ((t_index & 3) * 2)) & 3;
+    }
+
+private:
+    /**
+     * @struct CacheSlot
+     * @brief One decompressed block in the cache, linked from newest to oldest use
+     */
+    struct CacheSlot
+    {
+        std::uint64_t block;    ///< Block held in the slot
+        int older;              ///< Slot used just before this one, -1 for the oldest
+        int newer;              ///< Slot used just after this one, -1 for the newest
+    };
+
+    MappedFile m_file;                  ///< The mapped table
+    const unsigned char* m_values;      ///< First byte after the header of a plain table, nullptr otherwise
+    TablebaseIndex m_index;             ///< Index for the table's piece set
+    std::uint32_t m_blockValues;        ///< Indexes per block of a compressed table, 0 for a plain one
+    std::uint64_t m_blockCount;         ///< Blocks in a compressed table
+    const std::uint64_t* m_offsets;     ///< Where each block starts in the file, then where the file ends
+
+    int m_cacheMegabytes;               ///< Cache size asked for
+    std::unique_ptr<unsigned char[]> m_cacheData;  ///< Decompressed blocks, one after another by slot
+    std::vector<CacheSlot> m_slots;     ///< What each slot holds
+    std::vector<std::int32_t> m_blockSlots;        ///< Slot holding each block, -1 if it isnt cached
+    int m_slotsUsed;                    ///< Slots filled so far, the rest are free
+    int m_newest;                       ///< Slot used last, -1 when empty
+    int m_oldest;                       ///< Slot to reuse next once every slot is filled
+    CacheStats m_stats;                 ///< Hits and misses since the last reset
+
+    /**
+     * @brief Sizes the cache for the open table and empties it
+     */
+    void resetCache();
+
+    /**
+     * @brief Gets a block of values, decompressing it into the cache if it isnt there
+     * @param t_block Block to get
+     * @return The block's 2 bit values, nullptr if it is corrupt
+     */
+    const unsigned char* getBlock(std::uint64_t t_block);
+
+    /**
+     * @brief Takes a slot out of the list of used slots
+     * @param t_slot Slot in the list
+     */
+    void unlinkSlot(int t_slot);
+
+    /**
+     * @brief Puts a slot on the newest end of the list
+     * @param t_slot Slot not in the list
+     */
+    void linkNewest(int t_slot);
+};
+
+#endif
@@ -0,0 +1,456 @@
+#include "TablebaseIndex.h"
+#include <array>
+#include <cctype>
+#include <limits>
+
+static const int MAX_GROUP_SIZE = MAX_DONKEYS_PER_PLAYER;
+
+// n choose k for every group size that can come up
+static constexpr std::array<std::array<std::uint64_t, MAX_GROUP_SIZE + 1>, NUM_SQUARES + 1> buildBinomials()
+{
+    std::array<std::array<std::uint64_t, MAX_GROUP_SIZE + 1>, NUM_SQUARES + 1> table{};
+    for (int n = 0; n <= NUM_SQUARES; ++n)
+    {
+        table[n][0] = 1;
+        for (int k = 1; k <= MAX_GROUP_SIZE; ++k)
+        {
+            table[n][k] = (n == 0) ? 0 : table[n - 1][k - 1] + table[n - 1][k];
+        }
+    }
+    return table;
+}
+
+static constexpr std::array<std::array<std::uint64_t, MAX_GROUP_SIZE + 1>, NUM_SQUARES + 1> BINOMIAL = buildBinomials();
+
+static const int MAX_ANCHOR_CODES = NUM_SQUARES * NUM_SQUARES;
+
+/**
+ * @struct AnchorTable
+ * @brief The canonical cells for one or two anchor pieces
+ *
+ * A code is the anchor's cell, or first * NUM_SQUARES + second for two.
+ * The canonical code is the lowest one any symmetry turns it into.
+ */
+struct AnchorTable
+{
+    int count;                                  ///< Number of canonical codes
+    std::array<int, MAX_ANCHOR_CODES> codes;    ///< Canonical codes in order
+    std::array<int, MAX_ANCHOR_CODES> slots;    ///< Place of each code in codes, -1 if it isnt canonical
+};
+
+static constexpr int transformAnchorCode(int t_code, int t_pieces, int t_symmetry)
+{
+    if (t_pieces == 1)
+    {
+        return SYMMETRY_SQUARES[t_symmetry][t_code];
+    }
+    return SYMMETRY_SQUARES[t_symmetry][t_code / NUM_SQUARES] * NUM_SQUARES + SYMMETRY_SQUARES[t_symmetry][t_code % NUM_SQUARES];
+}
+
+static constexpr AnchorTable buildAnchorTable(int t_pieces)
+{
+    AnchorTable table{};
+    int codes = (t_pieces == 1) ? NUM_SQUARES : NUM_SQUARES * NUM_SQUARES;
+
+    for (int code = 0; code < MAX_ANCHOR_CODES; ++code)
+    {
+        table.slots[code] = -1;
+    }
+    for (int code = 0; code < codes; ++code)
+    {
+        // two pieces cant share a cell
+        if (t_pieces == 2 && code / NUM_SQUARES == code % NUM_SQUARES)
+        {
+            continue;
+        }
+
+        bool canonical = true;
+        for (int symmetry = 1; symmetry < NUM_SYMMETRIES; ++symmetry)
+        {
+            canonical = canonical && transformAnchorCode(code, t_pieces, symmetry) >= code;
+        }
+        if (canonical)
+        {
+            table.slots[code] = table.count;
+            table.codes[table.count++] = code;
+        }
+    }
+
+    return table;
+}
+
+// 6 cells for one anchor, 85 pairs for two
+static constexpr AnchorTable ANCHOR_TABLES[3] = { AnchorTable{}, buildAnchorTable(1), buildAnchorTable(2) };
+
+// gets the nth free cell, counting up from cell 0
+static int getFreeSquare(Bitboard t_occupied, int t_n)
+{
+    Bitboard free = ~t_occupied & FULL_BOARD;
+    for (int i = 0; i < t_n; ++i)
+    {
+        free &= free - 1;
+    }
+    return std::countr_zero(free);
+}
+
+PieceSet PieceSet::fullGame()
+{
+    PieceSet set;
+    for (int player = 0; player < 2; ++player)
+    {
+        set.counts[player][0] = MAX_FROGS_PER_PLAYER;
+        set.counts[player][1] = MAX_SNAKES_PER_PLAYER;
+        set.counts[player][2] = MAX_DONKEYS_PER_PLAYER;
+    }
+    return set;
+}
+
+bool PieceSet::parse(const std::string& t_playerOne, const std::string& t_playerTwo, PieceSet& t_set)
+{
+    const std::string* letters[2] = { &t_playerOne, &t_playerTwo };
+    const int limits[TABLEBASE_TYPES] = { MAX_FROGS_PER_PLAYER, MAX_SNAKES_PER_PLAYER, MAX_DONKEYS_PER_PLAYER };
+
+    for (int player = 0; player < 2; ++player)
+    {
+        for (int type = 0; type < TABLEBASE_TYPES; ++type)
+        {
+            t_set.counts[player][type] = 0;
+        }
+
+        for (char letter : *letters[player])
+        {
+            switch (std::toupper(static_cast<unsigned char>(letter)))
+            {
+            case 'F':
+                t_set.counts[player][0]++;
+                break;
+            case 'S':
+                t_set.counts[player][1]++;
+                break;
+            case 'D':
+                t_set.counts[player][2]++;
+                break;
+            default:
+                return false;
+            }
+        }
+
+        for (int type = 0; type < TABLEBASE_TYPES; ++type)
+        {
+            if (t_set.counts[player][type] > limits[type])
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+std::string PieceSet::toString(int t_player) const
+{
+    const char letters[TABLEBASE_TYPES] = { 'F', 'S', 'D' };
+    std::string text;
+    for (int type = 0; type < TABLEBASE_TYPES; ++type)
+    {
+        text.append(counts[t_player][type], letters[type]);
+    }
+    return text;
+}
+
+bool PieceSet::operator==(const PieceSet& t_other) const
+{
+    for (int player = 0; player < 2; ++player)
+    {
+        for (int type = 0; type < TABLEBASE_TYPES; ++type)
+        {
+            if (counts[player][type] != t_other.counts[player][type])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+TablebaseBoard TablebaseBoard::fromPosition(const Position& t_position)
+{
+    TablebaseBoard board;
+    board.players[0] = t_position.getPlayerMask(Player::PLAYER_ONE);
+    board.players[1] = t_position.getPlayerMask(Player::PLAYER_TWO);
+    board.frogs = t_position.getTypeMask(PieceType::FROG);
+    board.snakes = t_position.getTypeMask(PieceType::SNAKE);
+    board.sideToMove = (t_position.getSideToMove() == Player::PLAYER_ONE) ? 0 : 1;
+    return board;
+}
+
+Bitboard TablebaseBoard::getGroup(int t_player, int t_type) const
+{
+    switch (t_type)
+    {
+    case 0:
+        return players[t_player] & frogs;
+    case 1:
+        return players[t_player] & snakes;
+    default:
+        return players[t_player] & getDonkeys();
+    }
+}
+
+PieceType TablebaseBoard::getPieceType(int t_square) const
+{
+    Bitboard bit = squareBit(t_square);
+    if (frogs & bit)
+    {
+        return PieceType::FROG;
+    }
+    return (snakes & bit) ? PieceType::SNAKE : PieceType::DONKEY;
+}
+
+TablebaseBoard TablebaseBoard::afterMove(int t_from, int t_to) const
+{
+    TablebaseBoard board = *this;
+    Bitboard change = squareBit(t_from) | squareBit(t_to);
+    int owner = (players[0] & squareBit(t_from)) ? 0 : 1;
+
+    board.players[owner] ^= change;
+    if (frogs & squareBit(t_from))
+    {
+        board.frogs ^= change;
+    }
+    if (snakes & squareBit(t_from))
+    {
+        board.snakes ^= change;
+    }
+    board.sideToMove = 1 - sideToMove;
+    return board;
+}
+
+TablebaseBoard TablebaseBoard::getTransformed(int t_symmetry) const
+{
+    TablebaseBoard board;
+    board.players[0] = transformBoard(players[0], t_symmetry);
+    board.players[1] = transformBoard(players[1], t_symmetry);
+    board.frogs = transformBoard(frogs, t_symmetry);
+    board.snakes = transformBoard(snakes, t_symmetry);
+    board.sideToMove = sideToMove;
+    return board;
+}
+
+TablebaseIndex::TablebaseIndex() :
+    TablebaseIndex(PieceSet::fullGame())
+{
+}
+
+TablebaseIndex::TablebaseIndex(const PieceSet& t_set) :
+    m_set(t_set),
+    m_groupCount(0),
+    m_anchorPieces(0),
+    m_size(2)
+{
+    for (int player = 0; player < 2; ++player)
+    {
+        for (int type = 0; type < TABLEBASE_TYPES; ++type)
+        {
+            if (m_set.counts[player][type] > 0)
+            {
+                Group& group = m_groups[m_groupCount++];
+                group.player = player;
+                group.type = type;
+                group.count = m_set.counts[player][type];
+            }
+        }
+    }
+
+    // up to two single pieces at the front are ranked together, up to symmetry
+    while (m_anchorPieces < 2 && m_anchorPieces < m_groupCount && m_groups[m_anchorPieces].count == 1)
+    {
+        m_anchorPieces++;
+    }
+
+    int freeSquares = NUM_SQUARES;
+    for (int i = 0; i < m_groupCount; ++i)
+    {
+        Group& group = m_groups[i];
+        if (i < m_anchorPieces)
+        {
+            // the first anchor's digit covers them all
+            group.radix = (i == 0) ? static_cast<std::uint64_t>(ANCHOR_TABLES[m_anchorPieces].count) : 1;
+        }
+        else
+        {
+            group.radix = BINOMIAL[freeSquares][group.count];
+        }
+
+        m_size *= group.radix;
+        freeSquares -= group.count;
+    }
+}
+
+bool TablebaseIndex::getIndex(const TablebaseBoard& t_board, std::uint64_t& t_index) const
+{
+    int total = 0;
+    for (int i = 0; i < m_groupCount; ++i)
+    {
+        const Group& group = m_groups[i];
+        if (popCount(t_board.getGroup(group.player, group.type)) != group.count)
+        {
+            return false;
+        }
+        total += group.count;
+    }
+    if (popCount(t_board.getOccupied()) != total || total == 0)
+    {
+        return false;
+    }
+
+    // only the symmetries that put the anchors on their canonical cells are worth ranking
+    std::uint8_t symmetries = 0xFF;
+    if (m_anchorPieces > 0)
+    {
+        int lowest = MAX_ANCHOR_CODES;
+        for (int symmetry = 0; symmetry < NUM_SYMMETRIES; ++symmetry)
+        {
+            int code = getAnchorCode(t_board, symmetry);
+            if (code < lowest)
+            {
+                lowest = code;
+                symmetries = 0;
+            }
+            if (code == lowest)
+            {
+                symmetries |= 1 << symmetry;
+            }
+        }
+    }
+
+    t_index = std::numeric_limits<std::uint64_t>::max();
+    for (int symmetry = 0; symmetry < NUM_SYMMETRIES; ++symmetry)
+    {
+        if (symmetries & (1 << symmetry))
+        {
+            std::uint64_t index = rank(symmetry == 0 ? t_board : t_board.getTransformed(symmetry));
+            if (index < t_index)
+            {
+                t_index = index;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool TablebaseIndex::getBoard(std::uint64_t t_index, TablebaseBoard& t_board) const
+{
+    if (t_index >= m_size || m_groupCount == 0)
+    {
+        return false;
+    }
+
+    t_board.sideToMove = static_cast<int>(t_index & 1);
+    std::uint64_t rest = t_index >> 1;
+
+    // peel the digits off from the last group
+    std::uint64_t digits[MAX_GROUPS];
+    for (int i = m_groupCount - 1; i >= 0; --i)
+    {
+        digits[i] = rest % m_groups[i].radix;
+        rest /= m_groups[i].radix;
+    }
+
+    t_board.players[0] = 0;
+    t_board.players[1] = 0;
+    t_board.frogs = 0;
+    t_board.snakes = 0;
+
+    int anchorCode = (m_anchorPieces > 0) ? ANCHOR_TABLES[m_anchorPieces].codes[digits[0]] : 0;
+    Bitboard occupied = 0;
+    for (int i = 0; i < m_groupCount; ++i)
+    {
+        const Group& group = m_groups[i];
+        Bitboard cells = 0;
+
+        if (i < m_anchorPieces)
+        {
+            // the first anchor is the high part of the code
+            int square = (m_anchorPieces == 1 || i == 1) ? anchorCode % NUM_SQUARES : anchorCode / NUM_SQUARES;
+            cells = squareBit(square);
+        }
+        else
+        {
+            // combination number system, biggest free cell first
+            std::uint64_t digit = digits[i];
+            for (int k = group.count; k >= 1; --k)
+            {
+                int n = k - 1;
+                while (BINOMIAL[n + 1][k] <= digit)
+                {
+                    n++;
+                }
+                digit -= BINOMIAL[n][k];
+                cells |= squareBit(getFreeSquare(occupied, n));
+            }
+        }
+
+        t_board.players[group.player] |= cells;
+        if (group.type == 0)
+        {
+            t_board.frogs |= cells;
+        }
+        else if (group.type == 1)
+        {
+            t_board.snakes |= cells;
+        }
+        occupied |= cells;
+    }
+
+    // another mirror image of the board might have the lower index
+    std::uint64_t canonical;
+    return getIndex(t_board, canonical) && canonical == t_index;
+}
+
+int TablebaseIndex::getAnchorCode(const TablebaseBoard& t_board, int t_symmetry) const
+{
+    int code = 0;
+    for (int i = 0; i < m_anchorPieces; ++i)
+    {
+        int square = std::countr_zero(t_board.getGroup(m_groups[i].player, m_groups[i].type));
+        code = code * NUM_SQUARES + SYMMETRY_SQUARES[t_symmetry][square];
+    }
+    return code;
+}
+
+std::uint64_t TablebaseIndex::rank(const TablebaseBoard& t_board) const
+{
+    std::uint64_t index = 0;
+    Bitboard occupied = 0;
+
+    for (int i = 0; i < m_groupCount; ++i)
+    {
+        const Group& group = m_groups[i];
+        Bitboard cells = t_board.getGroup(group.player, group.type);
+        std::uint64_t digit = 0;
+
+        if (i == 0 && m_anchorPieces > 0)
+        {
+            digit = static_cast<std::uint64_t>(ANCHOR_TABLES[m_anchorPieces].slots[getAnchorCode(t_board, 0)]);
+        }
+        else if (i >= m_anchorPieces)
+        {
+            // each cell counts as its position among the cells still free
+            Bitboard free = ~occupied & FULL_BOARD;
+            Bitboard pieces = cells;
+            int k = 1;
+            while (pieces)
+            {
+                int square = popLowest(pieces);
+                digit += BINOMIAL[popCount(free & (squareBit(square) - 1))][k++];
+            }
+        }
+
+        index = index * group.radix + digit;
+        occupied |= cells;
+    }
+
+    return index * 2 + static_cast<std::uint64_t>(t_board.sideToMove);
+}
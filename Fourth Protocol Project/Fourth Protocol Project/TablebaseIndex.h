@@ -0,0 +1,193 @@
+/**
+ * @file TablebaseIndex.h
+ * @brief Numbers every movement-phase position for the tablebase
+ * @authors: Kyle & Monika
+ *
+ * There are no captures, so once placement is over the same pieces are on
+ * the board for the rest of the game and the positions can be counted.
+ * Each group of identical pieces (player one's frog, their snake, their
+ * donkeys, then the same for player two) is ranked as a combination of the
+ * cells the earlier groups left free, and the ranks are put together as
+ * one mixed radix number with the side to move at the bottom. That numbers
+ * every position with no gaps apart from the symmetry ones below.
+ *
+ * Mirror images are taken out with the first one or two groups, if they
+ * are single pieces (player one's frog and snake in the real game). Their
+ * cells are ranked together as one of the 85 pairs left once mirror images
+ * count as the same (or one of the 6 cells for a single piece), so about an
+ * eighth of the positions need a number. When those pieces sit the same
+ * after more than one turn of the board, the lowest index over those turns
+ * is the canonical one and the others are never used.
+ */
+
+#ifndef TABLEBASE_INDEX_HPP
+#define TABLEBASE_INDEX_HPP
+
+#include <cstdint>
+#include <string>
+#include "Position.h"
+
+static const int TABLEBASE_TYPES = 3;   ///< Frog, snake and donkey, in that order
+
+/**
+ * @struct PieceSet
+ * @brief How many of each piece each player has on the board
+ *
+ * The real game is FSDDD against FSDDD, smaller sets are for testing
+ */
+struct PieceSet
+{
+    int counts[2][TABLEBASE_TYPES];     ///< Pieces by player and type (frog, snake, donkey)
+
+    /**
+     * @brief Gets the pieces every game reaches the movement phase with
+     * @return One frog, one snake and three donkeys each
+     */
+    static PieceSet fullGame();
+
+    /**
+     * @brief Reads a set written like "FSDDD" for each player
+     * @param t_playerOne Player one's pieces, one letter per piece
+     * @param t_playerTwo Player two's pieces
+     * @param t_set Filled in with the set
+     * @return False if a letter isnt F, S or D or there are too many of a piece
+     */
+    static bool parse(const std::string& t_playerOne, const std::string& t_playerTwo, PieceSet& t_set);
+
+    /**
+     * @brief Writes a player's pieces back out as letters
+     * @param t_player 0 for player one, 1 for player two
+     * @return Something like "FSDDD"
+     */
+    std::string toString(int t_player) const;
+
+    bool operator==(const PieceSet& t_other) const;
+};
+
+/**
+ * @struct TablebaseBoard
+ * @brief Just the masks of a movement-phase position
+ *
+ * Position keeps evaluation totals and hashes up to date on every change,
+ * which the solver has no use for, so it works on these instead
+ */
+struct TablebaseBoard
+{
+    Bitboard players[2];    ///< Cells owned by each player
+    Bitboard frogs;         ///< Cells holding a frog
+    Bitboard snakes;        ///< Cells holding a snake
+    int sideToMove;         ///< 0 for player one, 1 for player two
+
+    /**
+     * @brief Copies the pieces and side to move out of a position
+     * @param t_position Position to copy
+     * @return Board with the same pieces
+     */
+    static TablebaseBoard fromPosition(const Position& t_position);
+
+    Bitboard getOccupied() const { return players[0] | players[1]; }
+    Bitboard getDonkeys() const { return getOccupied() & ~frogs & ~snakes; }
+
+    /**
+     * @brief Gets the mask of one player's pieces of one type
+     * @param t_player 0 or 1
+     * @param t_type 0 frog, 1 snake, 2 donkey
+     * @return Mask of those pieces
+     */
+    Bitboard getGroup(int t_player, int t_type) const;
+
+    /**
+     * @brief Gets the type of the piece on a cell
+     * @param t_square Cell to look at, must hold a piece
+     * @return FROG, SNAKE or DONKEY
+     */
+    PieceType getPieceType(int t_square) const;
+
+    /**
+     * @brief Moves a piece, ignoring whose turn it is, then hands the turn over
+     * @param t_from Cell the piece is on
+     * @param t_to Empty cell to move it to
+     * @return The board after the move
+     */
+    TablebaseBoard afterMove(int t_from, int t_to) const;
+
+    /**
+     * @brief Gets the board with every mask turned the same way
+     * @param t_symmetry Symmetry to apply
+     * @return The mirrored board, same side to move
+     */
+    TablebaseBoard getTransformed(int t_symmetry) const;
+};
+
+/**
+ * @class TablebaseIndex
+ * @brief Turns boards into indexes and back for one piece set
+ */
+class TablebaseIndex
+{
+public:
+    TablebaseIndex();
+    explicit TablebaseIndex(const PieceSet& t_set);
+
+    /**
+     * @brief Gets how many indexes there are, gaps included
+     * @return One more than the highest index
+     */
+    std::uint64_t getSize() const { return m_size; }
+
+    const PieceSet& getPieceSet() const { return m_set; }
+
+    /**
+     * @brief Gets the canonical index of a board and all its mirror images
+     * @param t_board Board to number
+     * @param t_index Filled in with the index
+     * @return False if the board doesnt have exactly this piece set
+     */
+    bool getIndex(const TablebaseBoard& t_board, std::uint64_t& t_index) const;
+
+    /**
+     * @brief Builds the board an index stands for
+     * @param t_index Index to decode, below getSize()
+     * @param t_board Filled in with the board, in its canonical orientation
+     * @return False if the index is one of the gaps (its board has a lower index)
+     */
+    bool getBoard(std::uint64_t t_index, TablebaseBoard& t_board) const;
+
+private:
+    static const int MAX_GROUPS = 2 * TABLEBASE_TYPES;  ///< A group per player and piece type
+
+    /**
+     * @struct Group
+     * @brief Identical pieces that are ranked together
+     */
+    struct Group
+    {
+        int player;             ///< 0 or 1
+        int type;               ///< 0 frog, 1 snake, 2 donkey
+        int count;              ///< Pieces in the group
+        std::uint64_t radix;    ///< Ways the group can sit on the cells left free
+    };
+
+    PieceSet m_set;                 ///< Pieces this index is for
+    Group m_groups[MAX_GROUPS];     ///< Groups with at least one piece, in ranking order
+    int m_groupCount;               ///< Number of groups used
+    int m_anchorPieces;             ///< Leading single piece groups ranked together up to symmetry (0 to 2)
+    std::uint64_t m_size;           ///< Total number of indexes
+
+    /**
+     * @brief Gets the anchor pieces' cells packed into one number
+     * @param t_board Board to read
+     * @param t_symmetry Symmetry to look at the board through
+     * @return First anchor's cell, times NUM_SQUARES plus the second's if there are two
+     */
+    int getAnchorCode(const TablebaseBoard& t_board, int t_symmetry) const;
+
+    /**
+     * @brief Ranks a board exactly as it is, no symmetry applied
+     * @param t_board Board to rank, the anchors must already be in their canonical cells
+     * @return Index of the board
+     */
+    std::uint64_t rank(const TablebaseBoard& t_board) const;
+};
+
+#endif
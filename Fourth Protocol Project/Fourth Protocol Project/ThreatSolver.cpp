@@ -0,0 +1,159 @@
+#include "ThreatSolver.h"
+#include "MovePicker.h"
+#include <algorithm>
+
+ThreatSolver::ThreatSolver(std::uint64_t t_nodeBudget, int t_maxThreats) :
+    m_nodeBudget(t_nodeBudget),
+    m_maxThreats(t_maxThreats),
+    m_nodes(0),
+    m_attacker(Player::NONE),
+    m_defender(Player::NONE)
+{
+}
+
+bool ThreatSolver::findWin(Position& t_position, Move& t_move)
+{
+    m_nodes = 0;
+    if (t_position.getGameState() != GameState::MOVEMENT)
+    {
+        return false;
+    }
+
+    m_attacker = t_position.getSideToMove();
+    m_defender = (m_attacker == Player::PLAYER_ONE) ? Player::PLAYER_TWO : Player::PLAYER_ONE;
+    return attack(t_position, m_maxThreats, &t_move);
+}
+
+bool ThreatSolver::attack(Position& t_position, int t_threatsLeft, Move* t_move)
+{
+    if (!countNode())
+    {
+        return false;
+    }
+
+    Bitboard own = t_position.getPlayerMask(m_attacker);
+
+    // a four we can finish right now wins
+    if (t_position.canCompleteFour(m_attacker))
+    {
+        if (t_move)
+        {
+            Bitboard cells = getThreatCells(own, t_position.getEmptyMask());
+            Bitboard pieces = own;
+            while (pieces)
+            {
+                int from = popLowest(pieces);
+                Bitboard targets = t_position.getMoveTargets(from) & cells;
+                while (targets)
+                {
+                    int to = popLowest(targets);
+                    if (hasLineThrough((own & ~squareBit(from)) | squareBit(to), to))
+                    {
+                        *t_move = { from / GRID_SIZE, from % GRID_SIZE, to / GRID_SIZE, to % GRID_SIZE, WIN_SCORE };
+                        return true;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    if (t_threatsLeft == 0)
+    {
+        return false;
+    }
+
+    // every move that leaves a four to finish and doesnt hand them one, most open cells first
+    Move threats[MAX_MOVES];
+    int count = 0;
+    Bitboard pieces = own;
+    while (pieces)
+    {
+        int from = popLowest(pieces);
+        Bitboard targets = t_position.getMoveTargets(from);
+        while (targets)
+        {
+            int to = popLowest(targets);
+            Move move = { from / GRID_SIZE, from % GRID_SIZE, to / GRID_SIZE, to % GRID_SIZE, 0 };
+
+            t_position.make(move);
+            if (t_position.canCompleteFour(m_attacker) && !t_position.canCompleteFour(m_defender))
+            {
+                move.score = popCount(getThreatCells(t_position.getPlayerMask(m_attacker), t_position.getEmptyMask()));
+                threats[count++] = move;
+            }
+            t_position.unmake();
+        }
+    }
+
+    std::sort(threats, threats + count, [](const Move& a, const Move& b) { return a.score > b.score; });
+
+    for (int i = 0; i < count; ++i)
+    {
+        t_position.make(threats[i]);
+        bool won = defend(t_position, t_threatsLeft - 1);
+        t_position.unmake();
+
+        if (won)
+        {
+            if (t_move)
+            {
+                *t_move = threats[i];
+                t_move->score = WIN_SCORE;
+            }
+            return true;
+        }
+        if (m_nodes > m_nodeBudget)
+        {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool ThreatSolver::defend(Position& t_position, int t_threatsLeft)
+{
+    if (!countNode())
+    {
+        return false;
+    }
+
+    // they win first if they have a four of their own
+    if (t_position.canCompleteFour(m_defender))
+    {
+        return false;
+    }
+
+    bool hasMove = false;
+    Bitboard pieces = t_position.getPlayerMask(m_defender);
+    while (pieces)
+    {
+        int from = popLowest(pieces);
+        Bitboard targets = t_position.getMoveTargets(from);
+        while (targets)
+        {
+            int to = popLowest(targets);
+            hasMove = true;
+
+            t_position.make({ from / GRID_SIZE, from % GRID_SIZE, to / GRID_SIZE, to % GRID_SIZE, 0 });
+
+            // anything that doesnt stop the four loses on the spot, so only the stops need checking
+            bool lost = t_position.canCompleteFour(m_attacker) || attack(t_position, t_threatsLeft, nullptr);
+            t_position.unmake();
+
+            if (!lost)
+            {
+                return false;
+            }
+        }
+    }
+
+    // with no moves at all the game is stuck rather than lost
+    return hasMove;
+}
+
+bool ThreatSolver::countNode()
+{
+    return ++m_nodes <= m_nodeBudget;
+}
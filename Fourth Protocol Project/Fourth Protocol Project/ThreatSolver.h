@@ -0,0 +1,82 @@
+/**
+ * @file ThreatSolver.h
+ * @brief Looks for a forced win made only of threats
+ * @authors: Kyle & Monika
+ */
+
+#ifndef THREAT_SOLVER_HPP
+#define THREAT_SOLVER_HPP
+
+#include <cstdint>
+#include "Position.h"
+
+/**
+ * @class ThreatSolver
+ * @brief Threat-space search for forced four-in-a-row sequences
+ *
+ * Every attacking move has to leave the attacker able to finish a four
+ * next move (and not leave the defender able to), so the defender is
+ * always forced to answer. The defender gets every move that stops the
+ * four, and any win of their own ends the line. Because only forcing moves
+ * are tried, a win several moves deep takes a tiny fraction of the nodes
+ * a full-width search would, and a win it finds is a real one.
+ *
+ * The search gives up once its node budget runs out, so "not found" only
+ * means no win was proven.
+ */
+class ThreatSolver
+{
+public:
+    /**
+     * @brief Creates the solver
+     * @param t_nodeBudget Most positions to visit per solve
+     * @param t_maxThreats Most attacking moves in a sequence
+     */
+    ThreatSolver(std::uint64_t t_nodeBudget, int t_maxThreats);
+
+    /**
+     * @brief Looks for a forced win for the side to move
+     * @param t_position Position to solve (left as it was)
+     * @param t_move Filled in with the first move of the win if one is found
+     * @return True if a forced win was proven
+     */
+    bool findWin(Position& t_position, Move& t_move);
+
+    /**
+     * @brief Gets the number of positions visited by the last solve
+     * @return Node count
+     */
+    std::uint64_t getNodes() const { return m_nodes; }
+
+private:
+    std::uint64_t m_nodeBudget;     ///< Most positions to visit per solve
+    int m_maxThreats;               ///< Most attacking moves in a sequence
+    std::uint64_t m_nodes;          ///< Positions visited this solve
+    Player m_attacker;              ///< Side trying to win
+    Player m_defender;              ///< Side trying to hold
+
+    /**
+     * @brief Attacker to move, tries every move that makes a threat
+     * @param t_position Position to search
+     * @param t_threatsLeft Attacking moves still allowed
+     * @param t_move If not null, filled in with the winning move
+     * @return True if the attacker has a forced win
+     */
+    bool attack(Position& t_position, int t_threatsLeft, Move* t_move);
+
+    /**
+     * @brief Defender to move, tries every move that stops the threat
+     * @param t_position Position to search
+     * @param t_threatsLeft Attacking moves still allowed
+     * @return True if every defence still loses
+     */
+    bool defend(Position& t_position, int t_threatsLeft);
+
+    /**
+     * @brief Counts a visited position
+     * @return False once the node budget is used up
+     */
+    bool countNode();
+};
+
+#endif
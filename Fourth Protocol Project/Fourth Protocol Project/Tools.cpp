@@ -0,0 +1,389 @@
+#include "Tools.h"
+#include "ProofNumberSearch.h"
+#include "BatchEvaluation.h"
+#include "OpeningBook.h"
+#include "RetrogradeSolver.h"
+#include "MonteCarloSearch.h"
+#include "AI.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unordered_set>
+
+// reads an optional number argument, falling back when its missing or not a number
+static std::uint64_t readNumber(int t_argc, char* t_argv[], int t_index, std::uint64_t t_fallback)
+{
+    if (t_index >= t_argc)
+    {
+        return t_fallback;
+    }
+
+    char* end = nullptr;
+    unsigned long long value = std::strtoull(t_argv[t_index], &end, 10);
+    return (end != t_argv[t_index] && *end == '\0' && value > 0) ? value : t_fallback;
+}
+
+static int runProof(int t_argc, char* t_argv[])
+{
+    std::uint64_t megabytes = readNumber(t_argc, t_argv, 2, 1024);
+    std::uint64_t nodes = readNumber(t_argc, t_argv, 3, 100000000);
+
+    std::cout << "Proving the empty board with a " << megabytes << "MB table and " << nodes << " nodes" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    ProofNumberSearch search(megabytes);
+    Move move;
+    ProofResult result = search.solve(Position::startingPosition(), nodes, move);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    switch (result)
+    {
+    case ProofResult::WIN:
+        std::cout << "First player wins, placing type " << static_cast<int>(move.pieceType)
+            << " at " << move.toRow << "," << move.toCol << std::endl;
+        break;
+    case ProofResult::LOSS:
+        std::cout << "Second player wins" << std::endl;
+        break;
+    case ProofResult::UNKNOWN:
+        std::cout << "Not proven either way" << std::endl;
+        break;
+    }
+    std::cout << search.getNodes() << " nodes in " << elapsed << "ms" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+static int runEvaluationBenchmark(int t_argc, char* t_argv[])
+{
+    int count = static_cast<int>(readNumber(t_argc, t_argv, 2, 1 << 16));
+
+    // random boards with 5 pieces each, nobody has to have a legal history for the evaluation
+    std::mt19937 rng(2024);
+    PositionBatch batch;
+    for (int i = 0; i < count; ++i)
+    {
+        Bitboard pieces[2] = { 0, 0 };
+        for (int placed = 0; placed < 10; ++placed)
+        {
+            int square;
+            do
+            {
+                square = static_cast<int>(rng() % NUM_SQUARES);
+            } while ((pieces[0] | pieces[1]) & squareBit(square));
+            pieces[placed % 2] |= squareBit(square);
+        }
+        batch.playerOne.push_back(pieces[0]);
+        batch.playerTwo.push_back(pieces[1]);
+    }
+
+    std::cout << "Evaluating " << count << " positions, best level here is "
+        << BatchEvaluation::getLevelName(BatchEvaluation::getBestLevel()) << std::endl;
+
+    const SimdLevel levels[] = { SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2 };
+    std::vector<int> expected;
+    for (SimdLevel level : levels)
+    {
+        if (static_cast<int>(level) > static_cast<int>(BatchEvaluation::getBestLevel()))
+        {
+            std::cout << BatchEvaluation::getLevelName(level) << ": not supported" << std::endl;
+            continue;
+        }
+
+        // keep going for at least half a second so the timer means something
+        std::uint64_t evaluated = 0;
+        auto start = std::chrono::steady_clock::now();
+        double seconds = 0.0;
+        while (seconds < 0.5)
+        {
+            BatchEvaluation::evaluateBatch(batch, Player::PLAYER_ONE, level);
+            evaluated += count;
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        // every level has to agree with the scalar one
+        if (expected.empty())
+        {
+            expected = batch.scores;
+        }
+        bool matches = batch.scores == expected;
+
+        std::cout << BatchEvaluation::getLevelName(level) << ": " << static_cast<std::uint64_t>(evaluated / seconds)
+            << " positions/s" << (matches ? "" : " (scores DIFFER from scalar)") << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// everything the book builder carries through the opening tree
+struct BookBuilder
+{
+    AI ai;                                          // does the searching
+    std::vector<OpeningBook::Entry> entries;        // one per canonical position searched
+    std::unordered_set<std::uint64_t> searched;     // canonical hashes already in entries
+};
+
+// searches a position the AI has to move in, then every reply the other side could make to the book move
+static void addBookPosition(BookBuilder& t_builder, Position& t_position, int t_pliesLeft)
+{
+    if (t_pliesLeft <= 0 || t_position.getGameState() != GameState::PLACEMENT ||
+        !t_builder.searched.insert(t_position.getCanonicalKey()).second)
+    {
+        return;
+    }
+
+    Move best = t_builder.ai.searchPosition(t_position);
+    if (best.toRow == -1)
+    {
+        return;
+    }
+    t_builder.entries.push_back(OpeningBook::makeEntry(t_position, best, t_builder.ai.getLastDepth()));
+    std::cout << "\r" << t_builder.entries.size() << " positions" << std::flush;
+
+    t_position.make(best);
+    if (t_position.getGameState() == GameState::PLACEMENT)
+    {
+        MoveList replies;
+        t_builder.ai.getAllPossibleMoves(t_position, t_position.getSideToMove(), replies);
+        for (const Move& reply : replies)
+        {
+            t_position.make(reply);
+            addBookPosition(t_builder, t_position, t_pliesLeft - 2);
+            t_position.unmake();
+        }
+    }
+    t_position.unmake();
+}
+
+static int runBookBuilder(int t_argc, char* t_argv[])
+{
+    std::string path = (t_argc > 2) ? t_argv[2] : DEFAULT_BOOK_FILE;
+    int plies = static_cast<int>(readNumber(t_argc, t_argv, 3, 3));
+    int milliseconds = static_cast<int>(readNumber(t_argc, t_argv, 4, 1000));
+
+    std::cout << "Building a book of the first " << plies << " placements, " << milliseconds << "ms a position" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    BookBuilder builder;
+    builder.ai.closeOpeningBook();  // searchPosition never reads it, and it can be the file being rebuilt
+    builder.ai.setDifficulty(Difficulty::HARD);
+    builder.ai.setSearchBudget(milliseconds, 0);
+
+    // the AI could be either side, so the empty board and every first placement both need a move
+    Position position = Position::startingPosition();
+    addBookPosition(builder, position, plies);
+
+    MoveList firstMoves;
+    builder.ai.getAllPossibleMoves(position, position.getSideToMove(), firstMoves);
+    for (const Move& move : firstMoves)
+    {
+        position.make(move);
+        addBookPosition(builder, position, plies - 1);
+        position.unmake();
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::endl;
+    if (!OpeningBook::write(path, builder.entries))
+    {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Wrote " << builder.entries.size() << " positions to " << path << " in " << elapsed << "s" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+static int runSolver(int t_argc, char* t_argv[])
+{
+    std::string folder = (t_argc > 2) ? t_argv[2] : DEFAULT_TABLEBASE_FOLDER;
+    int threads = static_cast<int>(readNumber(t_argc, t_argv, 3, 0));
+
+    // smaller piece sets solve in seconds, handy for checking the solver
+    PieceSet set = PieceSet::fullGame();
+    if (t_argc > 5 && !PieceSet::parse(t_argv[4], t_argv[5], set))
+    {
+        std::cerr << "Pieces are written one letter each, like FSDDD (F frog, S snake, D donkey)" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    TablebaseIndex index(set);
+    std::cout << "Solving " << set.toString(0) << " against " << set.toString(1) << ": " << index.getSize() << " positions, "
+        << (Tablebase::getValueBytes(index.getSize()) >> 20) << "MB of results in " << folder << std::endl;
+
+    RetrogradeSolver solver(set, folder, threads);
+    if (!solver.run())
+    {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Wrote " << solver.getTablePath() << ", " << solver.getWins() << " wins and " << solver.getLosses()
+        << " losses for the side to move, the rest are draws" << std::endl;
+
+    // the game loads the compressed copy, the plain one is only needed to compress it again
+    std::string compressed = std::filesystem::path(solver.getTablePath()).replace_extension(".tbz").string();
+    if (!Tablebase::compress(solver.getTablePath(), compressed, threads))
+    {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Wrote " << compressed << ", " << (std::filesystem::file_size(compressed) >> 10) << "KB" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+static int runCompressor(int t_argc, char* t_argv[])
+{
+    std::string input = (t_argc > 2) ? t_argv[2] : std::filesystem::path(DEFAULT_TABLEBASE_FILE).replace_extension(".tb").string();
+    std::string output = (t_argc > 3) ? t_argv[3] : std::filesystem::path(input).replace_extension(".tbz").string();
+    int threads = static_cast<int>(readNumber(t_argc, t_argv, 4, 0));
+
+    auto start = std::chrono::steady_clock::now();
+    if (!Tablebase::compress(input, output, threads))
+    {
+        return EXIT_FAILURE;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::uintmax_t before = std::filesystem::file_size(input);
+    std::uintmax_t after = std::filesystem::file_size(output);
+    std::cout << "Compressed " << (before >> 10) << "KB to " << (after >> 10) << "KB (" << (100.0 * after / before) << "%) in "
+        << elapsed << "s" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+static int runMonteCarloBenchmark(int t_argc, char* t_argv[])
+{
+    int milliseconds = static_cast<int>(readNumber(t_argc, t_argv, 2, 2000));
+    int maxThreads = static_cast<int>(readNumber(t_argc, t_argv, 3, std::max(1u, std::thread::hardware_concurrency())));
+
+    Position position = Position::startingPosition();
+    AI ai;
+    MoveList moves;
+    ai.getAllPossibleMoves(position, position.getSideToMove(), moves);
+
+    std::cout << "Monte Carlo from the empty board for " << milliseconds << "ms, up to " << maxThreads << " threads" << std::endl;
+
+    // a fresh tree each time so no run starts with the last one's visits
+    double single = 0.0;
+    for (int threads = 1; ; threads = std::min(threads * 2, maxThreads))
+    {
+        MonteCarloSearch search(MONTE_CARLO_TREE_MB);
+        auto start = std::chrono::steady_clock::now();
+        Move move = search.search(position, moves, milliseconds, 0, threads);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double rate = search.getPlayouts() / seconds;
+        if (threads == 1)
+        {
+            single = rate;
+        }
+        std::cout << threads << " threads: " << static_cast<std::uint64_t>(rate) << " playouts/s, " << (rate / single) << "x, "
+            << search.getTreeSize() << " nodes, depth " << search.getMaxDepth() << ", picked type " << static_cast<int>(move.pieceType)
+            << " at " << move.toRow << "," << move.toCol << std::endl;
+
+        if (threads == maxThreads)
+            break;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static int runAllocationCheck(int t_argc, char* t_argv[])
+{
+    int plies = static_cast<int>(readNumber(t_argc, t_argv, 2, 30));
+    std::uint64_t nodes = readNumber(t_argc, t_argv, 3, 20000);
+
+    std::cout << "Playing " << plies << " plies against itself, " << nodes << " nodes a move" << std::endl;
+
+    // a node budget instead of a time one, so every run searches the same trees
+    AI ai;
+    ai.closeOpeningBook();
+    ai.setDifficulty(Difficulty::HARD);
+    ai.setSearchBudget(0, nodes);
+
+    // the search checks itself with a NoAllocationScope, so an allocation stops on its assert
+    // (the ply is printed first so the last one shown is the search that allocated)
+    Position position = Position::startingPosition();
+    for (int ply = 0; ply < plies && position.getGameState() != GameState::GAME_OVER; ++ply)
+    {
+        std::cout << "\rPly " << ply << std::flush;
+        Move move = ai.searchPosition(position);
+        if (move.toRow == -1)
+        {
+            break;
+        }
+        position.make(move);
+    }
+
+    std::cout << std::endl;
+#ifdef _DEBUG
+    std::cout << "No allocations" << std::endl;
+#else
+    std::cout << "Allocations are only counted in debug builds, nothing was checked" << std::endl;
+#endif
+    return EXIT_SUCCESS;
+}
+
+namespace Tools
+{
+    bool run(int t_argc, char* t_argv[], int& t_exitCode)
+    {
+        if (t_argc < 2)
+        {
+            return false;
+        }
+
+        if (std::strcmp(t_argv[1], "--prove") == 0)
+        {
+            t_exitCode = runProof(t_argc, t_argv);
+            return true;
+        }
+
+        if (std::strcmp(t_argv[1], "--bench-eval") == 0)
+        {
+            t_exitCode = runEvaluationBenchmark(t_argc, t_argv);
+            return true;
+        }
+
+        if (std::strcmp(t_argv[1], "--build-book") == 0)
+        {
+            t_exitCode = runBookBuilder(t_argc, t_argv);
+            return true;
+        }
+
+        if (std::strcmp(t_argv[1], "--solve") == 0)
+        {
+            t_exitCode = runSolver(t_argc, t_argv);
+            return true;
+        }
+
+        if (std::strcmp(t_argv[1], "--compress-tablebase") == 0)
+        {
+            t_exitCode = runCompressor(t_argc, t_argv);
+            return true;
+        }
+
+        if (std::strcmp(t_argv[1], "--bench-mcts") == 0)
+        {
+            t_exitCode = runMonteCarloBenchmark(t_argc, t_argv);
+            return true;
+        }
+
+        if (std::strcmp(t_argv[1], "--check-allocations") == 0)
+        {
+            t_exitCode = runAllocationCheck(t_argc, t_argv);
+            return true;
+        }
+
+        std::cerr << "Unknown option " << t_argv[1] << ", usage: --prove [hashMB] [nodes] | --bench-eval [positions]"
+            << " | --build-book [file] [plies] [ms] | --solve [folder] [threads] [playerOne playerTwo]"
+            << " | --compress-tablebase [input] [output] [threads] | --bench-mcts [ms] [threads]"
+            << " | --check-allocations [plies] [nodes]" << std::endl;
+        t_exitCode = EXIT_FAILURE;
+        return true;
+    }
+}
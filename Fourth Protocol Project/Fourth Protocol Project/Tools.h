@@ -0,0 +1,35 @@
+/**
+ * @file Tools.h
+ * @brief Command line modes for offline analysis
+ * @authors: Kyle & Monika
+ *
+ * Running the game with one of these as the first argument does the
+ * analysis in the console and exits instead of opening the window:
+ *   --prove [hashMB] [nodes]   proof-number search from the empty board
+ *   --bench-eval [positions]   batch evaluation speed for each SIMD level
+ *   --build-book [file] [plies] [ms]   searches the first placements and writes an opening book
+ *   --solve [folder] [threads] [playerOne playerTwo]   retrograde solves the movement phase
+ *       into a tablebase, carrying on from the checkpoint if it was stopped (pieces like FSDDD),
+ *       then writes the compressed copy the game loads
+ *   --compress-tablebase [input] [output] [threads]   compresses a solved table again
+ *   --bench-mcts [ms] [threads]   Monte Carlo playout speed on 1, 2, 4... threads up to the count given
+ *   --check-allocations [plies] [nodes]   plays fixed searches against itself, stopping on the
+ *       search's own no-allocation assert if one touches the heap (debug builds only, release doesnt check)
+ */
+
+#ifndef TOOLS_HPP
+#define TOOLS_HPP
+
+namespace Tools
+{
+    /**
+     * @brief Runs the tool named on the command line, if there is one
+     * @param t_argc Argument count from main
+     * @param t_argv Arguments from main
+     * @param t_exitCode Filled in with what main should return
+     * @return True if a tool ran and the game shouldnt start
+     */
+    bool run(int t_argc, char* t_argv[], int& t_exitCode);
+}
+
+#endif
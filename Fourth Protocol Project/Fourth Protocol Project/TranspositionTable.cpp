@@ -0,0 +1,135 @@
+#include "TranspositionTable.h"
+#include <algorithm>
+#include <cstring>
+
+static_assert(sizeof(TTEntry) == 12, "TTEntry should pack into 12 bytes");
+
+static const int PLACEMENT_SOURCE = 31;     // source cell used for placements
+
+std::uint16_t packMove(const Move& t_move)
+{
+    int from = (t_move.fromRow == -1) ? PLACEMENT_SOURCE : t_move.fromRow * GRID_SIZE + t_move.fromCol;
+    int to = t_move.toRow * GRID_SIZE + t_move.toCol;
+    int type = static_cast<int>(t_move.pieceType);
+
+    return static_cast<std::uint16_t>(0x8000 | (type << 10) | (from << 5) | to);
+}
+
+Move unpackMove(std::uint16_t t_packed)
+{
+    int to = t_packed & 31;
+    int from = (t_packed >> 5) & 31;
+    int type = (t_packed >> 10) & 3;
+
+    Move move;
+    move.fromRow = (from == PLACEMENT_SOURCE) ? -1 : from / GRID_SIZE;
+    move.fromCol = (from == PLACEMENT_SOURCE) ? -1 : from % GRID_SIZE;
+    move.toRow = to / GRID_SIZE;
+    move.toCol = to % GRID_SIZE;
+    move.score = 0;
+    move.pieceType = static_cast<PieceType>(type);
+    return move;
+}
+
+TranspositionTable::TranspositionTable(int t_megabytes) :
+    m_mask(0),
+    m_generation(0),
+    m_megabytes(0)
+{
+    resize(t_megabytes);
+}
+
+void TranspositionTable::resize(int t_megabytes)
+{
+    m_megabytes = std::max(1, t_megabytes);
+
+    // round down to a power of two so the index is a mask
+    std::uint64_t bucketCount = 1;
+    std::uint64_t maxBuckets = (static_cast<std::uint64_t>(m_megabytes) << 20) / sizeof(Bucket);
+    while (bucketCount * 2 <= maxBuckets)
+    {
+        bucketCount *= 2;
+    }
+
+    m_buckets.assign(static_cast<size_t>(bucketCount), Bucket());
+    m_mask = bucketCount - 1;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    std::memset(static_cast<void*>(m_buckets.data()), 0, m_buckets.size() * sizeof(Bucket));
+    m_generation = 0;
+    resetStats();
+}
+
+void TranspositionTable::newSearch()
+{
+    m_generation = (m_generation + 1) & 63;
+}
+
+bool TranspositionTable::probe(std::uint64_t t_key, TTEntry& t_entry)
+{
+    m_stats.probes++;
+
+    std::uint32_t check = static_cast<std::uint32_t>(t_key >> 32);
+    Bucket& bucket = getBucket(t_key);
+
+    for (TTEntry& entry : bucket.entries)
+    {
+        if (entry.check == check && entry.getBound() != Bound::NONE)
+        {
+            // still useful this search, so keep it from being replaced
+            entry.genBound = static_cast<std::uint8_t>((m_generation << 2) | (entry.genBound & 3));
+            t_entry = entry;
+            m_stats.hits++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TranspositionTable::store(std::uint64_t t_key, int t_score, int t_depth, Bound t_bound, std::uint16_t t_move)
+{
+    m_stats.stores++;
+
+    std::uint32_t check = static_cast<std::uint32_t>(t_key >> 32);
+    Bucket& bucket = getBucket(t_key);
+    TTEntry* replace = &bucket.entries[0];
+
+    for (TTEntry& entry : bucket.entries)
+    {
+        if (entry.getBound() == Bound::NONE || entry.check == check)
+        {
+            // same position: keep the old best move if we dont have one
+            if (entry.check == check && t_move == 0)
+            {
+                t_move = entry.move;
+            }
+            replace = &entry;
+            break;
+        }
+
+        // otherwise replace the shallowest entry, counting old searches as shallower
+        int age = (m_generation - entry.getGeneration()) & 63;
+        int replaceAge = (m_generation - replace->getGeneration()) & 63;
+        if (entry.depth - 4 * age < replace->depth - 4 * replaceAge)
+        {
+            replace = &entry;
+        }
+    }
+
+    // dont let a shallow search wipe out a deeper one for the same position
+    if (replace->check == check && replace->getBound() != Bound::NONE &&
+        t_bound != Bound::EXACT && t_depth < replace->depth)
+    {
+        return;
+    }
+
+    replace->check = check;
+    replace->score = t_score;
+    replace->move = t_move;
+    replace->depth = static_cast<std::int8_t>(t_depth);
+    replace->genBound = static_cast<std::uint8_t>((m_generation << 2) | static_cast<int>(t_bound));
+}
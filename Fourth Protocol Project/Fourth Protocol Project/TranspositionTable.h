@@ -0,0 +1,156 @@
+/**
+ * @file TranspositionTable.h
+ * @brief Fixed size hash table of search results for the AI
+ * @authors: Kyle & Monika
+ */
+
+#ifndef TRANSPOSITION_TABLE_HPP
+#define TRANSPOSITION_TABLE_HPP
+
+#include <cstdint>
+#include <vector>
+#include "Position.h"
+
+/**
+ * @enum Bound
+ * @brief What a stored score says about the real score
+ */
+enum class Bound : std::uint8_t
+{
+    NONE = 0,       ///< Empty entry
+    EXACT = 1,      ///< Score is exact
+    LOWER = 2,      ///< Real score is at least this (beta cutoff)
+    UPPER = 3       ///< Real score is at most this (failed low)
+};
+
+/**
+ * @brief Packs a move into 16 bits for storage
+ * @param t_move Move to pack
+ * @return Packed move, 0 means no move
+ *
+ * Bits 0-4 hold the destination, bits 5-9 the source (31 for a placement)
+ * and bits 10-11 the piece type. Bit 15 is set so that a real move is never 0.
+ */
+std::uint16_t packMove(const Move& t_move);
+
+/**
+ * @brief Unpacks a move stored with packMove()
+ * @param t_packed Packed move (not 0)
+ * @return The move, with a score of 0
+ */
+Move unpackMove(std::uint16_t t_packed);
+
+/**
+ * @struct TTEntry
+ * @brief One stored search result
+ */
+struct TTEntry
+{
+    std::uint32_t check;        ///< Upper half of the hash, to spot collisions
+    std::int32_t score;         ///< Score from the search
+    std::uint16_t move;         ///< Best move found (packed), 0 if none
+    std::int8_t depth;          ///< Remaining depth the score was searched to
+    std::uint8_t genBound;      ///< Search generation (top 6 bits) and Bound (low 2 bits)
+
+    Bound getBound() const { return static_cast<Bound>(genBound & 3); }
+    int getGeneration() const { return genBound >> 2; }
+};
+
+/**
+ * @class TranspositionTable
+ * @brief Remembers scores and best moves of positions already searched
+ *
+ * The table is an array of 64-byte buckets, so one lookup touches a single
+ * cache line. Each bucket holds a few entries; when a bucket is full the
+ * shallowest entry is replaced, and entries left over from earlier moves
+ * are replaced first. The size is set in megabytes.
+ */
+class TranspositionTable
+{
+public:
+    /**
+     * @struct Stats
+     * @brief Counters for sizing the table
+     */
+    struct Stats
+    {
+        std::uint64_t probes = 0;   ///< Lookups made
+        std::uint64_t hits = 0;     ///< Lookups that found the position
+        std::uint64_t cutoffs = 0;  ///< Hits whose score ended the search of that node
+        std::uint64_t stores = 0;   ///< Results written
+
+        double hitRate() const { return probes ? 100.0 * hits / probes : 0.0; }
+        double cutoffRate() const { return probes ? 100.0 * cutoffs / probes : 0.0; }
+    };
+
+    /**
+     * @brief Creates the table
+     * @param t_megabytes Size of the table in MB
+     */
+    explicit TranspositionTable(int t_megabytes);
+
+    /**
+     * @brief Changes the size of the table, clearing it
+     * @param t_megabytes New size in MB (at least 1)
+     */
+    void resize(int t_megabytes);
+
+    /**
+     * @brief Empties every entry and resets the stats
+     */
+    void clear();
+
+    /**
+     * @brief Starts a new search so older entries get replaced first
+     */
+    void newSearch();
+
+    /**
+     * @brief Looks up a position
+     * @param t_key Hash of the position
+     * @param t_entry Filled in with the stored entry on a hit
+     * @return True if the position was found
+     */
+    bool probe(std::uint64_t t_key, TTEntry& t_entry);
+
+    /**
+     * @brief Stores a search result
+     * @param t_key Hash of the position
+     * @param t_score Score found
+     * @param t_depth Remaining depth searched
+     * @param t_bound What kind of score it is
+     * @param t_move Best move found, 0 if none
+     */
+    void store(std::uint64_t t_key, int t_score, int t_depth, Bound t_bound, std::uint16_t t_move);
+
+    /**
+     * @brief Counts a probe whose score caused a cutoff
+     */
+    void recordCutoff() { m_stats.cutoffs++; }
+
+    const Stats& getStats() const { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+    int getSizeMB() const { return m_megabytes; }
+
+private:
+    static const int ENTRIES_PER_BUCKET = 5;    ///< 5 x 12 bytes fits a 64 byte line
+
+    /**
+     * @struct Bucket
+     * @brief One cache line worth of entries
+     */
+    struct alignas(64) Bucket
+    {
+        TTEntry entries[ENTRIES_PER_BUCKET];
+    };
+
+    std::vector<Bucket> m_buckets;      ///< The table itself
+    std::uint64_t m_mask;               ///< Bucket count - 1 (count is a power of two)
+    std::uint8_t m_generation;          ///< Current search number (6 bits)
+    int m_megabytes;                    ///< Size asked for in MB
+    Stats m_stats;                      ///< Probe counters
+
+    Bucket& getBucket(std::uint64_t t_key) { return m_buckets[t_key & m_mask]; }
+};
+
+#endif
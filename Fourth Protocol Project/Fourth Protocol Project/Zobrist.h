@@ -0,0 +1,101 @@
+/**
+ * @file Zobrist.h
+ * @brief Random keys used to hash positions for the transposition table
+ * @authors: Kyle & Monika
+ *
+ * A position's hash is the XOR of one key per piece (by owner, type and
+ * cell) plus a key when player two is to move. Moving a piece only XORs
+ * out the old cell and XORs in the new one, so the hash is kept up to date
+ * in make/unmake instead of being rebuilt.
+ */
+
+#ifndef ZOBRIST_HPP
+#define ZOBRIST_HPP
+
+#include <array>
+#include <cstdint>
+#include "Bitboard.h"
+#include "Symmetry.h"
+
+namespace Zobrist
+{
+    /**
+     * @brief One step of the splitmix64 generator
+     * @param t_state Generator state, moved on by one step
+     * @return Next random 64-bit value
+     */
+    constexpr std::uint64_t nextRandom(std::uint64_t& t_state)
+    {
+        t_state += 0x9E3779B97F4A7C15ULL;
+        std::uint64_t z = t_state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /// Number of keys: 2 owners x 4 piece types (NONE unused) x cells, then side to move, AI perspective and tablebase probing
+    static const int NUM_KEYS = 2 * 4 * NUM_SQUARES + 3;
+
+    /**
+     * @brief Fills the key table from a fixed seed
+     * @return All of the keys, pieces first
+     */
+    constexpr std::array<std::uint64_t, NUM_KEYS> buildKeys()
+    {
+        std::array<std::uint64_t, NUM_KEYS> keys{};
+        std::uint64_t state = 0x46524F4750524F54ULL; // fixed so hashes match between runs
+        for (auto& key : keys)
+        {
+            key = nextRandom(state);
+        }
+        return keys;
+    }
+
+    inline constexpr std::array<std::uint64_t, NUM_KEYS> KEYS = buildKeys();
+
+    /**
+     * @brief Gets the key for a piece on a cell
+     * @param t_owner 0 for player one, 1 for player two
+     * @param t_type Piece type as an int (1 to 3)
+     * @param t_square Cell index
+     * @return The piece's key
+     */
+    constexpr std::uint64_t pieceKey(int t_owner, int t_type, int t_square)
+    {
+        return KEYS[(t_owner * 4 + t_type) * NUM_SQUARES + t_square];
+    }
+
+    /**
+     * @brief Lays out each piece key's 8 mirror images side by side
+     * @return Keys indexed by [owner * 4 + type][cell][symmetry]
+     */
+    constexpr std::array<std::array<std::array<std::uint64_t, NUM_SYMMETRIES>, NUM_SQUARES>, 8> buildSymmetryKeys()
+    {
+        std::array<std::array<std::array<std::uint64_t, NUM_SYMMETRIES>, NUM_SQUARES>, 8> keys{};
+        for (int piece = 0; piece < 8; ++piece)
+        {
+            for (int square = 0; square < NUM_SQUARES; ++square)
+            {
+                for (int symmetry = 0; symmetry < NUM_SYMMETRIES; ++symmetry)
+                {
+                    keys[piece][square][symmetry] = KEYS[piece * NUM_SQUARES + SYMMETRY_SQUARES[symmetry][square]];
+                }
+            }
+        }
+        return keys;
+    }
+
+    /// pieceKey of the cell each symmetry moves a piece to, together so all 8 hashes update in one go
+    inline constexpr std::array<std::array<std::array<std::uint64_t, NUM_SYMMETRIES>, NUM_SQUARES>, 8> SYMMETRY_KEYS = buildSymmetryKeys();
+
+    /// XORed in while player two is to move
+    inline constexpr std::uint64_t SIDE_KEY = KEYS[NUM_KEYS - 3];
+
+    /// XORed in by the AI when it searches as player two, since scores are from its point of view
+    inline constexpr std::uint64_t PERSPECTIVE_KEY = KEYS[NUM_KEYS - 2];
+
+    /// XORed in by the AI when its search looks up the tablebase, since those scores dont find the four
+    inline constexpr std::uint64_t TABLEBASE_KEY = KEYS[NUM_KEYS - 1];
+}
+
+#endif
@@ -14,9 +14,17 @@
 
 #include <iostream>
 #include "Game.h"
+#include "Tools.h"
 
-int main()
+int main(int argc, char* argv[])
 {
+	// offline analysis runs in the console without opening the window
+	int exitCode;
+	if (Tools::run(argc, argv, exitCode))
+	{
+		return exitCode;
+	}
+
 	Game game;
 	game.run();
 